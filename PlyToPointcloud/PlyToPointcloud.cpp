@@ -59,7 +59,7 @@ void PlyToPointcloud(const std::string& plyfile)
 		std::vector<PlyVertex> plyVertices(count);
 
 		// Fill each vertex with its data
-		for (int i = 0; i < count; i++)
+		for (size_t i = 0; i < count; i++)
 		{
 			std::memcpy(&plyVertices[i].position, rawPositions->buffer.get() + i * stridePositions, stridePositions);
 			std::memcpy(&plyVertices[i].normal, rawNormals->buffer.get() + i * strideNormals, strideNormals);
@@ -75,7 +75,7 @@ void PlyToPointcloud(const std::string& plyfile)
 		Vector3 maxPosition = minPosition;
 
 		// Also calculate center and size of the bounding cube that fully encloses the point cloud
-		for (UINT i = 0; i < count; i++)
+		for (size_t i = 0; i < count; i++)
 		{
 			// Only add vertices with a non zero normal
 			if (plyVertices[i].normal.LengthSquared() > 0.5f)
@@ -113,9 +113,15 @@ void PlyToPointcloud(const std::string& plyfile)
 		// Write the bounding cube size
 		pointcloudFile.write((char*)&boundingCubeSize, sizeof(float));
 
-		// Write the size of the vector
-		UINT vertexCount = pointcloudVertices.size();
-		pointcloudFile.write((char*)&vertexCount, sizeof(UINT));
+		// Write the size of the vector, larger counts store the marker 0xffffffff followed by the 64 bit count
+		UINT64 vertexCount = pointcloudVertices.size();
+		UINT vertexCountUINT = (vertexCount < UINT_MAX) ? (UINT)vertexCount : UINT_MAX;
+		pointcloudFile.write((char*)&vertexCountUINT, sizeof(UINT));
+
+		if (vertexCountUINT == UINT_MAX)
+		{
+			pointcloudFile.write((char*)&vertexCount, sizeof(UINT64));
+		}
 
 		// Write the vertices data in binary format
 		pointcloudFile.write((char*)pointcloudVertices.data(), vertexCount * sizeof(PointcloudVertex));
@@ -144,8 +150,15 @@ void PointcloudToPly(std::string pointcloudfile)
 		file.ignore(sizeof(Vector3) + sizeof(float));
 
 		// Load the size of the vertices vector
-		UINT vertexCount;
-		file.read((char*)&vertexCount, sizeof(UINT));
+		UINT vertexCountUINT;
+		UINT64 vertexCount;
+		file.read((char*)&vertexCountUINT, sizeof(UINT));
+		vertexCount = vertexCountUINT;
+
+		if (vertexCountUINT == UINT_MAX)
+		{
+			file.read((char*)&vertexCount, sizeof(UINT64));
+		}
 
 		// Read the binary data directly into the vertices vector
 		std::vector<PointcloudVertex> pointcloudVertices(vertexCount);
@@ -154,7 +167,7 @@ void PointcloudToPly(std::string pointcloudfile)
 		// Convert to .ply vertices
 		std::vector<PlyVertex> plyVertices(vertexCount);
 
-		for (UINT i = 0; i < vertexCount; i++)
+		for (size_t i = 0; i < vertexCount; i++)
 		{
 			plyVertices[i].position = pointcloudVertices[i].position;
 			plyVertices[i].normal.x = pointcloudVertices[i].normal[0] / 127.0f;
@@ -185,7 +198,7 @@ void PointcloudToPly(std::string pointcloudfile)
 		plyfile << "end_header" << std::endl;
 
 		// Write the vertices data in binary format
-		for (int i = 0; i < vertexCount; i++)
+		for (size_t i = 0; i < vertexCount; i++)
 		{
 			plyfile.write((char*)&plyVertices[i].position, sizeof(Vector3));
 			plyfile.write((char*)&plyVertices[i].normal, sizeof(Vector3));
@@ -0,0 +1,977 @@
+#include "Benchmark.h"
+
+#ifdef POINTCLOUDENGINE_COUNT_ALLOCATIONS
+static std::atomic<UINT64> allocationCount(0);
+
+// Replaces the global operator new to count the allocations, only defined in benchmark builds because it affects the whole program
+// The array forms of the MSVC runtime forward to these two, other runtimes may need their own replacements to count them as well
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	void *memory = malloc((size > 0) ? size : 1);
+
+	if (memory == NULL)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+	free(memory);
+}
+#endif
+
+// Object space view frustum of a camera at the position that looks at the target, computed the same way as in the octree renderer
+static PointCloudEngine::OctreeConstantBuffer GetLookAtConstantBuffer(const Vector3 &position, const Vector3 &target)
+{
+	Vector3 forward = target - position;
+	forward.Normalize();
+	Vector3 right = Vector3::UnitY.Cross(forward);
+	right.Normalize();
+	Vector3 up = forward.Cross(right);
+
+	float tanHalfFov = tan(settings->fovAngleY / 2.0f);
+	float aspect = (float)settings->resolutionX / settings->resolutionY;
+
+	auto GetCorner = [&](float distance, float x, float y)
+	{
+		return position + forward * distance + right * (x * tanHalfFov * aspect * distance) + up * (y * tanHalfFov * distance);
+	};
+
+	Vector3 localViewFrustum[8] =
+	{
+		GetCorner(settings->nearZ, -1, 1),
+		GetCorner(settings->nearZ, 1, 1),
+		GetCorner(settings->nearZ, -1, -1),
+		GetCorner(settings->nearZ, 1, -1),
+		GetCorner(settings->farZ, -1, 1),
+		GetCorner(settings->farZ, 1, 1),
+		GetCorner(settings->farZ, -1, -1),
+		GetCorner(settings->farZ, 1, -1)
+	};
+
+	PointCloudEngine::OctreeConstantBuffer octreeConstantBufferData;
+	ZeroMemory(&octreeConstantBufferData, sizeof(PointCloudEngine::OctreeConstantBuffer));
+	octreeConstantBufferData.useCulling = true;
+	octreeConstantBufferData.level = -1;
+	octreeConstantBufferData.fovAngleY = settings->fovAngleY;
+	octreeConstantBufferData.splatResolution = settings->splatResolution;
+	octreeConstantBufferData.localCameraPosition = position;
+	octreeConstantBufferData.localViewFrustumNearTopLeft = localViewFrustum[0];
+	octreeConstantBufferData.localViewFrustumNearTopRight = localViewFrustum[1];
+	octreeConstantBufferData.localViewFrustumNearBottomLeft = localViewFrustum[2];
+	octreeConstantBufferData.localViewFrustumNearBottomRight = localViewFrustum[3];
+	octreeConstantBufferData.localViewFrustumFarTopLeft = localViewFrustum[4];
+	octreeConstantBufferData.localViewFrustumFarTopRight = localViewFrustum[5];
+	octreeConstantBufferData.localViewFrustumFarBottomLeft = localViewFrustum[6];
+	octreeConstantBufferData.localViewFrustumFarBottomRight = localViewFrustum[7];
+	octreeConstantBufferData.localViewPlaneNearNormal = (localViewFrustum[1] - localViewFrustum[0]).Cross(localViewFrustum[2] - localViewFrustum[0]);
+	octreeConstantBufferData.localViewPlaneFarNormal = (localViewFrustum[7] - localViewFrustum[6]).Cross(localViewFrustum[4] - localViewFrustum[6]);
+	octreeConstantBufferData.localViewPlaneLeftNormal = (localViewFrustum[0] - localViewFrustum[4]).Cross(localViewFrustum[6] - localViewFrustum[4]);
+	octreeConstantBufferData.localViewPlaneRightNormal = (localViewFrustum[3] - localViewFrustum[7]).Cross(localViewFrustum[5] - localViewFrustum[7]);
+	octreeConstantBufferData.localViewPlaneTopNormal = (localViewFrustum[4] - localViewFrustum[0]).Cross(localViewFrustum[1] - localViewFrustum[0]);
+	octreeConstantBufferData.localViewPlaneBottomNormal = (localViewFrustum[3] - localViewFrustum[2]).Cross(localViewFrustum[6] - localViewFrustum[2]);
+	octreeConstantBufferData.localViewPlaneNearNormal.Normalize();
+	octreeConstantBufferData.localViewPlaneFarNormal.Normalize();
+	octreeConstantBufferData.localViewPlaneLeftNormal.Normalize();
+	octreeConstantBufferData.localViewPlaneRightNormal.Normalize();
+	octreeConstantBufferData.localViewPlaneTopNormal.Normalize();
+	octreeConstantBufferData.localViewPlaneBottomNormal.Normalize();
+
+	return octreeConstantBufferData;
+}
+
+// Byte wise order of the vertices, only used to compare the vertices of traversals with different orders
+static bool CompareVertices(const PointCloudEngine::OctreeNodeVertex &a, const PointCloudEngine::OctreeNodeVertex &b)
+{
+	return memcmp(&a, &b, sizeof(PointCloudEngine::OctreeNodeVertex)) < 0;
+}
+
+void PointCloudEngine::Benchmark::Log(const std::wstring &message)
+{
+	std::wofstream benchmarkFile(executableDirectory + BENCHMARK_FILENAME, std::ios::out | std::ios::app);
+
+	benchmarkFile << L"[" << time(0) << L"] " << message << std::endl;
+	benchmarkFile.flush();
+	benchmarkFile.close();
+
+	// Also show it in the debugger output
+	OutputDebugStringW((message + L"\n").c_str());
+}
+
+size_t PointCloudEngine::Benchmark::GetMemoryUsage()
+{
+	PROCESS_MEMORY_COUNTERS memoryCounters;
+	ZeroMemory(&memoryCounters, sizeof(memoryCounters));
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+	{
+		return memoryCounters.WorkingSetSize;
+	}
+
+	return 0;
+}
+
+size_t PointCloudEngine::Benchmark::GetPeakMemoryUsage()
+{
+	PROCESS_MEMORY_COUNTERS memoryCounters;
+	ZeroMemory(&memoryCounters, sizeof(memoryCounters));
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+	{
+		return memoryCounters.PeakWorkingSetSize;
+	}
+
+	return 0;
+}
+
+bool PointCloudEngine::Benchmark::IsAllocationCountAvailable()
+{
+#ifdef POINTCLOUDENGINE_COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+UINT64 PointCloudEngine::Benchmark::GetAllocationCount()
+{
+#ifdef POINTCLOUDENGINE_COUNT_ALLOCATIONS
+	return allocationCount.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+std::wstring PointCloudEngine::Benchmark::ToAllocationString(UINT64 allocationCount)
+{
+	return IsAllocationCountAvailable() ? (std::to_wstring(allocationCount) + L" allocations") : L"allocations not counted";
+}
+
+std::wstring PointCloudEngine::Benchmark::ToMegabytes(size_t bytes)
+{
+	std::wstringstream stream;
+	stream << std::fixed << std::setprecision(1) << (bytes / (1024.0 * 1024.0)) << L" MB";
+
+	return stream.str();
+}
+
+std::wstring PointCloudEngine::Benchmark::ToString(const OctreeBuildStatistics &buildStatistics)
+{
+	std::wstringstream stream;
+
+	stream << buildStatistics.vertexCount << L" vertices, ";
+	stream << buildStatistics.nodeCount << L" nodes, ";
+	stream << std::fixed << std::setprecision(3) << buildStatistics.seconds << L" s, ";
+	stream << L"memory before " << ToMegabytes(buildStatistics.memoryUsage) << L", ";
+	stream << L"peak memory " << ToMegabytes(buildStatistics.peakMemoryUsage) << L", ";
+	stream << ToAllocationString(buildStatistics.allocationCount);
+
+	return stream.str();
+}
+
+void PointCloudEngine::Benchmark::StartBuildStatistics(OctreeBuildStatistics &buildStatistics)
+{
+	buildStatistics.memoryUsage = GetMemoryUsage();
+	buildStatistics.allocationCount = GetAllocationCount();
+	buildStatistics.start = std::chrono::steady_clock::now();
+}
+
+void PointCloudEngine::Benchmark::FinishBuildStatistics(OctreeBuildStatistics &buildStatistics)
+{
+	buildStatistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStatistics.start).count();
+	buildStatistics.peakMemoryUsage = GetPeakMemoryUsage();
+	buildStatistics.allocationCount = GetAllocationCount() - buildStatistics.allocationCount;
+}
+
+void PointCloudEngine::Benchmark::LogBuildStatistics(const std::wstring &name, OctreeBuildMode buildMode, bool useBottomUpAggregation, const OctreeBuildStatistics &buildStatistics)
+{
+	Log(name + L" " + ToString(buildMode) + (useBottomUpAggregation ? L" bottom up" : L"") + L": " + ToString(buildStatistics));
+}
+
+std::wstring PointCloudEngine::Benchmark::ToString(const OctreeBuildMode &buildMode)
+{
+	switch (buildMode)
+	{
+		case OctreeBuildMode::TopDown:
+			return L"TopDown";
+		case OctreeBuildMode::Morton:
+			return L"Morton";
+	}
+
+	return L"Unknown";
+}
+
+PointCloudEngine::OctreeBuildParameters PointCloudEngine::Benchmark::GetBenchmarkBuildParameters()
+{
+	OctreeBuildParameters buildParameters = settings->GetOctreeBuildParameters();
+	buildParameters.usePaged = false;
+	buildParameters.useIncrementalTraversal = false;
+
+	return buildParameters;
+}
+
+void PointCloudEngine::Benchmark::BenchmarkOctreeBuilders(const std::wstring &pointcloudFile)
+{
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	std::vector<Vertex> vertices;
+	Vector3 rootPosition;
+	float rootSize;
+
+	if (!LoadPointcloudFile(vertices, rootPosition, rootSize, pointcloudFile, buildParameters.fileRead))
+	{
+		ERROR_MESSAGE(L"Could not load " + pointcloudFile);
+		return;
+	}
+
+	const int buildModeCount = 2;
+	OctreeBuildMode buildModes[buildModeCount] = { OctreeBuildMode::TopDown, OctreeBuildMode::Morton };
+	std::vector<OctreeNode> nodes[buildModeCount];
+
+	for (int i = 0; i < buildModeCount; i++)
+	{
+		// Every builder reorders the vertices, start each one from the loaded order
+		std::vector<Vertex> buildVertices = vertices;
+
+		OctreeBuildStatistics buildStatistics;
+		buildStatistics.vertexCount = buildVertices.size();
+		StartBuildStatistics(buildStatistics);
+
+		OctreeBuilder octreeBuilder(buildModes[i], buildParameters.useBottomUpAggregation, buildParameters.maxDepth, buildParameters.threadCount);
+		octreeBuilder.Build(nodes[i], buildVertices, rootPosition, rootSize);
+
+		buildStatistics.nodeCount = nodes[i].size();
+		FinishBuildStatistics(buildStatistics);
+		LogBuildStatistics(L"Octree build benchmark", buildModes[i], buildParameters.useBottomUpAggregation, buildStatistics);
+	}
+
+	// Both builders assign the vertices to the same cubes, therefore the topology has to match
+	// The node properties can differ slightly since the k-means clustering depends on the order of the vertices inside each node
+	if (nodes[0].size() != nodes[1].size())
+	{
+		Log(L"Octree build benchmark: the node counts are different");
+		return;
+	}
+
+	size_t differentTopology = 0;
+	size_t differentProperties = 0;
+
+	for (size_t i = 0; i < nodes[0].size(); i++)
+	{
+		const OctreeNode &a = nodes[0][i];
+		const OctreeNode &b = nodes[1][i];
+
+		if ((a.properties.childrenMask != b.properties.childrenMask) || (!a.IsLeafNode() && (a.childrenStartOrLeafPositionFactors != b.childrenStartOrLeafPositionFactors)))
+		{
+			differentTopology++;
+		}
+		else if (memcmp(&a, &b, sizeof(OctreeNode)) != 0)
+		{
+			differentProperties++;
+		}
+	}
+
+	Log(L"Octree build benchmark: " + std::to_wstring(differentTopology) + L" nodes with different children and " + std::to_wstring(differentProperties) + L" nodes with different properties out of " + std::to_wstring(nodes[0].size()));
+}
+
+void PointCloudEngine::Benchmark::BenchmarkNormalClustering(const std::wstring &pointcloudFile)
+{
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	std::vector<Vertex> vertices;
+	Vector3 rootPosition;
+	float rootSize;
+
+	if (!LoadPointcloudFile(vertices, rootPosition, rootSize, pointcloudFile, buildParameters.fileRead))
+	{
+		ERROR_MESSAGE(L"Could not load " + pointcloudFile);
+		return;
+	}
+
+	typedef int (*ClusterFunction)(const Vertex*, size_t, Vector3(&)[4], UINT(&)[4], byte*);
+
+	const int functionCount = 3;
+	ClusterFunction functions[functionCount] = { NormalClustering::ClusterReference, NormalClustering::ClusterScalar, NormalClustering::ClusterAVX2 };
+	std::wstring functionNames[functionCount] = { L"Reference", L"Scalar", L"AVX2" };
+	int usedFunctionCount = NormalClustering::IsAVX2Supported() ? functionCount : (functionCount - 1);
+
+	// Upper levels of the octree cluster large ranges, lower levels many small ones (at most 1M vertices per node size)
+	size_t nodeSizes[] = { vertices.size(), 1 << 20, 1 << 16, 1 << 12, 1 << 8, 1 << 4 };
+	byte *clusters = new byte[vertices.size()];
+
+	for (size_t nodeSize : nodeSizes)
+	{
+		if ((nodeSize == 0) || (nodeSize > vertices.size()))
+		{
+			continue;
+		}
+
+		size_t nodeCount = max((size_t)1, min(vertices.size(), (size_t)1 << 20) / nodeSize);
+		std::vector<ClusterNormal> referenceNormals(4 * nodeCount);
+		std::vector<byte> referenceWeights(4 * nodeCount);
+
+		for (int f = 0; f < usedFunctionCount; f++)
+		{
+			size_t iterations = 0;
+			size_t differentNormals = 0;
+			size_t differentWeights = 0;
+			auto start = std::chrono::steady_clock::now();
+			double seconds = 0;
+
+			for (size_t node = 0; node < nodeCount; node++)
+			{
+				const Vertex *nodeVertices = vertices.data() + node * nodeSize;
+				Vector3 means[4];
+				UINT verticesPerMean[4];
+
+				auto nodeStart = std::chrono::steady_clock::now();
+				iterations += functions[f](nodeVertices, nodeSize, means, verticesPerMean, clusters);
+				seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - nodeStart).count();
+
+				// Compare the quantized values that are stored in the octree nodes
+				for (int i = 0; i < 4; i++)
+				{
+					ClusterNormal normal = (verticesPerMean[i] > 0) ? ClusterNormal(means[i], 0) : ClusterNormal();
+					byte weight = (255.0f * verticesPerMean[i]) / nodeSize;
+
+					if (f == 0)
+					{
+						referenceNormals[4 * node + i] = normal;
+						referenceWeights[4 * node + i] = weight;
+					}
+					else
+					{
+						differentNormals += (normal.thetaPhiCone != referenceNormals[4 * node + i].thetaPhiCone) ? 1 : 0;
+						differentWeights += (weight != referenceWeights[4 * node + i]) ? 1 : 0;
+					}
+				}
+			}
+
+			std::wstringstream stream;
+			stream << L"Normal clustering benchmark " << functionNames[f] << L": " << nodeCount << L" nodes with " << nodeSize << L" vertices, ";
+			stream << std::fixed << std::setprecision(4) << seconds << L" s, " << std::setprecision(1) << (double)iterations / nodeCount << L" iterations per node, ";
+			stream << differentNormals << L" different normals and " << differentWeights << L" different weights out of " << 4 * nodeCount;
+			Log(stream.str());
+		}
+	}
+
+	delete[] clusters;
+}
+
+void PointCloudEngine::Benchmark::BenchmarkPropertyAggregation(const std::wstring &pointcloudFile)
+{
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	std::vector<Vertex> vertices;
+	Vector3 rootPosition;
+	float rootSize;
+
+	if (!LoadPointcloudFile(vertices, rootPosition, rootSize, pointcloudFile, buildParameters.fileRead))
+	{
+		ERROR_MESSAGE(L"Could not load " + pointcloudFile);
+		return;
+	}
+
+	std::vector<OctreeNode> nodes[2];
+
+	for (int i = 0; i < 2; i++)
+	{
+		std::vector<Vertex> buildVertices = vertices;
+
+		OctreeBuildStatistics buildStatistics;
+		buildStatistics.vertexCount = buildVertices.size();
+		StartBuildStatistics(buildStatistics);
+
+		OctreeBuilder octreeBuilder(buildParameters.buildMode, i == 1, buildParameters.maxDepth, buildParameters.threadCount);
+		octreeBuilder.Build(nodes[i], buildVertices, rootPosition, rootSize);
+
+		buildStatistics.nodeCount = nodes[i].size();
+		FinishBuildStatistics(buildStatistics);
+		LogBuildStatistics(L"Property aggregation benchmark", buildParameters.buildMode, i == 1, buildStatistics);
+	}
+
+	// Both builds have the same topology, compare the quantized properties of the inner nodes (the leaves are computed exactly in both cases)
+	// Each exact cluster is matched with the closest aggregated cluster since the order of the clusters can be different
+	size_t innerNodeCount = 0;
+	size_t clusterCount = 0;
+	double angleSum = 0;
+	double maxAngle = 0;
+	double coneSum = 0;
+	double colorSum = 0;
+	double weightSum = 0;
+
+	for (size_t i = 0; i < nodes[0].size(); i++)
+	{
+		OctreeNodeProperties exact = nodes[0][i].properties;
+		OctreeNodeProperties aggregated = nodes[1][i].properties;
+
+		if (nodes[0][i].IsLeafNode())
+		{
+			continue;
+		}
+
+		innerNodeCount++;
+
+		byte exactWeights[4] = { exact.weights[0], exact.weights[1], exact.weights[2], (byte)(255 - exact.weights[0] - exact.weights[1] - exact.weights[2]) };
+		byte aggregatedWeights[4] = { aggregated.weights[0], aggregated.weights[1], aggregated.weights[2], (byte)(255 - aggregated.weights[0] - aggregated.weights[1] - aggregated.weights[2]) };
+
+		for (int j = 0; j < 4; j++)
+		{
+			if (exact.normals[j].thetaPhiCone == 0)
+			{
+				continue;
+			}
+
+			Vector3 exactNormal = exact.normals[j].GetVector3();
+			float bestAngle = XM_PI;
+			int bestIndex = -1;
+
+			for (int k = 0; k < 4; k++)
+			{
+				if (aggregated.normals[k].thetaPhiCone != 0)
+				{
+					float angle = acos(max(-1.0f, min(1.0f, exactNormal.Dot(aggregated.normals[k].GetVector3()))));
+
+					if ((bestIndex < 0) || (angle < bestAngle))
+					{
+						bestAngle = angle;
+						bestIndex = k;
+					}
+				}
+			}
+
+			if (bestIndex < 0)
+			{
+				continue;
+			}
+
+			// Differences of the 6 bit red, 6 bit green and 4 bit blue values scaled to [0, 255]
+			USHORT exactColor = exact.colors[j].data;
+			USHORT aggregatedColor = aggregated.colors[bestIndex].data;
+			double colorDifference = abs((exactColor >> 10) - (aggregatedColor >> 10)) * (255.0 / 63.0);
+			colorDifference += abs(((exactColor >> 4) & 0x3f) - ((aggregatedColor >> 4) & 0x3f)) * (255.0 / 63.0);
+			colorDifference += abs((exactColor & 0xf) - (aggregatedColor & 0xf)) * (255.0 / 15.0);
+
+			clusterCount++;
+			angleSum += bestAngle;
+			maxAngle = max(maxAngle, (double)bestAngle);
+			coneSum += aggregated.normals[bestIndex].GetCone() - exact.normals[j].GetCone();
+			colorSum += colorDifference / 3.0;
+			weightSum += abs(exactWeights[j] - aggregatedWeights[bestIndex]) / 255.0;
+		}
+	}
+
+	std::wstringstream stream;
+	stream << L"Property aggregation benchmark: " << innerNodeCount << L" inner nodes, " << clusterCount << L" clusters, " << std::fixed << std::setprecision(2);
+	stream << L"normal error average " << XMConvertToDegrees(angleSum / max((size_t)1, clusterCount)) << L" degrees, max " << XMConvertToDegrees(maxAngle) << L" degrees, ";
+	stream << L"cone difference average " << XMConvertToDegrees(coneSum / max((size_t)1, clusterCount)) << L" degrees, ";
+	stream << L"color error average " << colorSum / max((size_t)1, clusterCount) << L" of 255, ";
+	stream << L"weight error average " << 100.0 * weightSum / max((size_t)1, clusterCount) << L"%";
+	Log(stream.str());
+}
+
+void PointCloudEngine::Benchmark::BenchmarkOctreeCompression(const std::wstring &pointcloudFile)
+{
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	std::vector<Vertex> vertices;
+	Vector3 rootPosition;
+	float rootSize;
+
+	if (!LoadPointcloudFile(vertices, rootPosition, rootSize, pointcloudFile, buildParameters.fileRead))
+	{
+		ERROR_MESSAGE(L"Could not load " + pointcloudFile);
+		return;
+	}
+
+	std::vector<OctreeNode> nodes;
+	OctreeBuilder octreeBuilder(buildParameters.buildMode, buildParameters.useBottomUpAggregation, buildParameters.maxDepth, buildParameters.threadCount);
+	octreeBuilder.Build(nodes, vertices, rootPosition, rootSize);
+	std::vector<Vertex>().swap(vertices);
+
+	CreateDirectory((executableDirectory + L"/Octrees").c_str(), NULL);
+	double rawSize = nodes.size() * sizeof(OctreeNode) / (1024.0 * 1024.0);
+	size_t rawFileSize = 0;
+
+	for (int i = 0; i < 2; i++)
+	{
+		bool compress = (i == 1);
+		std::wstring filename = executableDirectory + L"/Octrees/Benchmark" + (compress ? L"Compressed" : L"Raw") + L".octree";
+
+		auto writeStart = std::chrono::steady_clock::now();
+		bool written = OctreeFile::Write(filename, nodes.data(), nodes.size(), rootPosition, rootSize, compress, buildParameters.threadCount);
+		double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+
+		std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+		size_t fileSize = file.is_open() ? (size_t)file.tellg() : 0;
+		file.close();
+
+		// The file was just written and is most likely still in the page cache, the load throughput is not limited by the disk
+		// The raw nodes are copied out of the mapping in order to touch every page like the decompression does
+		std::vector<OctreeNode> loadedNodes;
+		auto loadStart = std::chrono::steady_clock::now();
+		OctreeFile octreeFile;
+		bool loaded = written && octreeFile.Open(filename, buildParameters.fileRead);
+
+		if (loaded && compress)
+		{
+			loaded = octreeFile.Decompress(loadedNodes, buildParameters.threadCount);
+		}
+		else if (loaded)
+		{
+			loadedNodes.assign(octreeFile.GetNodes(), octreeFile.GetNodes() + octreeFile.GetNodeCount());
+		}
+
+		double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+		octreeFile.Close();
+		DeleteFile(filename.c_str());
+
+		bool identical = loaded && (loadedNodes.size() == nodes.size()) && (memcmp(loadedNodes.data(), nodes.data(), nodes.size() * sizeof(OctreeNode)) == 0);
+		rawFileSize = compress ? rawFileSize : fileSize;
+
+		std::wstringstream stream;
+		stream << L"Octree compression benchmark " << (compress ? L"Compressed" : L"Raw") << L": " << nodes.size() << L" nodes, " << ToMegabytes(fileSize) << L", ";
+		stream << std::fixed << std::setprecision(2) << L"ratio " << (double)rawFileSize / max((size_t)1, fileSize) << L", ";
+		stream << std::setprecision(3) << L"write " << writeSeconds << L" s (" << std::setprecision(1) << rawSize / writeSeconds << L" MB/s), ";
+		stream << std::setprecision(3) << L"load " << loadSeconds << L" s (" << std::setprecision(1) << rawSize / loadSeconds << L" MB/s), ";
+		stream << (identical ? L"identical nodes" : L"different nodes");
+		Log(stream.str());
+	}
+}
+
+void PointCloudEngine::Benchmark::BenchmarkSuccinctOctree(const std::wstring &pointcloudFile)
+{
+	// The paged octree would replace both representations
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	buildParameters.useSuccinct = false;
+	Octree *octree = new Octree(pointcloudFile, buildParameters);
+	buildParameters.useSuccinct = true;
+	Octree *succinctOctree = new Octree(pointcloudFile, buildParameters);
+
+	size_t nodeCount = octree->GetNodeCount();
+	std::wstringstream stream;
+	stream << L"Succinct octree benchmark: " << nodeCount << L" nodes, " << std::fixed << std::setprecision(2);
+	stream << (double)octree->GetNodesMemoryUsage() / max((size_t)1, nodeCount) << L" bytes per node with the nodes array, ";
+	stream << (double)succinctOctree->GetNodesMemoryUsage() / max((size_t)1, nodeCount) << L" bytes per node with the succinct topology";
+	Log(stream.str());
+
+	// Traverse without culling while the camera moves from far away (few coarse nodes) towards the center of the root (many fine nodes)
+	OctreeConstantBuffer octreeConstantBufferData;
+	ZeroMemory(&octreeConstantBufferData, sizeof(OctreeConstantBuffer));
+	octreeConstantBufferData.useCulling = false;
+	octreeConstantBufferData.level = -1;
+	octreeConstantBufferData.fovAngleY = settings->fovAngleY;
+	octreeConstantBufferData.splatResolution = settings->splatResolution;
+
+	const int repetitions = 10;
+	std::vector<OctreeNodeVertex> vertices;
+	std::vector<OctreeNodeVertex> succinctVertices;
+
+	for (float distance = 4.0f; distance >= 0.5f; distance *= 0.5f)
+	{
+		octreeConstantBufferData.localCameraPosition = octree->rootPosition - Vector3(0, 0, distance * octree->rootSize);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			octree->GetVertices(octreeConstantBufferData, vertices);
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+		start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			succinctOctree->GetVertices(octreeConstantBufferData, succinctVertices);
+		}
+
+		double succinctSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+		bool identical = (vertices.size() == succinctVertices.size()) && (memcmp(vertices.data(), succinctVertices.data(), vertices.size() * sizeof(OctreeNodeVertex)) == 0);
+
+		std::wstringstream traversalStream;
+		traversalStream << L"Succinct octree traversal at distance " << std::fixed << std::setprecision(1) << distance << L": " << vertices.size() << L" vertices, ";
+		traversalStream << std::setprecision(3) << L"nodes array " << 1000.0 * seconds << L" ms, succinct topology " << 1000.0 * succinctSeconds << L" ms, ";
+		traversalStream << std::setprecision(2) << L"rank overhead " << 100.0 * (succinctSeconds / max(seconds, 1e-9) - 1.0) << L"%, ";
+		traversalStream << (identical ? L"identical vertices" : L"different vertices");
+		Log(traversalStream.str());
+	}
+
+	SafeDelete(octree);
+	SafeDelete(succinctOctree);
+}
+
+void PointCloudEngine::Benchmark::BenchmarkFileReadBackends(const std::wstring &pointcloudFile)
+{
+	// Random reads are sector sized and sector aligned so that they also work with unbuffered reads
+	const UINT randomReadSize = 4096;
+	const UINT randomReadBatchSize = 256;
+	const UINT randomReadCount = 16384;
+
+	std::ifstream file(pointcloudFile, std::ios::in | std::ios::binary | std::ios::ate);
+	UINT64 fileSize = file.is_open() ? (UINT64)file.tellg() : 0;
+	file.close();
+
+	if (fileSize < randomReadSize)
+	{
+		ERROR_MESSAGE(L"Could not load " + pointcloudFile);
+		return;
+	}
+
+	// Both backends read the same random offsets, without unbuffered reads the second run profits from the file cache
+	std::vector<UINT64> randomOffsets(randomReadCount);
+	std::mt19937_64 random(0);
+
+	for (auto it = randomOffsets.begin(); it != randomOffsets.end(); it++)
+	{
+		*it = (random() % (fileSize / randomReadSize)) * randomReadSize;
+	}
+
+	FileReadParameters fileReadParameters = GetBenchmarkBuildParameters().fileRead;
+	byte *randomBuffer = (byte*)_aligned_malloc((size_t)randomReadBatchSize * randomReadSize, randomReadSize);
+	FileReadBackendType backendTypes[] = { FileReadBackendType::Blocking, FileReadBackendType::Overlapped };
+
+	for (int i = 0; i < 2; i++)
+	{
+		ParallelFileReader reader(fileReadParameters.threadCount, fileReadParameters.unbuffered, backendTypes[i]);
+		bool sequentialRead = reader.Read(pointcloudFile, 0, fileSize, NULL);
+
+		// Each batch is submitted at once and waited for, the reads of a batch use separate parts of the buffer
+		IFileReadBackend *backend = ParallelFileReader::CreateBackend(backendTypes[i], fileReadParameters.threadCount);
+		std::atomic<UINT> failedReads = { 0 };
+		auto randomStart = std::chrono::steady_clock::now();
+
+		if (!backend->Open(pointcloudFile, fileReadParameters.unbuffered))
+		{
+			failedReads = randomReadCount;
+		}
+		else
+		{
+			for (UINT batchStart = 0; batchStart < randomReadCount; batchStart += randomReadBatchSize)
+			{
+				for (UINT j = 0; j < randomReadBatchSize; j++)
+				{
+					backend->QueueRead(randomOffsets[batchStart + j], randomReadSize, randomBuffer + (size_t)j * randomReadSize, [&](DWORD readBytes)
+					{
+						if (readBytes != randomReadSize)
+						{
+							failedReads++;
+						}
+					});
+				}
+
+				backend->Submit();
+				backend->Wait();
+			}
+
+			backend->Close();
+		}
+
+		double randomSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - randomStart).count();
+		std::wstring backendName = backend->GetName();
+		SafeDelete(backend);
+
+		std::wstringstream stream;
+		stream << L"File read backend benchmark " << backendName << L": sequential " << (sequentialRead ? reader.GetStatistics() : L"failed") << L", ";
+		stream << L"random " << randomReadCount << L" reads of " << randomReadSize << L" bytes in " << std::fixed << std::setprecision(3) << randomSeconds << L" s, ";
+		stream << std::setprecision(0) << randomReadCount / max(randomSeconds, 1e-9) << L" reads/s, " << std::setprecision(1) << randomReadCount * (randomReadSize / (1024.0 * 1024.0)) / max(randomSeconds, 1e-9) << L" MB/s";
+		stream << ((failedReads > 0) ? (L", " + std::to_wstring((UINT)failedReads) + L" failed reads") : L"");
+		Log(stream.str());
+	}
+
+	_aligned_free(randomBuffer);
+}
+
+void PointCloudEngine::Benchmark::BenchmarkParallelTraversal(const std::wstring &pointcloudFile)
+{
+	// The paged octree is always traversed by one thread since the pages are requested while traversing
+	// The incremental traversal would only update the cut instead of traversing the whole octree with the threads
+	Octree *octree = new Octree(pointcloudFile, GetBenchmarkBuildParameters());
+
+	UINT hardwareThreads = max(1u, std::thread::hardware_concurrency());
+	std::vector<UINT> threadCounts;
+
+	for (UINT threadCount = 1; threadCount < hardwareThreads; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+
+	threadCounts.push_back(hardwareThreads);
+
+	// Same camera path as the succinct octree benchmark, the closest distance has the widest levels
+	OctreeConstantBuffer octreeConstantBufferData;
+	ZeroMemory(&octreeConstantBufferData, sizeof(OctreeConstantBuffer));
+	octreeConstantBufferData.useCulling = false;
+	octreeConstantBufferData.level = -1;
+	octreeConstantBufferData.fovAngleY = settings->fovAngleY;
+	octreeConstantBufferData.splatResolution = settings->splatResolution;
+
+	const int repetitions = 10;
+	std::vector<OctreeNodeVertex> singleThreadedVertices;
+	std::vector<OctreeNodeVertex> vertices;
+
+	for (float distance = 4.0f; distance >= 0.5f; distance *= 0.5f)
+	{
+		octreeConstantBufferData.localCameraPosition = octree->rootPosition - Vector3(0, 0, distance * octree->rootSize);
+		double singleThreadedSeconds = 0;
+
+		for (auto it = threadCounts.begin(); it != threadCounts.end(); it++)
+		{
+			octree->SetTraversalThreadCount(*it);
+
+			// The first traversal grows the buffers of the ranges, it is not timed
+			octree->GetVertices(octreeConstantBufferData, vertices);
+
+			auto start = std::chrono::steady_clock::now();
+
+			for (int i = 0; i < repetitions; i++)
+			{
+				octree->GetVertices(octreeConstantBufferData, vertices);
+			}
+
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+
+			if (*it == 1)
+			{
+				singleThreadedSeconds = seconds;
+				singleThreadedVertices = vertices;
+			}
+
+			bool identical = (vertices.size() == singleThreadedVertices.size()) && (memcmp(vertices.data(), singleThreadedVertices.data(), vertices.size() * sizeof(OctreeNodeVertex)) == 0);
+
+			std::wstringstream stream;
+			stream << L"Parallel traversal at distance " << std::fixed << std::setprecision(1) << distance << L" with " << *it << L" threads: " << vertices.size() << L" vertices, ";
+			stream << std::setprecision(3) << 1000.0 * seconds << L" ms, speedup " << std::setprecision(2) << singleThreadedSeconds / max(seconds, 1e-9) << L"x, ";
+			stream << (identical ? L"identical vertices" : L"different vertices");
+			Log(stream.str());
+		}
+	}
+
+	SafeDelete(octree);
+}
+
+void PointCloudEngine::Benchmark::BenchmarkIncrementalTraversal(const std::wstring &pointcloudFile)
+{
+	// The cut needs the nodes array, the octree itself always traverses from the root for the comparison
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	buildParameters.useSuccinct = false;
+	Octree *octree = new Octree(pointcloudFile, buildParameters);
+
+	OctreeNodeTraversalEntry rootEntry;
+	rootEntry.index = 0;
+	rootEntry.position = octree->rootPosition;
+	rootEntry.size = octree->rootSize;
+	rootEntry.parentInsidePlanes = 0;
+	rootEntry.depth = 0;
+
+	// The camera circles around the octree and looks at a point that moves around the center, the speed is the angle per frame
+	const int frameCount = 200;
+	float angleSpeeds[3] = { 0.0005f, 0.005f, 0.05f };
+	std::vector<OctreeNodeVertex> vertices;
+	std::vector<OctreeNodeVertex> cutVertices;
+
+	for (int i = 0; i < 3; i++)
+	{
+		OctreeCut cut;
+		double seconds = 0;
+		double cutSeconds = 0;
+		size_t vertexCount = 0;
+		size_t evaluatedNodeCount = 0;
+		size_t reusedNodeCount = 0;
+		int differentFrames = 0;
+
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			float angle = angleSpeeds[i] * frame;
+			Vector3 position = octree->rootPosition + octree->rootSize * Vector3(1.5f * cos(angle), 0.25f * sin(2 * angle), 1.5f * sin(angle));
+			Vector3 target = octree->rootPosition + octree->rootSize * Vector3(0.1f * sin(3 * angle), 0, 0);
+			OctreeConstantBuffer octreeConstantBufferData = GetLookAtConstantBuffer(position, target);
+
+			auto start = std::chrono::steady_clock::now();
+			octree->GetVertices(octreeConstantBufferData, vertices);
+			auto cutStart = std::chrono::steady_clock::now();
+			const std::vector<OctreeNodeVertex> &updatedVertices = cut.Update(octree->GetNodes(), NULL, rootEntry, octreeConstantBufferData);
+			auto cutEnd = std::chrono::steady_clock::now();
+
+			// The vertices of the cut are kept for the next update, only the copy is sorted
+			cutVertices.assign(updatedVertices.begin(), updatedVertices.end());
+
+			// The first frame creates the cut from the root
+			if (frame > 0)
+			{
+				seconds += std::chrono::duration<double>(cutStart - start).count();
+				cutSeconds += std::chrono::duration<double>(cutEnd - cutStart).count();
+				vertexCount += vertices.size();
+				evaluatedNodeCount += cut.GetEvaluatedNodeCount();
+				reusedNodeCount += cut.GetReusedNodeCount();
+			}
+
+			// The full traversal is breadth first and the cut is depth first
+			std::sort(vertices.begin(), vertices.end(), CompareVertices);
+			std::sort(cutVertices.begin(), cutVertices.end(), CompareVertices);
+
+			if ((vertices.size() != cutVertices.size()) || (memcmp(vertices.data(), cutVertices.data(), vertices.size() * sizeof(OctreeNodeVertex)) != 0))
+			{
+				differentFrames++;
+			}
+		}
+
+		int measuredFrames = frameCount - 1;
+
+		std::wstringstream stream;
+		stream << L"Incremental traversal with " << std::fixed << std::setprecision(4) << angleSpeeds[i] << L" radians per frame: " << vertexCount / measuredFrames << L" vertices, ";
+		stream << std::setprecision(3) << L"full traversal " << 1000.0 * seconds / measuredFrames << L" ms, incremental " << 1000.0 * cutSeconds / measuredFrames << L" ms, ";
+		stream << evaluatedNodeCount / measuredFrames << L" evaluated and " << reusedNodeCount / measuredFrames << L" reused nodes per frame, ";
+		stream << differentFrames << L" of " << frameCount << L" frames with different vertices";
+		Log(stream.str());
+	}
+
+	SafeDelete(octree);
+}
+
+void PointCloudEngine::Benchmark::BenchmarkDecodeTables(const std::wstring &pointcloudFile)
+{
+	// The decode loops read the properties from the nodes array
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	buildParameters.useSuccinct = false;
+	Octree *octree = new Octree(pointcloudFile, buildParameters);
+
+	const OctreeNode *nodes = octree->GetNodes();
+	size_t nodeCount = octree->GetNodeCount();
+
+	// Normal, cone, cone sine (backface culling) and color of the 4 clusters of each node
+	std::vector<Vector3> normals[2];
+	std::vector<float> cones[2];
+	std::vector<float> coneSines[2];
+	std::vector<Vector3> colors[2];
+	double seconds[2];
+	const int repetitions = 10;
+
+	for (int i = 0; i < 2; i++)
+	{
+		normals[i].resize(4 * nodeCount);
+		cones[i].resize(4 * nodeCount);
+		coneSines[i].resize(4 * nodeCount);
+		colors[i].resize(4 * nodeCount);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int repetition = 0; repetition < repetitions; repetition++)
+		{
+			for (size_t j = 0; j < nodeCount; j++)
+			{
+				const OctreeNodeProperties &properties = nodes[j].properties;
+				size_t offset = 4 * j;
+
+				if (i == 0)
+				{
+					// Previous decode with sin, cos and divisions
+					for (int k = 0; k < 4; k++)
+					{
+						USHORT thetaPhiCone = properties.normals[k].thetaPhiCone;
+						USHORT color = properties.colors[k].data;
+						normals[i][offset + k] = DecodeTables::ComputeNormal(thetaPhiCone >> 4);
+						cones[i][offset + k] = DecodeTables::ComputeCone(thetaPhiCone & 0xf);
+						coneSines[i][offset + k] = sin(cones[i][offset + k]);
+						colors[i][offset + k] = Vector3((float)(255.0 * ((color >> 10) & 0x3f) / 63.0), (float)(255.0 * ((color >> 4) & 0x3f) / 63.0), (float)(255.0 * (color & 0xf) / 15.0));
+					}
+				}
+				else
+				{
+					ClusterNormal::Decode(properties.normals, 4, &normals[i][offset], &cones[i][offset]);
+					Color16::Decode(properties.colors, 4, &colors[i][offset]);
+
+					for (int k = 0; k < 4; k++)
+					{
+						coneSines[i][offset + k] = properties.normals[k].GetConeSine();
+					}
+				}
+			}
+		}
+
+		seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+	}
+
+	size_t count = 4 * nodeCount;
+	bool identical = (memcmp(normals[0].data(), normals[1].data(), count * sizeof(Vector3)) == 0) && (memcmp(cones[0].data(), cones[1].data(), count * sizeof(float)) == 0);
+	identical = identical && (memcmp(coneSines[0].data(), coneSines[1].data(), count * sizeof(float)) == 0) && (memcmp(colors[0].data(), colors[1].data(), count * sizeof(Vector3)) == 0);
+
+	std::wstringstream stream;
+	stream << L"Decoding the cluster normals and colors of " << nodeCount << L" nodes: computed " << std::fixed << std::setprecision(1) << 1e9 * seconds[0] / max((size_t)1, nodeCount) << L" ns per node, ";
+	stream << L"decode tables " << 1e9 * seconds[1] / max((size_t)1, nodeCount) << L" ns per node, speedup " << std::setprecision(2) << seconds[0] / max(seconds[1], 1e-9) << L"x, ";
+	stream << (identical ? L"identical values" : L"different values");
+	Log(stream.str());
+
+	SafeDelete(octree);
+}
+
+void PointCloudEngine::Benchmark::BenchmarkTraversalOutput(const std::wstring &pointcloudFile)
+{
+	// The entries are converted back into vertices with the nodes array for the comparison
+	OctreeBuildParameters buildParameters = GetBenchmarkBuildParameters();
+	buildParameters.useSuccinct = false;
+	Octree *octree = new Octree(pointcloudFile, buildParameters);
+
+	OctreeConstantBuffer octreeConstantBufferData;
+	ZeroMemory(&octreeConstantBufferData, sizeof(OctreeConstantBuffer));
+	octreeConstantBufferData.useCulling = false;
+	octreeConstantBufferData.level = -1;
+	octreeConstantBufferData.fovAngleY = settings->fovAngleY;
+	octreeConstantBufferData.splatResolution = settings->splatResolution;
+
+	const int repetitions = 10;
+	std::vector<OctreeNodeVertex> vertices;
+	std::vector<OctreeNodeTraversalEntry> entries;
+
+	for (float distance = 4.0f; distance >= 0.5f; distance *= 0.5f)
+	{
+		octreeConstantBufferData.localCameraPosition = octree->rootPosition - Vector3(0, 0, distance * octree->rootSize);
+
+		// The first traversals grow the output and the traversal buffers, afterwards the traversals should not allocate anymore
+		octree->GetVertices(octreeConstantBufferData, vertices);
+		octree->GetEntries(octreeConstantBufferData, entries);
+
+		double seconds[2];
+		UINT64 allocations[2];
+
+		for (int i = 0; i < 2; i++)
+		{
+			UINT64 allocationCount = GetAllocationCount();
+			auto start = std::chrono::steady_clock::now();
+
+			for (int j = 0; j < repetitions; j++)
+			{
+				if (i == 0)
+				{
+					octree->GetVertices(octreeConstantBufferData, vertices);
+				}
+				else
+				{
+					octree->GetEntries(octreeConstantBufferData, entries);
+				}
+			}
+
+			seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+			allocations[i] = GetAllocationCount() - allocationCount;
+		}
+
+		bool identical = (vertices.size() == entries.size());
+
+		for (size_t i = 0; identical && (i < entries.size()); i++)
+		{
+			OctreeNodeVertex vertex = octree->GetNodes()[entries[i].index].GetVertexFromTraversalEntry(entries[i]);
+			identical = (memcmp(&vertex, &vertices[i], sizeof(OctreeNodeVertex)) == 0);
+		}
+
+		std::wstringstream stream;
+		stream << L"Traversal output at distance " << std::fixed << std::setprecision(1) << distance << L": " << vertices.size() << L" nodes, ";
+		stream << std::setprecision(3) << L"vertices " << 1000.0 * seconds[0] << L" ms (" << ToMegabytes(vertices.size() * sizeof(OctreeNodeVertex)) << L"), ";
+		stream << L"entries " << 1000.0 * seconds[1] << L" ms (" << ToMegabytes(entries.size() * sizeof(OctreeNodeTraversalEntry)) << L"), ";
+		stream << ToAllocationString(allocations[0]) << L" and " << ToAllocationString(allocations[1]) << L" in " << repetitions << L" traversals, ";
+		stream << (identical ? L"entries match the vertices" : L"entries differ from the vertices");
+		Log(stream.str());
+	}
+
+	SafeDelete(octree);
+}
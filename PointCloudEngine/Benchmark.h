@@ -0,0 +1,78 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#define BENCHMARK_FILENAME L"/Benchmark.txt"
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	class Benchmark
+	{
+	public:
+		// Appends the message with a timestamp to the benchmark file next to the executable
+		static void Log(const std::wstring &message);
+
+		// Current and peak working set size (resident memory) of this process in bytes
+		static size_t GetMemoryUsage();
+		static size_t GetPeakMemoryUsage();
+
+		// Number of heap allocations with operator new since the start of this process
+		// The difference of two calls shows how many allocations a build or a frame made
+		// Only counted in benchmark builds with POINTCLOUDENGINE_COUNT_ALLOCATIONS defined, otherwise the count is always 0
+		static bool IsAllocationCountAvailable();
+		static UINT64 GetAllocationCount();
+
+		static std::wstring ToMegabytes(size_t bytes);
+		static std::wstring ToAllocationString(UINT64 allocationCount);
+		static std::wstring ToString(const OctreeBuildStatistics &buildStatistics);
+		static std::wstring ToString(const OctreeBuildMode &buildMode);
+
+		// Records the memory usage, allocation count and time before a build, the vertex and node counts are set by the caller
+		// Finish sets the duration, the peak memory usage and the allocations since the start
+		static void StartBuildStatistics(OctreeBuildStatistics &buildStatistics);
+		static void FinishBuildStatistics(OctreeBuildStatistics &buildStatistics);
+
+		// Logs e.g. "Octree build TopDown bottom up: 1000 vertices, ..."
+		static void LogBuildStatistics(const std::wstring &name, OctreeBuildMode buildMode, bool useBottomUpAggregation, const OctreeBuildStatistics &buildStatistics);
+
+		// Copy of the current build parameters without the paged octree and the incremental traversal, the benchmarks never change the settings
+		// The benchmarks that need the nodes array also disable the succinct topology in their copy
+		static OctreeBuildParameters GetBenchmarkBuildParameters();
+
+		// Builds the octree of the .pointcloud file with every build mode and logs the timings and differences of the results
+		static void BenchmarkOctreeBuilders(const std::wstring &pointcloudFile);
+
+		// Clusters the normals of node sized vertex ranges with the previous loop and the scalar and AVX2 kernels
+		// Logs the timings and how many quantized normals and weights differ from the previous loop
+		static void BenchmarkNormalClustering(const std::wstring &pointcloudFile);
+
+		// Builds the octree with exact clustering and with bottom up aggregation, logs the timings and the errors of the aggregated inner nodes
+		static void BenchmarkPropertyAggregation(const std::wstring &pointcloudFile);
+
+		// Writes and loads the octree as raw and as compressed .octree file, logs the file sizes, the compression ratio and the throughputs
+		static void BenchmarkOctreeCompression(const std::wstring &pointcloudFile);
+
+		// Loads the octree with the nodes array and with the succinct topology, logs the memory per node and the cpu traversal times from different distances
+		static void BenchmarkSuccinctOctree(const std::wstring &pointcloudFile);
+
+		// Reads the .pointcloud file sequentially in large chunks and with many small random reads using each file read backend, logs the throughputs and the reads per second
+		static void BenchmarkFileReadBackends(const std::wstring &pointcloudFile);
+
+		// Traverses the octree on the cpu with 1 up to all the hardware threads, logs the traversal times, the speedups and whether the vertices match the single threaded traversal
+		static void BenchmarkParallelTraversal(const std::wstring &pointcloudFile);
+
+		// Flies the camera around the octree with different speeds and compares the full cpu traversal with the incremental update of the level of detail cut
+		// Logs the traversal times, the evaluated and reused nodes per frame and whether the vertices of both are the same in every frame
+		static void BenchmarkIncrementalTraversal(const std::wstring &pointcloudFile);
+
+		// Decodes the cluster normals, cones and colors of all the nodes with the previous computation and with the decode tables
+		// Logs the decode time per node of both and whether the decoded values are the same
+		static void BenchmarkDecodeTables(const std::wstring &pointcloudFile);
+
+		// Traverses the octree on the cpu with the vertices and with the entries as output, logs the traversal times, the output sizes and the allocations of the repeated traversals
+		static void BenchmarkTraversalOutput(const std::wstring &pointcloudFile);
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "BlockingFileReadBackend.h"
+
+PointCloudEngine::BlockingFileReadBackend::BlockingFileReadBackend(UINT threadCount)
+{
+	threadPool = new ThreadPool(threadCount);
+}
+
+PointCloudEngine::BlockingFileReadBackend::~BlockingFileReadBackend()
+{
+	// Closing waits for the reads that are still in flight, a callback exception that was not rethrown by Wait is dropped
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+
+	SafeDelete(threadPool);
+}
+
+bool PointCloudEngine::BlockingFileReadBackend::Open(const std::wstring &filename, bool unbuffered)
+{
+	Close();
+
+	DWORD flags = FILE_FLAG_RANDOM_ACCESS | (unbuffered ? FILE_FLAG_NO_BUFFERING : 0);
+	file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, flags, NULL);
+
+	return file != INVALID_HANDLE_VALUE;
+}
+
+void PointCloudEngine::BlockingFileReadBackend::Close()
+{
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		threadPool->Wait();
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+}
+
+void PointCloudEngine::BlockingFileReadBackend::QueueRead(UINT64 offset, UINT size, void *destination, std::function<void(DWORD)> completed)
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	queuedRequests.push_back({ offset, size, destination, completed });
+}
+
+void PointCloudEngine::BlockingFileReadBackend::Submit()
+{
+	std::vector<Request> requests;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		requests.swap(queuedRequests);
+	}
+
+	for (auto it = requests.begin(); it != requests.end(); it++)
+	{
+		Request request = *it;
+
+		threadPool->Submit([=]()
+		{
+			// Positioned read, the reads of multiple threads do not share a file pointer
+			OVERLAPPED overlapped;
+			ZeroMemory(&overlapped, sizeof(OVERLAPPED));
+			overlapped.Offset = (DWORD)request.offset;
+			overlapped.OffsetHigh = (DWORD)(request.offset >> 32);
+
+			DWORD readBytes = 0;
+
+			if (!ReadFile(file, request.destination, request.size, &readBytes, &overlapped))
+			{
+				readBytes = 0;
+			}
+
+			request.completed(readBytes);
+		});
+	}
+}
+
+void PointCloudEngine::BlockingFileReadBackend::Wait()
+{
+	threadPool->Wait();
+}
+
+UINT PointCloudEngine::BlockingFileReadBackend::GetThreadCount() const
+{
+	return threadPool->GetThreadCount();
+}
+
+std::wstring PointCloudEngine::BlockingFileReadBackend::GetName() const
+{
+	return L"blocking";
+}
@@ -0,0 +1,43 @@
+#ifndef BLOCKINGFILEREADBACKEND_H
+#define BLOCKINGFILEREADBACKEND_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Portable fallback that issues one blocking ReadFile for each read on the threads of a thread pool
+	// The number of reads in flight is limited by the thread count and every read is a separate system call
+	class BlockingFileReadBackend : public IFileReadBackend
+	{
+	public:
+		// A thread count of 0 uses all the hardware threads
+		BlockingFileReadBackend(UINT threadCount);
+		~BlockingFileReadBackend();
+
+		bool Open(const std::wstring &filename, bool unbuffered);
+		void Close();
+		void QueueRead(UINT64 offset, UINT size, void *destination, std::function<void(DWORD)> completed);
+		void Submit();
+		void Wait();
+		UINT GetThreadCount() const;
+		std::wstring GetName() const;
+
+	private:
+		struct Request
+		{
+			UINT64 offset;
+			UINT size;
+			void *destination;
+			std::function<void(DWORD)> completed;
+		};
+
+		HANDLE file = INVALID_HANDLE_VALUE;
+		ThreadPool *threadPool = NULL;
+
+		// Reads can be queued from the callbacks of other reads
+		std::mutex queueMutex;
+		std::vector<Request> queuedRequests;
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+// The structures decode with the tables, the engine header includes both in the right order
+#include "PointCloudEngine.h"
+#include "DecodeTables.h"
+
+Vector3 PointCloudEngine::DecodeTables::normals[4096];
+float PointCloudEngine::DecodeTables::cones[16];
+float PointCloudEngine::DecodeTables::coneSines[16];
+double PointCloudEngine::DecodeTables::sixBitChannels[64];
+double PointCloudEngine::DecodeTables::fourBitChannels[16];
+bool PointCloudEngine::DecodeTables::initialized = PointCloudEngine::DecodeTables::Initialize();
+
+Vector3 PointCloudEngine::DecodeTables::ComputeNormal(UINT thetaPhi)
+{
+	USHORT theta = thetaPhi >> 6;
+	USHORT phi = thetaPhi & 0x3f;
+
+	// Check if this represents the empty normal (0, 0, 0)
+	if (theta == 0 && phi == 0)
+	{
+		return Vector3(0, 0, 0);
+	}
+
+	float t = XM_PI * (theta / 63.0f);
+	float p = XM_PI * ((phi / 31.5f) - 1.0f);
+
+	Vector3 normal(sin(t) * cos(p), sin(t) * sin(p), cos(t));
+	normal.Normalize();
+
+	return normal;
+}
+
+float PointCloudEngine::DecodeTables::ComputeCone(UINT cone)
+{
+	return XM_PI * (cone / 15.0f);
+}
+
+bool PointCloudEngine::DecodeTables::Initialize()
+{
+	for (UINT i = 0; i < 4096; i++)
+	{
+		normals[i] = ComputeNormal(i);
+	}
+
+	for (UINT i = 0; i < 16; i++)
+	{
+		cones[i] = ComputeCone(i);
+		coneSines[i] = sin(cones[i]);
+		fourBitChannels[i] = 255.0 * i / 15.0;
+	}
+
+	for (UINT i = 0; i < 64; i++)
+	{
+		sixBitChannels[i] = 255.0 * i / 63.0;
+	}
+
+	return true;
+}
@@ -0,0 +1,42 @@
+#ifndef DECODETABLES_H
+#define DECODETABLES_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Decoded values of the quantized cluster normals and colors, every possible bit pattern is decoded once when the program starts
+	// There are only 64 x 64 normal directions, 16 cones and 64/64/16 color channel values, a lookup replaces the sin, cos, sqrt and divisions of each decode
+	// The tables are filled with the same code that decoded the values before, therefore the lookups return exactly the same values
+	class DecodeTables
+	{
+	public:
+		// Indexed by the 6 theta and 6 phi bits of a cluster normal (thetaPhiCone >> 4), index 0 is the empty normal (0, 0, 0)
+		static const Vector3& GetNormal(UINT thetaPhi) { return normals[thetaPhi]; }
+
+		// Cone in radians and its sine, indexed by the 4 cone bits of a cluster normal
+		static float GetCone(UINT cone) { return cones[cone]; }
+		static float GetConeSine(UINT cone) { return coneSines[cone]; }
+
+		// Color channels in [0, 255], indexed by the 6 red or green bits and by the 4 blue bits of a 16 bit color
+		static double GetSixBitChannel(UINT channel) { return sixBitChannels[channel]; }
+		static double GetFourBitChannel(UINT channel) { return fourBitChannels[channel]; }
+
+		// Decode without the tables, used to fill them and to compare against them
+		static Vector3 ComputeNormal(UINT thetaPhi);
+		static float ComputeCone(UINT cone);
+
+	private:
+		static Vector3 normals[4096];
+		static float cones[16];
+		static float coneSines[16];
+		static double sixBitChannels[64];
+		static double fourBitChannels[16];
+
+		// Fills the tables during the static initialization
+		static bool initialized;
+		static bool Initialize();
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "FileHasher.h"
+
+PointCloudEngine::FileHasher::FileHasher()
+{
+	blockChecksum = OctreeFile::ComputeChecksum(NULL, 0);
+}
+
+void PointCloudEngine::FileHasher::Add(const void *data, size_t size)
+{
+	const byte *bytes = (const byte*)data;
+	fileSize += size;
+
+	while (size > 0)
+	{
+		// The block size is a multiple of the word size, there are no pending bytes at the end of a full block
+		size_t count = (size_t)min((UINT64)size, blockSize - blockBytes);
+		AddToBlock(bytes, count);
+
+		bytes += count;
+		size -= count;
+		blockBytes += count;
+
+		if (blockBytes == blockSize)
+		{
+			blockChecksums.push_back(blockChecksum);
+			blockChecksum = OctreeFile::ComputeChecksum(NULL, 0);
+			blockBytes = 0;
+		}
+	}
+}
+
+UINT64 PointCloudEngine::FileHasher::Finish()
+{
+	// The last block can end with single bytes like in HashFile
+	if (blockBytes > 0)
+	{
+		blockChecksums.push_back(OctreeFile::ComputeChecksum(pendingBytes, pendingCount, blockChecksum));
+	}
+
+	UINT64 hash = OctreeFile::ComputeChecksum(blockChecksums.data(), blockChecksums.size() * sizeof(UINT64), OctreeFile::ComputeChecksum(&fileSize, sizeof(UINT64)));
+
+	fileSize = 0;
+	blockBytes = 0;
+	blockChecksum = OctreeFile::ComputeChecksum(NULL, 0);
+	blockChecksums.clear();
+	pendingCount = 0;
+
+	return hash;
+}
+
+void PointCloudEngine::FileHasher::AddToBlock(const byte *data, size_t size)
+{
+	// Complete the word of the last part first
+	if (pendingCount > 0)
+	{
+		size_t count = min(size, sizeof(pendingBytes) - pendingCount);
+		memcpy(pendingBytes + pendingCount, data, count);
+		pendingCount += count;
+		data += count;
+		size -= count;
+
+		if (pendingCount < sizeof(pendingBytes))
+		{
+			return;
+		}
+
+		blockChecksum = OctreeFile::ComputeChecksum(pendingBytes, sizeof(pendingBytes), blockChecksum);
+		pendingCount = 0;
+	}
+
+	size_t wordBytes = size - (size % 8);
+	blockChecksum = OctreeFile::ComputeChecksum(data, wordBytes, blockChecksum);
+
+	memcpy(pendingBytes, data + wordBytes, size - wordBytes);
+	pendingCount = size - wordBytes;
+}
@@ -0,0 +1,37 @@
+#ifndef FILEHASHER_H
+#define FILEHASHER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Computes the same content hash as Octree::HashFile while a file is written, the parts are added in the order of the file and can have any size
+	// The word wise checksum of each block is continued part by part, the bytes of a part that do not fill a whole word are kept for the next part
+	class FileHasher
+	{
+	public:
+		// Bytes per block, the block checksums are combined in order at the end
+		static const UINT64 blockSize = 64 * 1024 * 1024;
+
+		FileHasher();
+
+		void Add(const void *data, size_t size);
+
+		// Hash of all the added bytes, the hasher is reset afterwards
+		UINT64 Finish();
+
+	private:
+		UINT64 fileSize = 0;
+		UINT64 blockBytes = 0;
+		UINT64 blockChecksum;
+		std::vector<UINT64> blockChecksums;
+
+		// Bytes of the current block that were not added to the checksum yet
+		byte pendingBytes[8];
+		size_t pendingCount = 0;
+
+		void AddToBlock(const byte *data, size_t size);
+	};
+}
+#endif
@@ -0,0 +1,198 @@
+#include "FrustumCuller.h"
+
+PointCloudEngine::FrustumCuller::FrustumCuller(const OctreeConstantBuffer &octreeConstantBufferData)
+{
+	useCulling = octreeConstantBufferData.useCulling;
+
+	// Same planes as the previous corner test, each plane goes through one of the two opposite frustum corners
+	Vector3 planePositions[6] =
+	{
+		octreeConstantBufferData.localViewFrustumNearTopLeft,		// Near Plane
+		octreeConstantBufferData.localViewFrustumFarBottomRight,	// Far Plane
+		octreeConstantBufferData.localViewFrustumNearTopLeft,		// Left Plane
+		octreeConstantBufferData.localViewFrustumFarBottomRight,	// Right Plane
+		octreeConstantBufferData.localViewFrustumNearTopLeft,		// Top Plane
+		octreeConstantBufferData.localViewFrustumFarBottomRight		// Bottom Plane
+	};
+
+	Vector3 planeNormals[6] =
+	{
+		octreeConstantBufferData.localViewPlaneNearNormal,
+		octreeConstantBufferData.localViewPlaneFarNormal,
+		octreeConstantBufferData.localViewPlaneLeftNormal,
+		octreeConstantBufferData.localViewPlaneRightNormal,
+		octreeConstantBufferData.localViewPlaneTopNormal,
+		octreeConstantBufferData.localViewPlaneBottomNormal
+	};
+
+	for (int i = 0; i < 6; i++)
+	{
+		normalsX[i] = planeNormals[i].x;
+		normalsY[i] = planeNormals[i].y;
+		normalsZ[i] = planeNormals[i].z;
+		offsets[i] = -planeNormals[i].Dot(planePositions[i]);
+		radiusFactors[i] = fabs(planeNormals[i].x) + fabs(planeNormals[i].y) + fabs(planeNormals[i].z);
+	}
+}
+
+void PointCloudEngine::FrustumCuller::Classify(const OctreeNodeTraversalEntry *entries, UINT count, int *outInsidePlanes) const
+{
+	static const bool useAVX2 = NormalClustering::IsAVX2Supported();
+
+	if (useAVX2)
+	{
+		ClassifyAVX2(entries, count, outInsidePlanes);
+	}
+	else
+	{
+		ClassifyScalar(entries, count, outInsidePlanes);
+	}
+}
+
+void PointCloudEngine::FrustumCuller::ClassifyScalar(const OctreeNodeTraversalEntry *entries, UINT count, int *outInsidePlanes) const
+{
+	for (UINT i = 0; i < count; i++)
+	{
+		const OctreeNodeTraversalEntry &entry = entries[i];
+		int insidePlanes = useCulling ? entry.parentInsidePlanes : allPlanesInside;
+		float extends = entry.size * 0.5f;
+
+		for (int j = 0; (j < 6) && (insidePlanes != outside); j++)
+		{
+			if (insidePlanes & (1 << j))
+			{
+				continue;
+			}
+
+			// Signed distance of the cube center and the distance of the positive vertex from the center along the normal
+			float distance = normalsX[j] * entry.position.x + normalsY[j] * entry.position.y + normalsZ[j] * entry.position.z + offsets[j];
+			float radius = extends * radiusFactors[j];
+
+			if (distance - radius > 0)
+			{
+				// Even the negative vertex is outside, so is the whole cube
+				insidePlanes = outside;
+			}
+			else if (distance + radius <= 0)
+			{
+				// Even the positive vertex is inside, the children can skip this plane
+				insidePlanes |= 1 << j;
+			}
+		}
+
+		outInsidePlanes[i] = insidePlanes;
+	}
+}
+
+void PointCloudEngine::FrustumCuller::ClassifyAVX2(const OctreeNodeTraversalEntry *entries, UINT count, int *outInsidePlanes) const
+{
+	if (!useCulling)
+	{
+		ClassifyScalar(entries, count, outInsidePlanes);
+		return;
+	}
+
+	// Copy the entries into a structure of arrays, the unused lanes are zero sized cubes that are discarded afterwards
+	alignas(32) float positionsX[batchSize] = {};
+	alignas(32) float positionsY[batchSize] = {};
+	alignas(32) float positionsZ[batchSize] = {};
+	alignas(32) float extends[batchSize] = {};
+	alignas(32) int parentInsidePlanes[batchSize] = {};
+	alignas(32) int insidePlanes[batchSize];
+
+	for (UINT i = 0; i < count; i++)
+	{
+		positionsX[i] = entries[i].position.x;
+		positionsY[i] = entries[i].position.y;
+		positionsZ[i] = entries[i].position.z;
+		extends[i] = entries[i].size * 0.5f;
+		parentInsidePlanes[i] = entries[i].parentInsidePlanes;
+	}
+
+	__m256 x = _mm256_load_ps(positionsX);
+	__m256 y = _mm256_load_ps(positionsY);
+	__m256 z = _mm256_load_ps(positionsZ);
+	__m256 extend = _mm256_load_ps(extends);
+	__m256 zero = _mm256_setzero_ps();
+	__m256i parentMasks = _mm256_load_si256((const __m256i*)parentInsidePlanes);
+	__m256i masks = parentMasks;
+	__m256i outsideLanes = _mm256_setzero_si256();
+
+	for (int j = 0; j < 6; j++)
+	{
+		// Same operation order as the scalar kernel (no fused multiply add) so that both classify the cubes on the planes the same way
+		__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(normalsX[j]), x), _mm256_mul_ps(_mm256_set1_ps(normalsY[j]), y)), _mm256_mul_ps(_mm256_set1_ps(normalsZ[j]), z)), _mm256_set1_ps(offsets[j]));
+		__m256 radius = _mm256_mul_ps(extend, _mm256_set1_ps(radiusFactors[j]));
+		__m256i outsidePlane = _mm256_castps_si256(_mm256_cmp_ps(_mm256_sub_ps(distance, radius), zero, _CMP_GT_OQ));
+		__m256i insidePlane = _mm256_castps_si256(_mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LE_OQ));
+
+		// The planes that the parent is fully inside are not tested
+		__m256i planeBit = _mm256_set1_epi32(1 << j);
+		__m256i skipped = _mm256_cmpeq_epi32(_mm256_and_si256(parentMasks, planeBit), planeBit);
+
+		outsideLanes = _mm256_or_si256(outsideLanes, _mm256_andnot_si256(skipped, outsidePlane));
+		masks = _mm256_or_si256(masks, _mm256_and_si256(insidePlane, planeBit));
+	}
+
+	masks = _mm256_blendv_epi8(masks, _mm256_set1_epi32(outside), outsideLanes);
+	_mm256_store_si256((__m256i*)insidePlanes, masks);
+
+	for (UINT i = 0; i < count; i++)
+	{
+		outInsidePlanes[i] = insidePlanes[i];
+	}
+}
+
+int PointCloudEngine::FrustumCuller::Classify(const OctreeNodeTraversalEntry &entry, float &outSlack) const
+{
+	int insidePlanes = useCulling ? entry.parentInsidePlanes : allPlanesInside;
+	float extends = entry.size * 0.5f;
+
+	outSlack = FLT_MAX;
+
+	for (int j = 0; j < 6; j++)
+	{
+		if (insidePlanes & (1 << j))
+		{
+			continue;
+		}
+
+		float distance = normalsX[j] * entry.position.x + normalsY[j] * entry.position.y + normalsZ[j] * entry.position.z + offsets[j];
+		float radius = extends * radiusFactors[j];
+
+		if (distance - radius > 0)
+		{
+			// The cube stays outside until this plane moves by the distance of the negative vertex
+			outSlack = distance - radius;
+			return outside;
+		}
+		else if (distance + radius <= 0)
+		{
+			insidePlanes |= 1 << j;
+		}
+
+		// Both the positive and the negative vertex have to stay on their side of the plane
+		outSlack = min(outSlack, min(fabs(distance - radius), fabs(distance + radius)));
+	}
+
+	return insidePlanes;
+}
+
+float PointCloudEngine::FrustumCuller::GetPlaneMovement(const FrustumCuller &previous, float maxPositionLength) const
+{
+	if (useCulling != previous.useCulling)
+	{
+		return FLT_MAX;
+	}
+
+	float movement = 0;
+
+	// The signed distance of a position changes at most by the change of the normal times the length of the position plus the change of the offset
+	for (int i = 0; i < 6; i++)
+	{
+		Vector3 normalChange(normalsX[i] - previous.normalsX[i], normalsY[i] - previous.normalsY[i], normalsZ[i] - previous.normalsZ[i]);
+		movement = max(movement, normalChange.Length() * maxPositionLength + fabs(offsets[i] - previous.offsets[i]));
+	}
+
+	return movement;
+}
@@ -0,0 +1,53 @@
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Classifies the bounding cubes of the octree nodes against the 6 planes of the view frustum with the positive and negative vertex test
+	// Only the vertex of the cube that is furthest along the plane normal (and the one furthest against it) is tested, instead of all 8 corners
+	// The planes that the parent is fully inside are skipped, the children of a node that is fully inside all the planes are not tested at all
+	// The AVX2 kernel classifies 8 nodes at once from a structure of arrays copy of their positions, sizes and plane masks
+	class FrustumCuller
+	{
+	public:
+		// Bit i is set when the cube is fully inside plane i (near, far, left, right, top, bottom), all bits are set when it is fully inside the view frustum
+		static const int allPlanesInside = 0x3F;
+
+		// Classification of a cube that is fully outside of at least one of the planes
+		static const int outside = -1;
+
+		// Number of entries that are classified together
+		static const UINT batchSize = 8;
+
+		// Without culling in the constant buffer all the entries are classified as fully inside
+		FrustumCuller(const OctreeConstantBuffer &octreeConstantBufferData);
+
+		// Writes outside or the plane mask of the cube (including the planes of the parent) for each of the up to batchSize entries
+		// Uses the AVX2 kernel when the processor supports it, otherwise the scalar kernel, both return the same classifications
+		void Classify(const OctreeNodeTraversalEntry *entries, UINT count, int *outInsidePlanes) const;
+		void ClassifyScalar(const OctreeNodeTraversalEntry *entries, UINT count, int *outInsidePlanes) const;
+		void ClassifyAVX2(const OctreeNodeTraversalEntry *entries, UINT count, int *outInsidePlanes) const;
+
+		// Same classification as the scalar kernel, the slack is how far the tested planes can move until the classification can change
+		int Classify(const OctreeNodeTraversalEntry &entry, float &outSlack) const;
+
+		// Upper bound of how far the signed distance of any position within the maximum distance from the origin moved between the planes of both cullers
+		float GetPlaneMovement(const FrustumCuller &previous, float maxPositionLength) const;
+
+	private:
+		bool useCulling;
+
+		// A position p is outside of plane i when normal.Dot(p) + offset > 0, the normals point out of the view frustum
+		float normalsX[6];
+		float normalsY[6];
+		float normalsZ[6];
+		float offsets[6];
+
+		// Sum of the absolute normal components, multiplied with half the cube size this is the distance of the positive vertex from the cube center
+		float radiusFactors[6];
+	};
+}
+#endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #define CAMERARECORDINGS_FILENAME L"/CameraRecordings.vector"
 
 UINT GUI::fps = 0;
+UINT GUI::allocationsPerFrame = 0;
 UINT GUI::vertexCount = 0;
 UINT GUI::cameraRecording = 0;
 int GUI::lossFunctionSelection = 0;
@@ -64,6 +65,9 @@ std::vector<IGUIElement*> GUI::advancedElements;
 // HDF5
 std::vector<IGUIElement*> GUI::hdf5Elements;
 
+// Benchmark
+std::vector<IGUIElement*> GUI::benchmarkElements;
+
 void PointCloudEngine::GUI::Initialize()
 {
 	if (!initialized)
@@ -83,7 +87,7 @@ void PointCloudEngine::GUI::Initialize()
 
 		// Tab inside the gui window for choosing different groups of settings
 		tabGroundTruth = new GUITab(hwndGUI, XMUINT2(0, 0), XMUINT2(guiSize.x, guiSize.y), { L"General", L"Advanced", L"HDF5 Dataset" }, OnSelectTab);
-		tabOctree = new GUITab(hwndGUI, XMUINT2(0, 0), XMUINT2(guiSize.x, guiSize.y), { L"General", L"Advanced" }, OnSelectTab);
+		tabOctree = new GUITab(hwndGUI, XMUINT2(0, 0), XMUINT2(guiSize.x, guiSize.y), { L"General", L"Advanced", L"Benchmark" }, OnSelectTab);
 
 		viewModeSelection = (int)settings->viewMode;
 
@@ -101,6 +105,7 @@ void PointCloudEngine::GUI::Initialize()
 		CreateContentGeneral();
 		CreateContentAdvanced();
 		CreateContentHDF5();
+		CreateContentBenchmark();
 
 		initialized = true;
 	}
@@ -127,6 +132,7 @@ void PointCloudEngine::GUI::Release()
 	DeleteElements(neuralNetworkElements);
 	DeleteElements(advancedElements);
 	DeleteElements(hdf5Elements);
+	DeleteElements(benchmarkElements);
 }
 
 void PointCloudEngine::GUI::Update()
@@ -144,6 +150,7 @@ void PointCloudEngine::GUI::Update()
 	UpdateElements(neuralNetworkElements);
 	UpdateElements(advancedElements);
 	UpdateElements(hdf5Elements);
+	UpdateElements(benchmarkElements);
 }
 
 void PointCloudEngine::GUI::HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam)
@@ -165,6 +172,7 @@ void PointCloudEngine::GUI::HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam
 		HandleMessageElements(neuralNetworkElements, msg, wParam, lParam);
 		HandleMessageElements(advancedElements, msg, wParam, lParam);
 		HandleMessageElements(hdf5Elements, msg, wParam, lParam);
+		HandleMessageElements(benchmarkElements, msg, wParam, lParam);
 	}
 }
 
@@ -253,6 +261,14 @@ void PointCloudEngine::GUI::CreateContentGeneral()
 	generalElements.push_back(new GUIValue<UINT>(hwndGUI, { 160, 70 }, { 200, 20 }, &GUI::vertexCount));
 	generalElements.push_back(new GUIText(hwndGUI, { 10, 100 }, { 150, 20 }, L"Frames per second "));
 	generalElements.push_back(new GUIValue<UINT>(hwndGUI, { 160, 100 }, { 50, 20 }, &GUI::fps));
+
+	// The allocations are only counted in benchmark builds
+	if (Benchmark::IsAllocationCountAvailable())
+	{
+		generalElements.push_back(new GUIText(hwndGUI, { 215, 100 }, { 100, 20 }, L"Allocations/frame "));
+		generalElements.push_back(new GUIValue<UINT>(hwndGUI, { 320, 100 }, { 50, 20 }, &GUI::allocationsPerFrame));
+	}
+
 	generalElements.push_back(new GUIText(hwndGUI, { 10, 130 }, { 150, 20 }, L"Lighting "));
 	generalElements.push_back(new GUICheckbox(hwndGUI, { 160, 130 }, { 20, 20 }, L"", NULL, &settings->useLighting));
 
@@ -342,6 +358,21 @@ void PointCloudEngine::GUI::CreateContentHDF5()
 	hdf5Elements.push_back(new GUIButton(hwndGUI, { 10, 365 }, { 325, 25 }, L"Generate Sphere HDF5 Dataset", OnGenerateSphereDataset));
 }
 
+void PointCloudEngine::GUI::CreateContentBenchmark()
+{
+	benchmarkElements.push_back(new GUIText(hwndGUI, { 10, 40 }, { 300, 20 }, L"Results are appended to Benchmark.txt"));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 70 }, { 325, 25 }, L"Benchmark Octree Builders", OnBenchmarkOctreeBuilders));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 105 }, { 325, 25 }, L"Benchmark Normal Clustering", OnBenchmarkNormalClustering));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 140 }, { 325, 25 }, L"Benchmark Property Aggregation", OnBenchmarkPropertyAggregation));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 175 }, { 325, 25 }, L"Benchmark Octree Compression", OnBenchmarkOctreeCompression));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 210 }, { 325, 25 }, L"Benchmark Succinct Octree", OnBenchmarkSuccinctOctree));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 245 }, { 325, 25 }, L"Benchmark File Read Backends", OnBenchmarkFileReadBackends));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 280 }, { 325, 25 }, L"Benchmark Parallel Traversal", OnBenchmarkParallelTraversal));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 315 }, { 325, 25 }, L"Benchmark Incremental Traversal", OnBenchmarkIncrementalTraversal));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 350 }, { 325, 25 }, L"Benchmark Decode Tables", OnBenchmarkDecodeTables));
+	benchmarkElements.push_back(new GUIButton(hwndGUI, { 10, 385 }, { 325, 25 }, L"Benchmark Traversal Output", OnBenchmarkTraversalOutput));
+}
+
 void PointCloudEngine::GUI::LoadCameraRecording()
 {
 	// Load the stored camera recordings from a file
@@ -443,6 +474,7 @@ void PointCloudEngine::GUI::OnSelectTab(int selection)
 	ShowElements(neuralNetworkElements, SW_HIDE);
 	ShowElements(advancedElements, SW_HIDE);
 	ShowElements(hdf5Elements, SW_HIDE);
+	ShowElements(benchmarkElements, SW_HIDE);
 
 	switch (selection)
 	{
@@ -468,7 +500,15 @@ void PointCloudEngine::GUI::OnSelectTab(int selection)
 		}
 		case 2:
 		{
-			ShowElements(hdf5Elements);
+			// The third tab is the HDF5 dataset tab for ground truth rendering and the benchmark tab for the octree
+			if (settings->useOctree)
+			{
+				ShowElements(benchmarkElements);
+			}
+			else
+			{
+				ShowElements(hdf5Elements);
+			}
 			break;
 		}
 	}
@@ -595,3 +635,53 @@ void PointCloudEngine::GUI::OnLoadDescriptionFile()
 		groundTruthRenderer->LoadNeuralNetworkDescriptionFile();
 	}
 }
+
+void PointCloudEngine::GUI::OnBenchmarkOctreeBuilders()
+{
+	Benchmark::BenchmarkOctreeBuilders(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkNormalClustering()
+{
+	Benchmark::BenchmarkNormalClustering(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkPropertyAggregation()
+{
+	Benchmark::BenchmarkPropertyAggregation(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkOctreeCompression()
+{
+	Benchmark::BenchmarkOctreeCompression(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkSuccinctOctree()
+{
+	Benchmark::BenchmarkSuccinctOctree(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkFileReadBackends()
+{
+	Benchmark::BenchmarkFileReadBackends(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkParallelTraversal()
+{
+	Benchmark::BenchmarkParallelTraversal(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkIncrementalTraversal()
+{
+	Benchmark::BenchmarkIncrementalTraversal(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkDecodeTables()
+{
+	Benchmark::BenchmarkDecodeTables(settings->pointcloudFile);
+}
+
+void PointCloudEngine::GUI::OnBenchmarkTraversalOutput()
+{
+	Benchmark::BenchmarkTraversalOutput(settings->pointcloudFile);
+}
@@ -17,6 +17,7 @@ namespace PointCloudEngine
 	{
 	public:
 		static UINT fps;
+		static UINT allocationsPerFrame;
 		static UINT vertexCount;
 		static UINT cameraRecording;
 		static int lossFunctionSelection;
@@ -64,6 +65,9 @@ namespace PointCloudEngine
 		// HDF5
 		static std::vector<IGUIElement*> hdf5Elements;
 
+		// Benchmark
+		static std::vector<IGUIElement*> benchmarkElements;
+
 		static void ShowElements(std::vector<IGUIElement*> elements, int SW_COMMAND = SW_SHOW);
 		static void DeleteElements(std::vector<IGUIElement*> elements);
 		static void UpdateElements(std::vector<IGUIElement*> elements);
@@ -71,6 +75,7 @@ namespace PointCloudEngine
 		static void CreateContentGeneral();
 		static void CreateContentAdvanced();
 		static void CreateContentHDF5();
+		static void CreateContentBenchmark();
 		static void LoadCameraRecording();
 		static void SaveCameraRecording();
 
@@ -88,6 +93,16 @@ namespace PointCloudEngine
 		static void OnSelectNeuralNetworkLossTarget();
 		static void OnLoadPytorchModel();
 		static void OnLoadDescriptionFile();
+		static void OnBenchmarkOctreeBuilders();
+		static void OnBenchmarkNormalClustering();
+		static void OnBenchmarkPropertyAggregation();
+		static void OnBenchmarkOctreeCompression();
+		static void OnBenchmarkSuccinctOctree();
+		static void OnBenchmarkFileReadBackends();
+		static void OnBenchmarkParallelTraversal();
+		static void OnBenchmarkIncrementalTraversal();
+		static void OnBenchmarkDecodeTables();
+		static void OnBenchmarkTraversalOutput();
 	};
 }
 #endif
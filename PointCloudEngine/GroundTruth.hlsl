@@ -26,12 +26,12 @@ cbuffer GroundTruthRendererConstantBuffer : register(b0)
 //------------------------------------------------------------------------------ (16 byte boundary)
 };  // Total: 368 bytes with constant buffer packing rules
 
-struct VS_INPUT
-{
-    float3 position : POSITION;
-    float3 normal : NORMAL;
-    uint3 color : COLOR;
-};
+// The vertices as they are stored in the .pointcloud file, uploaded directly from the mapped file
+// Position (3 floats), normal (3 signed bytes, 127 is 1.0), color (3 bytes) and 2 bytes padding
+// A view can only address 2^27 words, larger buffers are split across several views that each contain whole vertices (same values as in GroundTruthRenderer.cpp)
+#define POINTCLOUD_VIEW_COUNT 8
+#define POINTCLOUD_VIEW_VERTEX_COUNT 26843544
+ByteAddressBuffer pointcloudVertices[POINTCLOUD_VIEW_COUNT] : register(t0);
 
 struct VS_OUTPUT
 {
@@ -40,12 +40,34 @@ struct VS_OUTPUT
     float3 color : COLOR;
 };
 
-VS_OUTPUT VS(VS_INPUT input)
+VS_OUTPUT VS(uint vertexID : SV_VERTEXID)
 {
+	uint view = vertexID / POINTCLOUD_VIEW_VERTEX_COUNT;
+	uint address = (vertexID % POINTCLOUD_VIEW_VERTEX_COUNT) * 20;
+	float3 position = 0;
+
+	// The first word contains the normal and the red channel, the second one the green and blue channels
+	uint2 normalColor = 0;
+
+	// Resource arrays can only be indexed with constants, all the vertices of a draw call are usually in the same view
+	[unroll]
+	for (uint i = 0; i < POINTCLOUD_VIEW_COUNT; i++)
+	{
+		if (i == view)
+		{
+			position = asfloat(pointcloudVertices[i].Load3(address));
+			normalColor = pointcloudVertices[i].Load2(address + 12);
+		}
+	}
+
+	// Dequantize the normal, the bytes are sign extended with arithmetic shifts
+	int3 normal = asint(uint3(normalColor.x << 24, normalColor.x << 16, normalColor.x << 8)) >> 24;
+	uint3 color = uint3(normalColor.x >> 24, normalColor.y & 0xff, (normalColor.y >> 8) & 0xff);
+
 	VS_OUTPUT output;
-	output.position = mul(float4(input.position, 1), World);
-	output.normal = normalize(mul(input.normal, WorldInverseTranspose));
-	output.color = input.color / 255.0f;
+	output.position = mul(float4(position, 1), World);
+	output.normal = normalize(mul(normal / 127.0f, WorldInverseTranspose));
+	output.color = color / 255.0f;
 
 	return output;
 }
\ No newline at end of file
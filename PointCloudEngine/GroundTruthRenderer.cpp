@@ -1,13 +1,39 @@
 #include "GroundTruthRenderer.h"
 
-GroundTruthRenderer::GroundTruthRenderer(const std::wstring &pointcloudFile)
+// The vertex shader reads the .pointcloud vertices with their padding from a raw buffer of 4 byte words
+static_assert(sizeof(PointCloudEngine::PointcloudVertex) == 20, "The ground truth vertex shader expects 20 bytes per .pointcloud vertex");
+
+// A raw view can only address 2^27 words, larger buffers are split across several views that the vertex shader selects with the vertex id
+// Each view contains a multiple of 4 whole vertices, this keeps the start of every view 16 byte aligned
+static const UINT viewCount = 8;
+static const UINT viewVertexCount = (((1u << D3D11_REQ_BUFFER_RESOURCE_TEXEL_COUNT_2_TO_EXP) * 4 / sizeof(PointCloudEngine::PointcloudVertex)) / 4) * 4;
+static_assert(viewVertexCount == 26843544, "The ground truth vertex shader expects 26843544 vertices per view");
+
+GroundTruthRenderer::GroundTruthRenderer(const std::wstring &pointcloudFile, const FileReadParameters &fileReadParameters, UINT64 maxVertexCount)
 {
-    // Try to load the file
-    if (!LoadPointcloudFile(vertices, boundingCubePosition, boundingCubeSize, pointcloudFile))
+    // Try to map the file, the vertices are not converted to floats or copied into a vector
+    mappedFile = new PointcloudFile();
+
+    if (!mappedFile->Open(pointcloudFile, fileReadParameters, maxVertexCount))
     {
+        SafeDelete(mappedFile);
         throw std::exception("Could not load .pointcloud file!");
     }
 
+    boundingCubePosition = mappedFile->GetBoundingCubePosition();
+    boundingCubeSize = mappedFile->GetBoundingCubeSize();
+    pointcloudVertexCount = mappedFile->GetVertexCount();
+
+    // The byte size has to fit into the buffer description and all the vertices into the views of the vertex shader
+    if ((pointcloudVertexCount * sizeof(PointcloudVertex) > UINT_MAX) || (pointcloudVertexCount > (UINT64)viewCount * viewVertexCount))
+    {
+        SafeDelete(mappedFile);
+        throw std::exception("The .pointcloud file contains too many vertices for the vertex buffer!");
+    }
+
+    // Load the vertices into the file cache on this thread, the upload in the initialization only copies them from the mapping then
+    mappedFile->WaitForReadAhead();
+
     // Set the default values
     constantBufferData.fovAngleY = settings->fovAngleY;
 	constantBufferData.drawNormals = false;
@@ -15,24 +41,44 @@ GroundTruthRenderer::GroundTruthRenderer(const std::wstring &pointcloudFile)
 
 void GroundTruthRenderer::Initialize()
 {
+    // The vertices are stored as they are in the file, the vertex shader reads them from a raw buffer with the vertex id
+    UINT vertexBytes = (UINT)(pointcloudVertexCount * sizeof(PointcloudVertex));
+
     // Create a vertex buffer description
     D3D11_BUFFER_DESC vertexBufferDesc;
     ZeroMemory(&vertexBufferDesc, sizeof(vertexBufferDesc));
     vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDesc.ByteWidth = sizeof(Vertex) * vertices.size();
-    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vertexBufferDesc.ByteWidth = vertexBytes;
+    vertexBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     vertexBufferDesc.CPUAccessFlags = 0;
-    vertexBufferDesc.MiscFlags = 0;
-
-    // Fill a D3D11_SUBRESOURCE_DATA struct with the data we want in the buffer
-    D3D11_SUBRESOURCE_DATA vertexBufferData;
-    ZeroMemory(&vertexBufferData, sizeof(vertexBufferData));
-    vertexBufferData.pSysMem = &vertices[0];
+    vertexBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
 
     // Create the buffer
-    hr = d3d11Device->CreateBuffer(&vertexBufferDesc, &vertexBufferData, &vertexBuffer);
+    hr = d3d11Device->CreateBuffer(&vertexBufferDesc, NULL, &vertexBuffer);
 	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateBuffer) + L" failed for the " + NAMEOF(vertexBuffer));
 
+	// Copy the vertices straight from the mapping
+	d3d11DevCon->UpdateSubresource(vertexBuffer, 0, NULL, mappedFile->GetVertices(), 0, 0);
+	SafeDelete(mappedFile);
+
+	// Create the raw views that the vertex shader reads from, one for every started block of view vertices
+	for (UINT64 firstVertex = 0; firstVertex < pointcloudVertexCount; firstVertex += viewVertexCount)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC vertexBufferSRVDesc;
+		ZeroMemory(&vertexBufferSRVDesc, sizeof(vertexBufferSRVDesc));
+		vertexBufferSRVDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+		vertexBufferSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+		vertexBufferSRVDesc.BufferEx.FirstElement = (UINT)(firstVertex * sizeof(PointcloudVertex) / 4);
+		vertexBufferSRVDesc.BufferEx.NumElements = (UINT)(min((UINT64)viewVertexCount, pointcloudVertexCount - firstVertex) * sizeof(PointcloudVertex) / 4);
+		vertexBufferSRVDesc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+
+		ID3D11ShaderResourceView *vertexBufferSRV = NULL;
+		hr = d3d11Device->CreateShaderResourceView(vertexBuffer, &vertexBufferSRVDesc, &vertexBufferSRV);
+		ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateShaderResourceView) + L" failed for the " + NAMEOF(vertexBufferSRV));
+
+		vertexBufferSRVs.push_back(vertexBufferSRV);
+	}
+
     // Create the constant buffer for WVP
     D3D11_BUFFER_DESC constantBufferDesc;
     ZeroMemory(&constantBufferDesc, sizeof(constantBufferDesc));
@@ -73,13 +119,13 @@ void GroundTruthRenderer::Draw()
 		d3d11DevCon->PSSetShader(pointShader->pixelShader, 0, 0);
 	}
 
-    // Set the Input (Vertex) Layout
-    d3d11DevCon->IASetInputLayout(splatShader->inputLayout);
+    // Set an empty input layout and vertex buffer that only sends the vertex id to the shader
+    UINT zero = 0;
+    d3d11DevCon->IASetInputLayout(NULL);
+    d3d11DevCon->IASetVertexBuffers(0, 1, nullBuffer, &zero, &zero);
 
-    // Bind the vertex buffer and index buffer to the input assembler (IA)
-    UINT offset = 0;
-    UINT stride = sizeof(Vertex);
-    d3d11DevCon->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+    // The vertex shader reads and dequantizes the .pointcloud vertices from the raw buffer
+    d3d11DevCon->VSSetShaderResources(0, (UINT)vertexBufferSRVs.size(), vertexBufferSRVs.data());
 
     // Set primitive topology
     d3d11DevCon->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
@@ -96,7 +142,7 @@ void GroundTruthRenderer::Draw()
 	constantBufferData.useBlending = false;
 
 	// The amount of points that will be drawn
-	UINT vertexCount = vertices.size();
+	UINT vertexCount = (UINT)pointcloudVertexCount;
 
 	// Set different sampling rates based on the view mode
 	if (settings->viewMode == ViewMode::Splats)
@@ -127,15 +173,27 @@ void GroundTruthRenderer::Draw()
 		d3d11DevCon->Draw(vertexCount, 0);
 	}
 
+	// Unbind the shader resources
+	std::vector<ID3D11ShaderResourceView*> nullSRVs(vertexBufferSRVs.size(), NULL);
+	d3d11DevCon->VSSetShaderResources(0, (UINT)nullSRVs.size(), nullSRVs.data());
+
 	// Show vertex count on GUI
 	GUI::vertexCount = vertexCount;
 }
 
 void GroundTruthRenderer::Release()
 {
+    SafeDelete(mappedFile);
     SAFE_RELEASE(vertexBuffer);
     SAFE_RELEASE(constantBuffer);
 
+    for (auto it = vertexBufferSRVs.begin(); it != vertexBufferSRVs.end(); it++)
+    {
+        SAFE_RELEASE(*it);
+    }
+
+    vertexBufferSRVs.clear();
+
 	// Neural Network
 	SAFE_RELEASE(colorTexture);
 	SAFE_RELEASE(depthTexture);
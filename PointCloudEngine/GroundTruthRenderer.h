@@ -9,7 +9,8 @@ namespace PointCloudEngine
     class GroundTruthRenderer : public Component, public IRenderer
     {
     public:
-        GroundTruthRenderer(const std::wstring &pointcloudFile);
+        // Only loads the first vertices of the file when the maximum vertex count is smaller than the vertex count of the file
+        GroundTruthRenderer(const std::wstring &pointcloudFile, const FileReadParameters &fileReadParameters, UINT64 maxVertexCount = ULLONG_MAX);
         void Initialize();
         void Update();
         void Draw();
@@ -45,12 +46,15 @@ namespace PointCloudEngine
 			float padding[2];
         };
 
-        std::vector<Vertex> vertices;
+        // The vertices are uploaded directly from the mapped file and dequantized in the vertex shader, the mapping is closed afterwards
+        PointcloudFile *mappedFile = NULL;
+        UINT64 pointcloudVertexCount = 0;
         GroundTruthRendererConstantBuffer constantBufferData;
 
         // Vertex buffer
-        ID3D11Buffer* vertexBuffer;		        // Holds vertex data
-        ID3D11Buffer* constantBuffer;
+        ID3D11Buffer* vertexBuffer = NULL;		        // Holds vertex data
+        std::vector<ID3D11ShaderResourceView*> vertexBufferSRVs;
+        ID3D11Buffer* constantBuffer = NULL;
 
 		// Maps from the name of the render mode to the view mode (x) and the shading mode (y)
 		std::map<std::wstring, XMUINT2> renderModes =
@@ -0,0 +1,33 @@
+#ifndef IFILEREADBACKEND_H
+#define IFILEREADBACKEND_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Positioned reads of one file, the reads are queued and only issued together when they are submitted
+	// The completion callbacks are called by the threads of the backend, they can queue and submit more reads
+	class IFileReadBackend
+	{
+	public:
+		virtual ~IFileReadBackend() {};
+
+		// Unbuffered files bypass the file cache, the offsets, sizes and destinations of the reads have to be sector aligned then
+		virtual bool Open(const std::wstring &filename, bool unbuffered) = 0;
+		virtual void Close() = 0;
+
+		// The destination has to stay valid until the callback is called with the number of bytes that were read (0 when the read failed)
+		virtual void QueueRead(UINT64 offset, UINT size, void *destination, std::function<void(DWORD)> completed) = 0;
+
+		// Issues all the queued reads without waiting for them
+		virtual void Submit() = 0;
+
+		// Blocks until all the submitted reads and their callbacks are completed
+		virtual void Wait() = 0;
+
+		virtual UINT GetThreadCount() const = 0;
+		virtual std::wstring GetName() const = 0;
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "NormalClustering.h"
+
+int PointCloudEngine::NormalClustering::Cluster(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters)
+{
+	static const bool useAVX2 = IsAVX2Supported();
+
+	if (useAVX2)
+	{
+		return ClusterAVX2(vertices, vertexCount, outMeans, outVerticesPerMean, outClusters);
+	}
+
+	return ClusterScalar(vertices, vertexCount, outMeans, outVerticesPerMean, outClusters);
+}
+
+int PointCloudEngine::NormalClustering::ClusterScalar(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters)
+{
+	const int k = Initialize(vertices, vertexCount, outMeans, outVerticesPerMean, outClusters);
+	int iteration = 0;
+
+	while (iteration < maxIterations)
+	{
+		double sums[4][3] = { 0 };
+		UINT counts[4] = { 0, 0, 0, 0 };
+
+		// Assign all the vertices to the closest mean and sum up the new means in the same pass
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const Vector3 &normal = vertices[i].normal;
+			byte cluster = outClusters[i];
+			float minDistance = Vector3::DistanceSquared(normal, outMeans[cluster]);
+
+			for (int j = 0; j < k; j++)
+			{
+				float distance = Vector3::DistanceSquared(normal, outMeans[j]);
+
+				if (distance < minDistance)
+				{
+					cluster = j;
+					minDistance = distance;
+				}
+			}
+
+			outClusters[i] = cluster;
+			sums[cluster][0] += normal.x;
+			sums[cluster][1] += normal.y;
+			sums[cluster][2] += normal.z;
+			counts[cluster]++;
+		}
+
+		iteration++;
+
+		if (!UpdateMeans(outMeans, outVerticesPerMean, sums, counts, k))
+		{
+			break;
+		}
+	}
+
+	return iteration;
+}
+
+int PointCloudEngine::NormalClustering::ClusterAVX2(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters)
+{
+	const int k = Initialize(vertices, vertexCount, outMeans, outVerticesPerMean, outClusters);
+
+	// Copy the normals into a structure of arrays, padded to a multiple of 8
+	size_t paddedCount = (vertexCount + 7) & ~(size_t)7;
+	ScratchArena::Scope scratchScope(ScratchArena::GetThreadArena());
+	float *normalsX = ScratchArena::GetThreadArena().Allocate<float>(3 * paddedCount);
+	float *normalsY = normalsX + paddedCount;
+	float *normalsZ = normalsY + paddedCount;
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		normalsX[i] = vertices[i].normal.x;
+		normalsY[i] = vertices[i].normal.y;
+		normalsZ[i] = vertices[i].normal.z;
+	}
+
+	// The arena memory is not initialized, clear the padding lanes
+	for (size_t i = vertexCount; i < paddedCount; i++)
+	{
+		normalsX[i] = normalsY[i] = normalsZ[i] = 0.0f;
+	}
+
+	const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	int iteration = 0;
+
+	while (iteration < maxIterations)
+	{
+		__m256 meansX[4], meansY[4], meansZ[4];
+		__m256i clusterIndices[4];
+
+		for (int j = 0; j < 4; j++)
+		{
+			meansX[j] = _mm256_set1_ps(outMeans[j].x);
+			meansY[j] = _mm256_set1_ps(outMeans[j].y);
+			meansZ[j] = _mm256_set1_ps(outMeans[j].z);
+			clusterIndices[j] = _mm256_set1_epi32(j);
+		}
+
+		double sums[4][3] = { 0 };
+		UINT counts[4] = { 0, 0, 0, 0 };
+
+		for (size_t blockStart = 0; blockStart < paddedCount; blockStart += sumBlockSize)
+		{
+			__m256 sumsX[4], sumsY[4], sumsZ[4];
+			__m256i countsPerLane[4];
+
+			for (int j = 0; j < 4; j++)
+			{
+				sumsX[j] = _mm256_setzero_ps();
+				sumsY[j] = _mm256_setzero_ps();
+				sumsZ[j] = _mm256_setzero_ps();
+				countsPerLane[j] = _mm256_setzero_si256();
+			}
+
+			size_t blockEnd = min(paddedCount, blockStart + sumBlockSize);
+
+			for (size_t i = blockStart; i < blockEnd; i += 8)
+			{
+				__m256 x = _mm256_loadu_ps(normalsX + i);
+				__m256 y = _mm256_loadu_ps(normalsY + i);
+				__m256 z = _mm256_loadu_ps(normalsZ + i);
+
+				// The padding lanes of the last 8 normals are excluded from the sums and counts
+				size_t laneCount = min((size_t)8, vertexCount - i);
+				__m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)laneCount), laneIndices);
+
+				// Current cluster of each vertex, never read past the end of the clusters array
+				byte current[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+				memcpy(current, outClusters + i, laneCount);
+				__m256i cluster = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)current));
+
+				// Squared distances to all the means
+				__m256 distances[4];
+
+				for (int j = 0; j < k; j++)
+				{
+					__m256 dx = _mm256_sub_ps(x, meansX[j]);
+					__m256 dy = _mm256_sub_ps(y, meansY[j]);
+					__m256 dz = _mm256_sub_ps(z, meansZ[j]);
+					distances[j] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+				}
+
+				// Start with the distance to the current mean and only switch to strictly closer means (same order as the scalar kernel)
+				__m256 minDistance = distances[0];
+
+				for (int j = 1; j < k; j++)
+				{
+					minDistance = _mm256_blendv_ps(minDistance, distances[j], _mm256_castsi256_ps(_mm256_cmpeq_epi32(cluster, clusterIndices[j])));
+				}
+
+				for (int j = 0; j < k; j++)
+				{
+					__m256 closer = _mm256_cmp_ps(distances[j], minDistance, _CMP_LT_OQ);
+					cluster = _mm256_blendv_epi8(cluster, clusterIndices[j], _mm256_castps_si256(closer));
+					minDistance = _mm256_blendv_ps(minDistance, distances[j], closer);
+				}
+
+				// Pack the 32 bit cluster indices to bytes and store them
+				__m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(cluster), _mm256_extracti128_si256(cluster, 1));
+				packed = _mm_packus_epi16(packed, packed);
+				_mm_storel_epi64((__m128i*)current, packed);
+				memcpy(outClusters + i, current, laneCount);
+
+				// Masked sums, the comparison result is -1 for each lane in the cluster which is subtracted from the count
+				for (int j = 0; j < k; j++)
+				{
+					__m256i inCluster = _mm256_and_si256(_mm256_cmpeq_epi32(cluster, clusterIndices[j]), valid);
+					__m256 mask = _mm256_castsi256_ps(inCluster);
+
+					sumsX[j] = _mm256_add_ps(sumsX[j], _mm256_and_ps(mask, x));
+					sumsY[j] = _mm256_add_ps(sumsY[j], _mm256_and_ps(mask, y));
+					sumsZ[j] = _mm256_add_ps(sumsZ[j], _mm256_and_ps(mask, z));
+					countsPerLane[j] = _mm256_sub_epi32(countsPerLane[j], inCluster);
+				}
+			}
+
+			for (int j = 0; j < k; j++)
+			{
+				alignas(32) UINT laneCounts[8];
+				_mm256_store_si256((__m256i*)laneCounts, countsPerLane[j]);
+
+				sums[j][0] += Sum(sumsX[j]);
+				sums[j][1] += Sum(sumsY[j]);
+				sums[j][2] += Sum(sumsZ[j]);
+
+				for (int lane = 0; lane < 8; lane++)
+				{
+					counts[j] += laneCounts[lane];
+				}
+			}
+		}
+
+		iteration++;
+
+		if (!UpdateMeans(outMeans, outVerticesPerMean, sums, counts, k))
+		{
+			break;
+		}
+	}
+
+	return iteration;
+}
+
+int PointCloudEngine::NormalClustering::ClusterReference(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters)
+{
+	const int k = Initialize(vertices, vertexCount, outMeans, outVerticesPerMean, outClusters);
+	int iteration = 0;
+	bool meanChanged = true;
+
+	while (meanChanged)
+	{
+		// Assign all the vertices to the closest mean to them
+		for (UINT i = 0; i < vertexCount; i++)
+		{
+			float minDistance = Vector3::Distance(vertices[i].normal, outMeans[outClusters[i]]);
+
+			for (UINT j = 0; j < k; j++)
+			{
+				float distance = Vector3::Distance(vertices[i].normal, outMeans[j]);
+
+				if (distance < minDistance)
+				{
+					outClusters[i] = j;
+					minDistance = distance;
+				}
+			}
+		}
+
+		// Calculate the new means from the vertices in each cluster
+		Vector3 newMeans[4];
+
+		for (int i = 0; i < k; i++)
+		{
+			outVerticesPerMean[i] = 0;
+		}
+
+		for (UINT i = 0; i < vertexCount; i++)
+		{
+			newMeans[outClusters[i]] += vertices[i].normal;
+			outVerticesPerMean[outClusters[i]] += 1;
+		}
+
+		meanChanged = false;
+		iteration++;
+
+		// Update the means
+		for (int i = 0; i < k; i++)
+		{
+			if (outVerticesPerMean[i] > 0)
+			{
+				newMeans[i] /= outVerticesPerMean[i];
+
+				if (Vector3::DistanceSquared(outMeans[i], newMeans[i]) > FLT_EPSILON)
+				{
+					meanChanged = true;
+				}
+
+				outMeans[i] = newMeans[i];
+			}
+		}
+	}
+
+	return iteration;
+}
+
+bool PointCloudEngine::NormalClustering::IsAVX2Supported()
+{
+	int cpuInfo[4];
+
+	// The processor has to support AVX and the operating system has to save the AVX registers (OSXSAVE and XCR0)
+	__cpuid(cpuInfo, 1);
+
+	bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+	bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+
+	if (!avx || !osxsave || ((_xgetbv(0) & 0x6) != 0x6))
+	{
+		return false;
+	}
+
+	__cpuidex(cpuInfo, 7, 0);
+
+	return (cpuInfo[1] & (1 << 5)) != 0;
+}
+
+int PointCloudEngine::NormalClustering::Initialize(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters)
+{
+	const int k = min(vertexCount, 4);
+
+	// Set initial means to the first k normals
+	for (int i = 0; i < 4; i++)
+	{
+		outMeans[i] = (i < k) ? vertices[i].normal : Vector3::Zero;
+		outVerticesPerMean[i] = (i < k) ? 1 : 0;
+	}
+
+	// All vertices start in the first cluster
+	ZeroMemory(outClusters, sizeof(byte) * vertexCount);
+
+	return k;
+}
+
+bool PointCloudEngine::NormalClustering::UpdateMeans(Vector3 (&means)[4], UINT (&verticesPerMean)[4], const double (&sums)[4][3], const UINT (&counts)[4], int k)
+{
+	bool meanChanged = false;
+
+	for (int i = 0; i < k; i++)
+	{
+		verticesPerMean[i] = counts[i];
+
+		// Empty clusters keep their previous mean
+		if (counts[i] > 0)
+		{
+			Vector3 newMean = Vector3(sums[i][0] / counts[i], sums[i][1] / counts[i], sums[i][2] / counts[i]);
+
+			if (Vector3::DistanceSquared(means[i], newMean) > FLT_EPSILON)
+			{
+				meanChanged = true;
+			}
+
+			means[i] = newMean;
+		}
+	}
+
+	return meanChanged;
+}
+
+double PointCloudEngine::NormalClustering::Sum(__m256 values)
+{
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, values);
+
+	double sum = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		sum += lanes[i];
+	}
+
+	return sum;
+}
\ No newline at end of file
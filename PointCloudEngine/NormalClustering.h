@@ -0,0 +1,38 @@
+#ifndef NORMALCLUSTERING_H
+#define NORMALCLUSTERING_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// K-means clustering of the vertex normals into (up to) 4 clusters for the octree node properties
+	// The AVX2 kernel assigns 8 normals at once from a structure of arrays copy and keeps the cluster sums and counts in registers
+	// Both kernels compare squared distances, which selects the same means as the euclidean distance without the square roots
+	class NormalClustering
+	{
+	public:
+		// Stop after this many iterations even when the means are still moving
+		static const int maxIterations = 32;
+
+		// Uses the AVX2 kernel when the processor supports it, otherwise the scalar kernel
+		// Returns the number of iterations, outClusters stores the mean index of each vertex, the means are not normalized
+		static int Cluster(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters);
+		static int ClusterScalar(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters);
+		static int ClusterAVX2(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters);
+
+		// Previous implementation with the euclidean distance and without an iteration limit, only used for comparisons
+		static int ClusterReference(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters);
+
+		static bool IsAVX2Supported();
+
+	private:
+		// The float sums of the AVX2 kernel are added to the double sums after this many vertices to keep the precision for large nodes
+		static const size_t sumBlockSize = 32768;
+
+		static int Initialize(const Vertex *vertices, size_t vertexCount, Vector3 (&outMeans)[4], UINT (&outVerticesPerMean)[4], byte *outClusters);
+		static bool UpdateMeans(Vector3 (&means)[4], UINT (&verticesPerMean)[4], const double (&sums)[4][3], const UINT (&counts)[4], int k);
+		static double Sum(__m256 values);
+	};
+}
+#endif
\ No newline at end of file
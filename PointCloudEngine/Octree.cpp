@@ -1,155 +1,1027 @@
 #include "Octree.h"
 
-PointCloudEngine::Octree::Octree(const std::wstring &pointcloudFile)
+// Position of a node relative to the bounding cube of the truncated node that the subtree is averaged for
+struct TruncationEntry
 {
-    if (!LoadFromOctreeFile())
+	UINT index;
+	Vector3 offset;
+	float size;
+};
+
+static void PushTruncationChildren(const PointCloudEngine::OctreeNode &node, const Vector3 &offset, float size, std::vector<TruncationEntry> &stack)
+{
+	UINT count = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		if (node.properties.childrenMask & (1 << i))
+		{
+			// Same child order as GetChildPosition, a set bit moves the child to the lower half of the axis
+			Vector3 childOffset = offset + 0.5f * size * Vector3((i & 0x4) ? 0.0f : 1.0f, (i & 0x2) ? 0.0f : 1.0f, (i & 0x1) ? 0.0f : 1.0f);
+			stack.push_back({ node.childrenStartOrLeafPositionFactors + count++, childOffset, 0.5f * size });
+		}
+	}
+}
+
+// Average of the leaf positions in the subtree as leaf position factors of the node, each subtree is only visited once
+static UINT GetAverageLeafPositionFactors(const PointCloudEngine::OctreeNode *nodes, const PointCloudEngine::OctreeNode &node, std::vector<TruncationEntry> &stack)
+{
+	Vector3 positionSum = Vector3::Zero;
+	UINT leafCount = 0;
+
+	stack.clear();
+	PushTruncationChildren(node, Vector3::Zero, 1.0f, stack);
+
+	while (!stack.empty())
+	{
+		TruncationEntry entry = stack.back();
+		const PointCloudEngine::OctreeNode &child = nodes[entry.index];
+		stack.pop_back();
+
+		if (child.IsLeafNode())
+		{
+			UINT factors = child.childrenStartOrLeafPositionFactors;
+			positionSum += entry.offset + entry.size * Vector3(((factors >> 16) & 0xff) / 255.0f, ((factors >> 8) & 0xff) / 255.0f, (factors & 0xff) / 255.0f);
+			leafCount++;
+		}
+		else
+		{
+			PushTruncationChildren(child, entry.offset, entry.size, stack);
+		}
+	}
+
+	Vector3 averagePosition = positionSum / (float)max(leafCount, 1u);
+
+	return (static_cast<UINT>(0xff * averagePosition.x) << 16) | (static_cast<UINT>(0xff * averagePosition.y) << 8) | static_cast<UINT>(0xff * averagePosition.z);
+}
+
+PointCloudEngine::Octree::Octree(const std::wstring &pointcloudFile, OctreeBuildProgress *progress) : Octree(pointcloudFile, settings->GetOctreeBuildParameters(), progress)
+{
+}
+
+PointCloudEngine::Octree::Octree(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress)
+{
+	// Only the copied build parameters are used while loading, the settings can change on the main thread at the same time
+	this->buildParameters = buildParameters;
+    pointcloudFilepath = pointcloudFile;
+	UINT64 pointcloudHash = GetPointcloudHash(pointcloudFile, buildParameters.threadCount, progress);
+	outOfCore = OctreeExternalBuilder(buildParameters).IsRequired(pointcloudFile);
+    octreeFilepath = GetOctreeFilepath(pointcloudFile, pointcloudHash, buildParameters.maxDepth, buildParameters.buildMode, buildParameters.useBottomUpAggregation, outOfCore);
+	mappedFile = new OctreeFile();
+
+	// The destructor is not called when the constructor throws (e.g. a canceled load), the mapping would keep the .octree file locked
+	try
+	{
+		// An up to date paged file can be opened without loading the whole octree
+		if (!buildParameters.usePaged || !OpenPagedOctree(progress))
+		{
+			LoadOrBuild(progress, pointcloudHash);
+
+			if (buildParameters.usePaged && !OpenPagedOctree(progress))
+			{
+				Benchmark::Log(L"Could not create the paged octree, all the nodes are kept in memory");
+			}
+
+			if (buildParameters.useSuccinct && !IsPaged())
+			{
+				CreateTopology();
+			}
+		}
+	}
+	catch (...)
+	{
+		SafeDelete(pageCache);
+		SafeDelete(topology);
+		SafeDelete(mappedFile);
+		throw;
+	}
+
+	// The traversal threads are only started by the first cpu traversal of a wide level, the cut is only created for an octree that was loaded successfully
+	SetTraversalThreadCount(buildParameters.traversalThreadCount);
+	cut = new OctreeCut();
+}
+
+PointCloudEngine::Octree::~Octree()
+{
+	SafeDelete(pageCache);
+	SafeDelete(topology);
+	SafeDelete(mappedFile);
+	SafeDelete(traversalThreadPool);
+	SafeDelete(cut);
+}
+
+void PointCloudEngine::Octree::LoadOrBuild(OctreeBuildProgress *progress, UINT64 pointcloudHash)
+{
+    if (!LoadFromOctreeFile(progress) && !LoadFromLegacyOctreeFile(progress) && !TruncateCachedOctree(progress, pointcloudHash))
     {
+        if (outOfCore)
+        {
+            OctreeExternalBuilder externalBuilder(buildParameters, progress);
+
+            // Too large to build in memory, stream the vertices through temporary files and write the .octree file directly
+            buildStatistics = externalBuilder.Build(pointcloudFilepath, octreeFilepath);
+            Benchmark::LogBuildStatistics(L"Octree build out of core", buildParameters.buildMode, buildParameters.useBottomUpAggregation, buildStatistics);
+
+            if (!LoadFromOctreeFile(progress))
+            {
+                throw std::exception("Could not load .octree file!");
+            }
+
+            return;
+        }
+
         // Try to load .pointcloud file here
         std::vector<Vertex> vertices;
 
-        if (!LoadPointcloudFile(vertices, rootPosition, rootSize, pointcloudFile))
+        if (!LoadPointcloudFile(vertices, rootPosition, rootSize, pointcloudFilepath, buildParameters.fileRead))
         {
             throw std::exception("Could not load .pointcloud file!");
         }
 
-		// Stores the indices in the nodes array of the children of a node
-		// Will only be used while creating the octree (for simplicity)
-		// Finding the correct child index is easier this way
-		std::vector<UINT> children;
+        if (progress != NULL)
+        {
+            progress->vertexCount = vertices.size();
+            progress->loadedVertexCount = vertices.size();
+        }
 
-        // Stores the nodes that should be created for each octree level
-        std::queue<OctreeNodeCreationEntry> nodeCreationQueue;
+        buildStatistics.vertexCount = vertices.size();
+        Benchmark::StartBuildStatistics(buildStatistics);
 
-        OctreeNodeCreationEntry rootEntry;
-        rootEntry.nodesIndex = UINT_MAX;
-        rootEntry.childrenIndex = UINT_MAX;
-        rootEntry.vertices = vertices;
-        rootEntry.position = rootPosition;
-        rootEntry.size = rootSize;
-        rootEntry.depth = 0;
+        // Create the nodes with multiple threads, the resulting layout does not depend on the thread count
+        // The builder partitions the loaded vertices in place instead of copying them for every node
+        OctreeBuilder octreeBuilder(buildParameters.buildMode, buildParameters.useBottomUpAggregation, buildParameters.maxDepth, buildParameters.threadCount, progress);
+        octreeBuilder.Build(nodes, vertices, rootPosition, rootSize);
 
-        nodeCreationQueue.push(rootEntry);
+        buildStatistics.nodeCount = nodes.size();
+        Benchmark::FinishBuildStatistics(buildStatistics);
+        Benchmark::LogBuildStatistics(L"Octree build", buildParameters.buildMode, buildParameters.useBottomUpAggregation, buildStatistics);
 
-        while (!nodeCreationQueue.empty())
-        {
-            // Remove the first entry from the queue
-            OctreeNodeCreationEntry first = nodeCreationQueue.front();
-            nodeCreationQueue.pop();
+        // Save the generated octree in a file, an existing file could not be loaded and is replaced
+        SaveToOctreeFile(true, progress);
+    }
+}
 
-            // Assign the index at which this node will be stored
-            first.nodesIndex = nodes.size();
+const std::vector<PointCloudEngine::OctreeNodeVertex>& PointCloudEngine::Octree::GetVertices(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> &outVertices)
+{
+	// Paged octrees are traversed from the root in every frame, the pages that finished loading change the result without any camera movement
+	if ((pageCache == NULL) && buildParameters.useIncrementalTraversal && (octreeConstantBufferData.level < 0) && ((GetNodeCount() > 0) || (topology != NULL)))
+	{
+		return cut->Update(GetNodes(), topology, GetRootEntry(), octreeConstantBufferData);
+	}
 
-            // Create the nodes and fill the queue
-            nodes.push_back(OctreeNode(nodeCreationQueue, nodes, children, first));
-        }
+	GetOutput(octreeConstantBufferData, &outVertices, NULL);
 
-		// Now the nodes actually store the childrenStartOrLeafPositionFactors index for the children array instead of the nodes array
-		for (auto it = nodes.begin(); it != nodes.end(); it++)
-		{
-			// Overwrite the index with one that is referencing the nodes array (that's fine because the nodes array stores children after each other and in order)
-			// Then there is no need to store the children array anymore
-			if (it->properties.childrenMask != 0)
-			{
-				it->childrenStartOrLeafPositionFactors = children[it->childrenStartOrLeafPositionFactors];
-			}
-		}
+	return outVertices;
+}
 
-        // Save the generated octree in a file
-        SaveToOctreeFile();
-    }
+void PointCloudEngine::Octree::GetEntries(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeTraversalEntry> &outEntries)
+{
+	GetOutput(octreeConstantBufferData, NULL, &outEntries);
 }
 
-std::vector<OctreeNodeVertex> PointCloudEngine::Octree::GetVertices(const OctreeConstantBuffer &octreeConstantBufferData) const
+void PointCloudEngine::Octree::GetOutput(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries)
+{
+	if (pageCache == NULL)
+	{
+		Traverse(octreeConstantBufferData, outVertices, outEntries);
+		return;
+	}
+
+	pageCache->BeginFrame();
+	Traverse(octreeConstantBufferData, outVertices, outEntries);
+
+	// Assume that the camera keeps moving with the same velocity and request the pages that will be needed then
+	// The pages of the current view are requested first and cannot be evicted by the prefetching
+	const float prefetchSeconds = 0.5f;
+	Vector3 cameraPosition = octreeConstantBufferData.localCameraPosition;
+	Vector3 prefetchOffset = Vector3::Zero;
+
+	if (hasPreviousCameraPosition && (dt > 0))
+	{
+		prefetchOffset = (cameraPosition - previousCameraPosition) * (float)(prefetchSeconds / dt);
+	}
+
+	previousCameraPosition = cameraPosition;
+	hasPreviousCameraPosition = true;
+
+	if ((octreeConstantBufferData.level < 0) && (prefetchOffset.LengthSquared() > 0))
+	{
+		// Move the view frustum with the camera, the planes keep their orientation
+		OctreeConstantBuffer prefetchConstantBufferData = octreeConstantBufferData;
+		prefetchConstantBufferData.localCameraPosition += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumNearTopLeft += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumNearTopRight += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumNearBottomLeft += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumNearBottomRight += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumFarTopLeft += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumFarTopRight += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumFarBottomLeft += prefetchOffset;
+		prefetchConstantBufferData.localViewFrustumFarBottomRight += prefetchOffset;
+
+		// Only the requested pages matter, the entries are cheaper to output than the vertices
+		Traverse(prefetchConstantBufferData, NULL, &prefetchEntries);
+	}
+
+	// Issue the reads of the pages of this frame and of the prefetching together
+	pageCache->SubmitRequests();
+}
+
+void PointCloudEngine::Octree::SetTraversalThreadCount(UINT threadCount)
+{
+	ReleaseTraversalThreads();
+
+	traversalThreadCount = (threadCount == 0) ? max(1u, std::thread::hardware_concurrency()) : threadCount;
+}
+
+UINT PointCloudEngine::Octree::GetTraversalThreadCount() const
+{
+	return traversalThreadCount;
+}
+
+void PointCloudEngine::Octree::ReleaseTraversalThreads()
+{
+	SafeDelete(traversalThreadPool);
+}
+
+void PointCloudEngine::Octree::Traverse(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries)
 {
 	// If the level is -1 then it is ignored and only the node vertices with the projected size smaller than the splat size are returned
 	// Otherwise the camera positiona and splat size is ignored and only the node vertices at the given octree level are returned
     // Use a queue instead of recursion to traverse the octree in the memory layout order (improves cache efficiency)
-    std::vector<OctreeNodeVertex> octreeVertices;
-	std::queue<OctreeNodeTraversalEntry> nodesQueue;
+	if (outVertices != NULL)
+	{
+		outVertices->clear();
+	}
+	else
+	{
+		outEntries->clear();
+	}
+
+	traversalQueue.clear();
+
+	const OctreeNode *octreeNodes = GetNodes();
+	OctreeNode topologyNode;
+	FrustumCuller frustumCuller(octreeConstantBufferData);
+
+	if ((GetNodeCount() == 0) && (pageCache == NULL) && (topology == NULL))
+	{
+		return;
+	}
+
+    // Check the root node first
+    traversalQueue.push_back(GetRootEntry());
+
+	// The queue only contains the nodes of one level behind the nodes of the previous level, the end of the queue is the end of the current level
+	size_t front = 0;
+
+	while (front < traversalQueue.size())
+	{
+		size_t levelEnd = traversalQueue.size();
+
+		if ((traversalThreadCount > 1) && (pageCache == NULL) && (levelEnd - front >= parallelTraversalMinWidth))
+		{
+			// Octrees that are never traversed on the cpu or only have narrow levels do not keep any threads running
+			if (traversalThreadPool == NULL)
+			{
+				traversalThreadPool = new ThreadPool(traversalThreadCount);
+			}
+
+			TraverseLevelParallel(front, levelEnd, frustumCuller, octreeConstantBufferData, outVertices, outEntries);
+			front = levelEnd;
+			continue;
+		}
+
+		while (front < levelEnd)
+		{
+			// The front of the queue is an index, the entries are copied since appending the children can move the queue
+			OctreeNodeTraversalEntry entries[FrustumCuller::batchSize];
+			int insidePlanes[FrustumCuller::batchSize];
+			UINT batchCount = (UINT)min(levelEnd - front, (size_t)FrustumCuller::batchSize);
 
+			std::copy(traversalQueue.begin() + front, traversalQueue.begin() + front + batchCount, entries);
+			frustumCuller.Classify(entries, batchCount, insidePlanes);
+			front += batchCount;
+
+			for (UINT i = 0; i < batchCount; i++)
+			{
+				if (insidePlanes[i] == FrustumCuller::outside)
+				{
+					// The whole cube is outside, don't add it or any of its children
+					continue;
+				}
+
+				const OctreeNodeTraversalEntry &entry = entries[i];
+				const OctreeNode *node = GetTraversalNode(octreeNodes, entry.index, topologyNode);
+				size_t queueSize = traversalQueue.size();
+
+				// Check the node, add the vertex or add its children to the queue
+				if (node->Traverse(traversalQueue, entry, insidePlanes[i], octreeConstantBufferData))
+				{
+					AppendOutput(node, entry, outVertices, outEntries);
+				}
+
+				// All the children are stored in the same page, draw the node itself instead until that page is loaded
+				if ((pageCache != NULL) && (traversalQueue.size() > queueSize) && !pageCache->RequestPage(traversalQueue[queueSize].index))
+				{
+					traversalQueue.resize(queueSize);
+					AppendOutput(node, entry, outVertices, outEntries);
+				}
+			}
+		}
+	}
+}
+
+PointCloudEngine::OctreeNodeTraversalEntry PointCloudEngine::Octree::GetRootEntry() const
+{
 	// Use this struct to compute the node positions and sizes at runtime
 	OctreeNodeTraversalEntry rootEntry;
 	rootEntry.index = 0;
 	rootEntry.position = rootPosition;
 	rootEntry.size = rootSize;
-	rootEntry.parentInsideViewFrustum = false;
+	rootEntry.parentInsidePlanes = 0;
 	rootEntry.depth = 0;
 
-    // Check the root node first
-    nodesQueue.push(rootEntry);
+	return rootEntry;
+}
 
-    while (!nodesQueue.empty())
-    {
-		OctreeNodeTraversalEntry entry = nodesQueue.front();
-        nodesQueue.pop();
+void PointCloudEngine::Octree::AppendOutput(const OctreeNode *node, const OctreeNodeTraversalEntry &entry, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries)
+{
+	if (outVertices != NULL)
+	{
+		outVertices->push_back(node->GetVertexFromTraversalEntry(entry));
+	}
+	else
+	{
+		outEntries->push_back(entry);
+	}
+}
 
-        // Check the node, add the vertex or add its children to the queue
-        nodes[entry.index].GetVertices(nodes, nodesQueue, octreeVertices, entry, octreeConstantBufferData);
-    }
+void PointCloudEngine::Octree::TraverseLevelParallel(size_t levelStart, size_t levelEnd, const FrustumCuller &frustumCuller, const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries)
+{
+	size_t levelWidth = levelEnd - levelStart;
+	size_t rangeCount = min((size_t)traversalThreadPool->GetThreadCount() * (size_t)traversalRangesPerThread, levelWidth / (size_t)minTraversalRangeWidth);
+
+	if (traversalRanges.size() < rangeCount)
+	{
+		traversalRanges.resize(rangeCount);
+	}
+
+	// The queue is not changed while the tasks read their ranges of it
+	for (size_t i = 0; i < rangeCount; i++)
+	{
+		TraversalRange &range = traversalRanges[i];
+		range.start = levelStart + (levelWidth * i) / rangeCount;
+		range.end = levelStart + (levelWidth * (i + 1)) / rangeCount;
+
+		traversalThreadPool->Submit([&, i]()
+		{
+			TraversalRange &range = traversalRanges[i];
+			const OctreeNode *octreeNodes = GetNodes();
+			OctreeNode topologyNode;
+
+			range.children.clear();
+			range.vertices.clear();
+			range.entries.clear();
+
+			// Each range appends into its own buffer of the same type as the output
+			std::vector<OctreeNodeVertex> *rangeVertices = (outVertices != NULL) ? &range.vertices : NULL;
+			std::vector<OctreeNodeTraversalEntry> *rangeEntries = (outVertices != NULL) ? NULL : &range.entries;
+
+			int insidePlanes[FrustumCuller::batchSize];
+
+			for (size_t j = range.start; j < range.end; j += FrustumCuller::batchSize)
+			{
+				UINT batchCount = (UINT)min(range.end - j, (size_t)FrustumCuller::batchSize);
+				frustumCuller.Classify(&traversalQueue[j], batchCount, insidePlanes);
+
+				for (UINT k = 0; k < batchCount; k++)
+				{
+					if (insidePlanes[k] != FrustumCuller::outside)
+					{
+						const OctreeNodeTraversalEntry &entry = traversalQueue[j + k];
+						const OctreeNode *node = GetTraversalNode(octreeNodes, entry.index, topologyNode);
+
+						if (node->Traverse(range.children, entry, insidePlanes[k], octreeConstantBufferData))
+						{
+							AppendOutput(node, entry, rangeVertices, rangeEntries);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	traversalThreadPool->Wait();
+
+	// The offsets of the ranges are the sums of the sizes of the ranges before them, each range then copies into its own part without locking
+	size_t queueSize = traversalQueue.size();
+	size_t outputCount = (outVertices != NULL) ? outVertices->size() : outEntries->size();
 
-    return octreeVertices;
+	for (size_t i = 0; i < rangeCount; i++)
+	{
+		TraversalRange &range = traversalRanges[i];
+		range.queueOffset = queueSize;
+		range.outputOffset = outputCount;
+		queueSize += range.children.size();
+		outputCount += (outVertices != NULL) ? range.vertices.size() : range.entries.size();
+	}
+
+	traversalQueue.resize(queueSize);
+
+	if (outVertices != NULL)
+	{
+		outVertices->resize(outputCount);
+	}
+	else
+	{
+		outEntries->resize(outputCount);
+	}
+
+	for (size_t i = 0; i < rangeCount; i++)
+	{
+		traversalThreadPool->Submit([&, i]()
+		{
+			TraversalRange &range = traversalRanges[i];
+			std::copy(range.children.begin(), range.children.end(), traversalQueue.begin() + range.queueOffset);
+
+			if (outVertices != NULL)
+			{
+				std::copy(range.vertices.begin(), range.vertices.end(), outVertices->begin() + range.outputOffset);
+			}
+			else
+			{
+				std::copy(range.entries.begin(), range.entries.end(), outEntries->begin() + range.outputOffset);
+			}
+		});
+	}
+
+	traversalThreadPool->Wait();
 }
 
-bool PointCloudEngine::Octree::LoadFromOctreeFile()
+const PointCloudEngine::OctreeNode* PointCloudEngine::Octree::GetTraversalNode(const OctreeNode *octreeNodes, UINT index, OctreeNode &topologyNode)
+{
+	if (pageCache != NULL)
+	{
+		return pageCache->GetNode(index);
+	}
+	else if (topology != NULL)
+	{
+		// Compute the children start index with the rank of the node
+		topologyNode = topology->GetNode(index);
+		return &topologyNode;
+	}
+
+	return octreeNodes + index;
+}
+
+bool PointCloudEngine::Octree::LoadFromOctreeFile(OctreeBuildProgress *progress)
 {
     // Try to load a previously saved octree file first before recreating the whole octree (saves a lot of time)
-    std::wstring filename = settings->pointcloudFile.substr(settings->pointcloudFile.find_last_of(L"\\/") + 1, settings->pointcloudFile.length());
+	// The nodes of a version 2 file are used directly from the mapping without reading the whole file
+	if (mappedFile->Open(octreeFilepath, buildParameters.fileRead, progress))
+	{
+		rootPosition = mappedFile->GetHeader().rootPosition;
+		rootSize = mappedFile->GetHeader().rootSize;
+		std::vector<OctreeNode>().swap(nodes);
+
+		if (mappedFile->IsCompressed())
+		{
+			// Compressed chunks are decoded into the nodes vector in parallel, the mapping is not needed afterwards
+			bool decompressed = mappedFile->Decompress(nodes, buildParameters.threadCount, progress);
+			mappedFile->Close();
+
+			return decompressed;
+		}
+
+		return true;
+	}
+
+    return false;
+}
+
+bool PointCloudEngine::Octree::LoadFromLegacyOctreeFile(OctreeBuildProgress *progress)
+{
+	// The first version stored the octree as Octrees/<name>.octree without any key, its properties were always aggregated exactly
+	if (buildParameters.useBottomUpAggregation)
+	{
+		return false;
+	}
+
+	std::wstring filename = pointcloudFilepath.substr(pointcloudFilepath.find_last_of(L"\\/") + 1);
+	std::wstring legacyOctreeFilepath = executableDirectory + L"/Octrees/" + filename.substr(0, filename.length() - 11) + L".octree";
+
+	if (!OctreeFile::ReadVersion1(legacyOctreeFilepath, nodes, rootPosition, rootSize, buildParameters.fileRead, progress))
+	{
+		return false;
+	}
+
+	// Migrate it to the version 2 file with the key of the current parameters, the old file is only removed when the new one was written
+	SaveToOctreeFile(true, progress);
+
+	if (GetFileAttributesW(octreeFilepath.c_str()) != INVALID_FILE_ATTRIBUTES)
+	{
+		DeleteFile(legacyOctreeFilepath.c_str());
+		Benchmark::Log(L"Migrated " + legacyOctreeFilepath + L" to " + octreeFilepath);
+	}
+
+	return true;
+}
+
+std::wstring PointCloudEngine::Octree::GetOctreeFilepath(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters)
+{
+	return GetOctreeFilepath(pointcloudFile, buildParameters, OctreeExternalBuilder(buildParameters).IsRequired(pointcloudFile));
+}
+
+std::wstring PointCloudEngine::Octree::GetOctreeFilepath(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters, bool outOfCore)
+{
+	return GetOctreeFilepath(pointcloudFile, GetPointcloudHash(pointcloudFile, buildParameters.threadCount), buildParameters.maxDepth, buildParameters.buildMode, buildParameters.useBottomUpAggregation, outOfCore);
+}
+
+std::wstring PointCloudEngine::Octree::GetOctreeFilepath(const std::wstring &pointcloudFile, UINT64 pointcloudHash, int maxOctreeDepth, OctreeBuildMode buildMode, bool useBottomUpAggregation, bool outOfCore, int truncationSourceDepth)
+{
+    std::wstring filename = pointcloudFile.substr(pointcloudFile.find_last_of(L"\\/") + 1, pointcloudFile.length());
     filename = filename.substr(0, filename.length() - 11);
-    octreeFilepath = executableDirectory + L"/Octrees/" + filename + L".octree";
 
-    // Try to load the octree from a file
-    std::ifstream octreeFile(octreeFilepath, std::ios::in | std::ios::binary);
+	// Every parameter that changes the nodes is part of the key, the file format itself is checked by the header
+	UINT64 keyData[5] = { pointcloudHash, (UINT64)maxOctreeDepth, (UINT64)buildMode, (UINT64)useBottomUpAggregation, (UINT64)outOfCore };
+	UINT64 key = OctreeFile::ComputeChecksum(keyData, sizeof(keyData));
 
-    // Only save the data when the file doesn't exist already
-    if (octreeFile.is_open())
-    {
-		// Read the root position as the first entry
-		octreeFile.read((char*)&rootPosition, sizeof(Vector3));
+	// Mix the bits so that parameters that only differ slightly do not result in similar keys
+	key = (key ^ (key >> 33)) * 0xff51afd7ed558ccdull;
+	key = key ^ (key >> 33);
 
-		// Then the root size
-		octreeFile.read((char*)&rootSize, sizeof(float));
+	std::wstringstream keyStream;
+	keyStream << std::hex << std::setw(16) << std::setfill(L'0') << key;
 
-        // Load the size of the nodes vector
-        UINT nodesSize;
-        octreeFile.read((char*)&nodesSize, sizeof(UINT));
+	if (truncationSourceDepth > 0)
+	{
+		keyStream << L"-truncated" << std::dec << truncationSourceDepth;
+	}
 
-        // Read the binary data directly into the nodes vector
-        nodes.resize(nodesSize);
-        octreeFile.read((char*)nodes.data(), nodesSize * sizeof(OctreeNode));
+    return GetOctreeDirectory() + L"/" + filename + L"_" + keyStream.str() + L".octree";
+}
 
-        // Stop here after loading the file
-        return true;
-    }
+std::wstring PointCloudEngine::Octree::GetOctreeDirectory()
+{
+	return settings->octreeCacheDirectory.empty() ? (executableDirectory + L"/Octrees") : settings->octreeCacheDirectory;
+}
 
-    return false;
+std::wstring PointCloudEngine::Octree::GetUniqueTemporaryName()
+{
+	static std::atomic<UINT> counter(0);
+
+	wchar_t computerName[MAX_COMPUTERNAME_LENGTH + 1] = L"";
+	DWORD computerNameLength = MAX_COMPUTERNAME_LENGTH + 1;
+	GetComputerNameW(computerName, &computerNameLength);
+
+	return std::wstring(computerName) + L"_" + std::to_wstring(GetCurrentProcessId()) + L"_" + std::to_wstring(counter++);
+}
+
+std::wstring PointCloudEngine::Octree::CreateTemporaryDirectory()
+{
+	std::wstring temporaryDirectory = GetOctreeDirectory() + L"/Temporary";
+	CreateDirectory(GetOctreeDirectory().c_str(), NULL);
+	CreateDirectory(temporaryDirectory.c_str(), NULL);
+
+	temporaryDirectory += L"/" + GetUniqueTemporaryName();
+	CreateDirectory(temporaryDirectory.c_str(), NULL);
+
+	return temporaryDirectory;
+}
+
+bool PointCloudEngine::Octree::TruncateOctreeFile(const std::wstring &sourceFile, const std::wstring &targetFile, int depth, const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress)
+{
+	OctreeFile source;
+	std::vector<OctreeNode> decompressedNodes;
+
+	if ((depth < 0) || !source.Open(sourceFile, buildParameters.fileRead) || source.IsPaged() || (source.GetHeader().nodeCount == 0))
+	{
+		return false;
+	}
+
+	const OctreeNode *sourceNodes = source.GetNodes();
+
+	if (source.IsCompressed())
+	{
+		if (!source.Decompress(decompressedNodes, buildParameters.threadCount, progress))
+		{
+			return false;
+		}
+
+		sourceNodes = decompressedNodes.data();
+	}
+
+	// Breadth first copy of the nodes, the copied inner nodes still store the children start in the source until their children are appended
+	std::vector<OctreeNode> truncatedNodes = { sourceNodes[0] };
+	std::vector<TruncationEntry> stack;
+	size_t levelEnd = 1;
+	int level = 0;
+
+	for (size_t i = 0; i < truncatedNodes.size(); i++)
+	{
+		if ((progress != NULL) && (i % truncationCancelInterval == 0))
+		{
+			progress->ThrowIfCanceled();
+		}
+
+		if (i == levelEnd)
+		{
+			levelEnd = truncatedNodes.size();
+			level++;
+		}
+
+		OctreeNode node = truncatedNodes[i];
+
+		if (node.IsLeafNode())
+		{
+			continue;
+		}
+
+		if (level < depth)
+		{
+			truncatedNodes[i].childrenStartOrLeafPositionFactors = (UINT)truncatedNodes.size();
+			truncatedNodes.insert(truncatedNodes.end(), sourceNodes + node.childrenStartOrLeafPositionFactors, sourceNodes + node.childrenStartOrLeafPositionFactors + __popcnt(node.properties.childrenMask));
+		}
+		else
+		{
+			// The properties already summarize the whole subtree, only the position of the leaf is missing
+			truncatedNodes[i].properties.childrenMask = 0;
+			truncatedNodes[i].childrenStartOrLeafPositionFactors = GetAverageLeafPositionFactors(sourceNodes, node, stack);
+		}
+	}
+
+	Vector3 sourceRootPosition = source.GetHeader().rootPosition;
+	float sourceRootSize = source.GetHeader().rootSize;
+	source.Close();
+
+	return OctreeFile::Write(targetFile, truncatedNodes.data(), truncatedNodes.size(), sourceRootPosition, sourceRootSize, buildParameters.compress, buildParameters.threadCount, progress);
 }
 
-void PointCloudEngine::Octree::SaveToOctreeFile()
+bool PointCloudEngine::Octree::TruncateCachedOctree(OctreeBuildProgress *progress, UINT64 pointcloudHash)
+{
+	std::wstring builtOctreeFilepath = octreeFilepath;
+
+	// The closest deeper octree has the fewest nodes to skip
+	for (int depth = buildParameters.maxDepth + 1; depth <= maxTruncationSourceDepth; depth++)
+	{
+		// Load the octree that was truncated from this depth before
+		octreeFilepath = GetOctreeFilepath(pointcloudFilepath, pointcloudHash, buildParameters.maxDepth, buildParameters.buildMode, buildParameters.useBottomUpAggregation, outOfCore, depth);
+
+		if (LoadFromOctreeFile(progress))
+		{
+			return true;
+		}
+
+		std::wstring sourceFile = GetOctreeFilepath(pointcloudFilepath, pointcloudHash, depth, buildParameters.buildMode, buildParameters.useBottomUpAggregation, outOfCore);
+
+		if (GetFileAttributesW(sourceFile.c_str()) == INVALID_FILE_ATTRIBUTES)
+		{
+			continue;
+		}
+
+		auto truncationStart = std::chrono::steady_clock::now();
+
+		if (TruncateOctreeFile(sourceFile, octreeFilepath, buildParameters.maxDepth, buildParameters, progress) && LoadFromOctreeFile(progress))
+		{
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - truncationStart).count();
+			Benchmark::Log(L"Octree truncated from depth " + std::to_wstring(depth) + L" to " + std::to_wstring(buildParameters.maxDepth) + L": " + std::to_wstring(GetNodeCount()) + L" nodes, " + std::to_wstring(seconds) + L"s");
+
+			return true;
+		}
+	}
+
+	// The octree is built with the key of the build parameters
+	octreeFilepath = builtOctreeFilepath;
+
+	return false;
+}
+
+void PointCloudEngine::Octree::SaveToOctreeFile(bool overwrite, OctreeBuildProgress *progress)
 {
     // Try to open a previously saved file
     std::wifstream file(octreeFilepath);
 
-    // Only save the data when the file doesn't exist already
-    if (!file.is_open())
+    // Only save the data when the file doesn't exist already or when it is outdated after editing the octree
+	// Mapped nodes are always the same as the ones in the file
+    if ((!file.is_open() || overwrite) && !mappedFile->IsOpen())
     {
+        file.close();
+
         // Save the octree in a file inside a new folder
-        CreateDirectory((executableDirectory + L"/Octrees").c_str(), NULL);
-        std::ofstream octreeFile(octreeFilepath, std::ios::out | std::ios::binary);
+        CreateDirectory(GetOctreeDirectory().c_str(), NULL);
 
-		// Write the root position
-		octreeFile.write((char*)&rootPosition, sizeof(Vector3));
+		if (!OctreeFile::Write(octreeFilepath, nodes.data(), nodes.size(), rootPosition, rootSize, buildParameters.compress, buildParameters.threadCount, progress))
+		{
+			ERROR_MESSAGE(L"Could not write " + octreeFilepath);
+		}
+    }
+}
 
-		// Then the root size
-		octreeFile.write((char*)&rootSize, sizeof(float));
+const PointCloudEngine::OctreeNode* PointCloudEngine::Octree::GetNodes() const
+{
+	// The released nodes vector may still return a pointer, it is never used instead of the pages or the topology
+	if (!HasNodesArray())
+	{
+		return NULL;
+	}
 
-        // Write the size of the nodes vector
-        UINT nodesSize = nodes.size();
-        octreeFile.write((char*)&nodesSize, sizeof(UINT));
+	return mappedFile->IsOpen() ? mappedFile->GetNodes() : nodes.data();
+}
 
-        // Write the nodes data in binary format
-        octreeFile.write((char*)nodes.data(), nodesSize * sizeof(OctreeNode));
+size_t PointCloudEngine::Octree::GetNodeCount() const
+{
+	if (!HasNodesArray())
+	{
+		return 0;
+	}
 
-        octreeFile.flush();
-        octreeFile.close();
-    }
+	return mappedFile->IsOpen() ? mappedFile->GetNodeCount() : nodes.size();
+}
+
+bool PointCloudEngine::Octree::IsPaged() const
+{
+	return pageCache != NULL;
+}
+
+bool PointCloudEngine::Octree::HasNodesArray() const
+{
+	return (pageCache == NULL) && (topology == NULL);
+}
+
+size_t PointCloudEngine::Octree::GetNodesMemoryUsage() const
+{
+	return (topology != NULL) ? topology->GetMemoryUsage() : (GetNodeCount() * sizeof(OctreeNode));
+}
+
+bool PointCloudEngine::Octree::InsertVertices(const std::vector<Vertex> &vertices)
+{
+	if (IsPaged())
+	{
+		Benchmark::Log(L"Paged octrees cannot be edited");
+		return false;
+	}
+
+	CopyMappedNodes();
+	OctreeEditor octreeEditor(nodes, rootPosition, rootSize, buildParameters);
+
+	return octreeEditor.Insert(vertices) && ApplyEdit(octreeEditor);
+}
+
+bool PointCloudEngine::Octree::DeleteVertices(const Vector3 &boxMin, const Vector3 &boxMax)
+{
+	if (IsPaged())
+	{
+		Benchmark::Log(L"Paged octrees cannot be edited");
+		return false;
+	}
+
+	CopyMappedNodes();
+	OctreeEditor octreeEditor(nodes, rootPosition, rootSize, buildParameters);
+	octreeEditor.Delete(boxMin, boxMax);
+
+	return ApplyEdit(octreeEditor);
+}
+
+bool PointCloudEngine::Octree::ApplyEdit(OctreeEditor &octreeEditor)
+{
+	auto editStart = std::chrono::steady_clock::now();
+
+	if (!octreeEditor.Apply(pointcloudFilepath))
+	{
+		return false;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - editStart).count();
+	Benchmark::Log(L"Octree edit: " + std::to_wstring(octreeEditor.GetRebuiltSubtreeCount()) + L" subtrees rebuilt, " + std::to_wstring(nodes.size()) + L" nodes, " + std::to_wstring(seconds) + L"s");
+
+	// The .pointcloud file changed and with it the key of the .octree file, the subtrees were rebuilt with the stored build parameters
+	outOfCore = OctreeExternalBuilder(buildParameters).IsRequired(pointcloudFilepath);
+	octreeFilepath = GetOctreeFilepath(pointcloudFilepath, buildParameters, outOfCore);
+	SaveToOctreeFile(true);
+
+	if (buildParameters.useSuccinct)
+	{
+		CreateTopology();
+	}
+
+	return true;
+}
+
+void PointCloudEngine::Octree::CopyMappedNodes()
+{
+	// The nodes of the cut change with the edit
+	cut->Clear();
+
+	if (topology != NULL)
+	{
+		nodes.resize(topology->GetNodeCount());
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			nodes[i] = topology->GetNode((UINT)i);
+		}
+
+		SafeDelete(topology);
+	}
+
+	if (mappedFile->IsOpen())
+	{
+		nodes.assign(mappedFile->GetNodes(), mappedFile->GetNodes() + mappedFile->GetNodeCount());
+		mappedFile->Close();
+	}
+}
+
+bool PointCloudEngine::Octree::OpenPagedOctree(OctreeBuildProgress *progress)
+{
+	std::wstring pagedOctreeFilepath = GetPagedOctreeFilepath();
+
+	// The paged file is outdated when the .octree file was built or edited after it, the .octree file can also be deleted to save space
+	WIN32_FILE_ATTRIBUTE_DATA octreeFileAttributes;
+	WIN32_FILE_ATTRIBUTE_DATA pagedFileAttributes;
+	bool pagedFileExists = GetFileAttributesExW(pagedOctreeFilepath.c_str(), GetFileExInfoStandard, &pagedFileAttributes);
+	bool octreeFileExists = GetFileAttributesExW(octreeFilepath.c_str(), GetFileExInfoStandard, &octreeFileAttributes);
+
+	if (!pagedFileExists || (octreeFileExists && (CompareFileTime(&pagedFileAttributes.ftLastWriteTime, &octreeFileAttributes.ftLastWriteTime) < 0)))
+	{
+		// The nodes have to be loaded or built first
+		if (GetNodeCount() == 0)
+		{
+			return false;
+		}
+
+		auto writeStart = std::chrono::steady_clock::now();
+
+		if (!OctreePageCache::Write(pagedOctreeFilepath, GetNodes(), GetNodeCount(), rootPosition, rootSize, progress))
+		{
+			return false;
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+		Benchmark::Log(L"Paged octree written: " + pagedOctreeFilepath + L", " + std::to_wstring(seconds) + L"s");
+	}
+
+	pageCache = new OctreePageCache(buildParameters.pageCacheBudget, buildParameters.fileRead);
+
+	if (!pageCache->Open(pagedOctreeFilepath))
+	{
+		SafeDelete(pageCache);
+		return false;
+	}
+
+	// Only the pages are used from now on
+	rootPosition = pageCache->GetHeader().rootPosition;
+	rootSize = pageCache->GetHeader().rootSize;
+	mappedFile->Close();
+	std::vector<OctreeNode>().swap(nodes);
+
+	Benchmark::Log(L"Paged octree: " + std::to_wstring(pageCache->GetNodeCount()) + L" nodes in " + std::to_wstring(pageCache->GetPageCount()) + L" pages, " + std::to_wstring(buildParameters.pageCacheBudget) + L" MB budget");
+
+	return true;
+}
+
+std::wstring PointCloudEngine::Octree::GetPagedOctreeFilepath() const
+{
+	return octreeFilepath.substr(0, octreeFilepath.length() - 7) + L".paged.octree";
+}
+
+void PointCloudEngine::Octree::CreateTopology()
+{
+	// The nodes are only replaced by the topology after it was created from them
+	OctreeTopology *createdTopology = new OctreeTopology();
+
+	if (!createdTopology->Create(GetNodes(), GetNodeCount()))
+	{
+		Benchmark::Log(L"The octree nodes are not in breadth first order, the succinct topology is not used");
+		SafeDelete(createdTopology);
+		return;
+	}
+
+	topology = createdTopology;
+
+	// The nodes are restored from the topology when the octree is edited
+	mappedFile->Close();
+	std::vector<OctreeNode>().swap(nodes);
+}
+
+UINT64 PointCloudEngine::Octree::HashFile(const std::wstring &filename, UINT threadCount, OctreeBuildProgress *progress)
+{
+	const UINT64 blockSize = FileHasher::blockSize;
+	UINT64 fileSize = 0;
+	std::vector<UINT64> blockChecksums;
+
+	HANDLE file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	HANDLE mapping = NULL;
+	const byte *view = NULL;
+	LARGE_INTEGER size;
+
+	if ((file != INVALID_HANDLE_VALUE) && GetFileSizeEx(file, &size) && (size.QuadPart > 0))
+	{
+		fileSize = size.QuadPart;
+		mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		view = (mapping != NULL) ? (const byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	}
+
+	if (view != NULL)
+	{
+		// Each thread reads its own blocks from the mapping, the blocks are a multiple of the checksum word size
+		blockChecksums.resize((fileSize + blockSize - 1) / blockSize);
+		ThreadPool threadPool(threadCount);
+
+		for (size_t i = 0; i < blockChecksums.size(); i++)
+		{
+			threadPool.Submit([&, i]()
+			{
+				// Throwing here would leave the file mapped, the canceled hash is never used
+				if ((progress != NULL) && progress->canceled)
+				{
+					return;
+				}
+
+				UINT64 blockStart = i * blockSize;
+				blockChecksums[i] = OctreeFile::ComputeChecksum(view + blockStart, min(blockSize, fileSize - blockStart));
+			});
+		}
+
+		threadPool.Wait();
+		UnmapViewOfFile(view);
+	}
+
+	if (mapping != NULL)
+	{
+		CloseHandle(mapping);
+	}
+
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file);
+	}
+
+	if (progress != NULL)
+	{
+		progress->ThrowIfCanceled();
+	}
+
+	// Missing files and files that cannot be mapped only hash their size
+	return OctreeFile::ComputeChecksum(blockChecksums.data(), blockChecksums.size() * sizeof(UINT64), OctreeFile::ComputeChecksum(&fileSize, sizeof(UINT64)));
+}
+
+UINT64 PointCloudEngine::Octree::GetPointcloudHash(const std::wstring &pointcloudFile, UINT threadCount, OctreeBuildProgress *progress)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+	if (!GetFileAttributesExW(pointcloudFile.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return HashFile(pointcloudFile, threadCount, progress);
+	}
+
+	UINT64 fileSize = ((UINT64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	UINT64 lastWriteTime = ((UINT64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+
+	// Size, last write time and content hash
+	UINT64 hashData[3] = { 0, 0, 0 };
+	std::ifstream hashFile(GetHashFilepath(pointcloudFile), std::ios::in | std::ios::binary);
+
+	if (hashFile.read((char*)hashData, sizeof(hashData)) && (hashData[0] == fileSize) && (hashData[1] == lastWriteTime))
+	{
+		return hashData[2];
+	}
+
+	hashFile.close();
+
+	// The size and last write time from before hashing, a file that changes while it is hashed is hashed again the next time
+	UINT64 hash = HashFile(pointcloudFile, threadCount, progress);
+	SaveHashFile(pointcloudFile, fileSize, lastWriteTime, hash);
+
+	return hash;
+}
+
+void PointCloudEngine::Octree::SavePointcloudHash(const std::wstring &pointcloudFile, UINT64 hash)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+	if (GetFileAttributesExW(pointcloudFile.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		UINT64 fileSize = ((UINT64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+		UINT64 lastWriteTime = ((UINT64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+		SaveHashFile(pointcloudFile, fileSize, lastWriteTime, hash);
+	}
+}
+
+void PointCloudEngine::Octree::SaveHashFile(const std::wstring &pointcloudFile, UINT64 fileSize, UINT64 lastWriteTime, UINT64 hash)
+{
+	UINT64 hashData[3] = { fileSize, lastWriteTime, hash };
+
+	CreateDirectory(GetOctreeDirectory().c_str(), NULL);
+	std::ofstream outputFile(GetHashFilepath(pointcloudFile), std::ios::out | std::ios::binary | std::ios::trunc);
+	outputFile.write((char*)hashData, sizeof(hashData));
+}
+
+std::wstring PointCloudEngine::Octree::GetHashFilepath(const std::wstring &pointcloudFile)
+{
+	// The .hash file is named after the full path, files with the same name in different folders do not share it
+	std::wstring filename = pointcloudFile.substr(pointcloudFile.find_last_of(L"\\/") + 1);
+	std::wstringstream pathStream;
+	pathStream << std::hex << std::setw(16) << std::setfill(L'0') << OctreeFile::ComputeChecksum(pointcloudFile.data(), pointcloudFile.length() * sizeof(wchar_t));
+
+	return GetOctreeDirectory() + L"/" + filename + L"_" + pathStream.str() + L".hash";
 }
@@ -9,19 +9,176 @@ namespace PointCloudEngine
     class Octree
     {
     public:
-        Octree(const std::wstring &pointcloudFile);
+		// The optional progress is updated while loading or building, canceling it throws an exception
+		// Octrees that are loaded in the background get a copy of the build parameters, the first constructor copies the current settings on the calling thread
+        Octree(const std::wstring &pointcloudFile, OctreeBuildProgress *progress = NULL);
+		Octree(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress = NULL);
+		~Octree();
 
-        std::vector<OctreeNodeVertex> GetVertices(const OctreeConstantBuffer &octreeConstantBufferData) const;
-        bool LoadFromOctreeFile();
-        void SaveToOctreeFile();
+		// Replaces the content of the output vertices, its capacity and the traversal queue are reused in the next call
+		// The vertices are the same and in the same order for every traversal thread count
+		// With useIncrementalTraversal of the build parameters the level of detail cut of the last call is updated instead, the vertices are the same but in depth first order
+		// Returns the vertices to draw, these are the output vertices or the vertices of the cut that are not copied into the output (valid until the next call)
+        const std::vector<OctreeNodeVertex>& GetVertices(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> &outVertices);
+
+		// Same traversal that only outputs the entries of the drawn nodes (node index, position, size), like the vertex append buffer of the gpu traversal
+		// The properties are not copied, they are read from the nodes by index when drawing, the entries are always traversed from the root
+		void GetEntries(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeTraversalEntry> &outEntries);
+
+		// A thread count of 0 uses all the hardware threads, with 1 the octree is traversed only by the calling thread
+		// The threads are started by the first traversal of a level that is wide enough to be split
+		void SetTraversalThreadCount(UINT threadCount);
+		UINT GetTraversalThreadCount() const;
+		// Stops the traversal threads while the octree is not traversed on the cpu (e.g. with the gpu traversal), the next wide level starts them again
+		void ReleaseTraversalThreads();
+		// Version 2 files are mapped into memory, version 1 files are only migrated from their old path while loading or building (see LoadFromLegacyOctreeFile)
+        bool LoadFromOctreeFile(OctreeBuildProgress *progress = NULL);
+        void SaveToOctreeFile(bool overwrite = false, OctreeBuildProgress *progress = NULL);
+
+		// Points into the mapped .octree file or into the nodes vector after building or editing the octree
+		// Paged and succinct octrees do not keep the nodes array, the nodes are NULL and the count is zero then
+		const OctreeNode* GetNodes() const;
+		size_t GetNodeCount() const;
+
+		// With settings->usePagedOctree the nodes are read from a paged .octree file by the page cache while traversing
+		bool IsPaged() const;
+		// False for paged and succinct octrees, only the nodes array can be uploaded for the gpu traversal
+		bool HasNodesArray() const;
+
+		// Bytes of the nodes array or of the succinct topology (settings->useSuccinctOctree)
+		size_t GetNodesMemoryUsage() const;
+
+		// The .octree files are cached in the octree directory with a key that hashes the .pointcloud content and the build parameters that change the nodes
+		// Octrees of other files or build parameters are kept next to each other, the directory can be shared between machines
+		// The content hash is cached next to the .octree files with the size and last write time of the .pointcloud file, only a changed file is read and hashed again
+		// Whether the octree is built out of core is part of the key, the nodes above the out of core subtrees are always aggregated bottom up
+		static std::wstring GetOctreeFilepath(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters);
+		static std::wstring GetOctreeFilepath(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters, bool outOfCore);
+
+		// Truncated octrees get the depth of their source as additional key component, a built octree with the same parameters is never replaced by them
+		static std::wstring GetOctreeFilepath(const std::wstring &pointcloudFile, UINT64 pointcloudHash, int maxOctreeDepth, OctreeBuildMode buildMode, bool useBottomUpAggregation, bool outOfCore, int truncationSourceDepth = 0);
+
+		// Stores the content hash of a .pointcloud file that was hashed while writing it (see FileHasher), it is not read and hashed again when loading it
+		static void SavePointcloudHash(const std::wstring &pointcloudFile, UINT64 hash);
+
+		// The settings->octreeCacheDirectory or the Octrees folder next to the executable
+		static std::wstring GetOctreeDirectory();
+
+		// Unique name of the computer, process id and a counter of this process, the octree directory can be shared by processes on other machines
+		static std::wstring GetUniqueTemporaryName();
+
+		// Creates a new empty directory in the Temporary folder of the octree directory, each build writes its temporary files into its own directory
+		static std::wstring CreateTemporaryDirectory();
+
+		// Writes the nodes of the source .octree file up to the depth in one pass, the inner nodes at the depth become leaves
+		// Their leaf position factors are the average of the leaf positions in their subtree (instead of the average vertex position of a build)
+		// The truncated octrees differ from a build at that depth and are cached under their own key that includes the source depth
+		// Returns false when the source file cannot be read or is paged, a canceled progress throws an exception
+		// Only the compression, thread count and file read parameters of the build parameters are used
+		static bool TruncateOctreeFile(const std::wstring &sourceFile, const std::wstring &targetFile, int depth, const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress = NULL);
+
+		// Adds the vertices to the octree and the .pointcloud file, only the subtrees that change are built again
+		// Returns false without any changes when a vertex is outside of the root bounding cube
+		bool InsertVertices(const std::vector<Vertex> &vertices);
+
+		// Removes all the vertices inside the axis aligned box (in object space) from the octree and the .pointcloud file
+		bool DeleteVertices(const Vector3 &boxMin, const Vector3 &boxMax);
 
         // Stores the hole octree, the root is the first element then all the children of the root node follow and so on
+		// Empty while the nodes are mapped from the .octree file
         std::vector<OctreeNode> nodes;
 		Vector3 rootPosition;
 		float rootSize = 0;
 
+		// Only filled when the octree is built instead of loaded from a file
+		OctreeBuildStatistics buildStatistics;
+
 	private:
+		OctreeBuildParameters buildParameters;
+		bool outOfCore = false;
 		std::wstring octreeFilepath;
+		std::wstring pointcloudFilepath;
+		OctreeFile *mappedFile = NULL;
+		OctreePageCache *pageCache = NULL;
+		OctreeTopology *topology = NULL;
+		OctreeCut *cut = NULL;
+
+		// Used to predict the camera position for prefetching the pages
+		Vector3 previousCameraPosition;
+		bool hasPreviousCameraPosition = false;
+		std::vector<OctreeNodeTraversalEntry> prefetchEntries;
+
+		// Breadth first traversal queue that is only appended to during a traversal, it is kept to avoid the allocations in every frame
+		std::vector<OctreeNodeTraversalEntry> traversalQueue;
+
+		// Contiguous part of a level of the traversal queue, the task of the range appends the children and the output into its own buffers
+		// The buffers of the ranges are appended in order afterwards, which results in the same queue and output as traversing with one thread
+		struct TraversalRange
+		{
+			size_t start;
+			size_t end;
+			size_t queueOffset;
+			size_t outputOffset;
+			std::vector<OctreeNodeTraversalEntry> children;
+			std::vector<OctreeNodeVertex> vertices;
+			std::vector<OctreeNodeTraversalEntry> entries;
+		};
+
+		// Levels narrower than this are traversed by the calling thread, the tasks would cost more than they save
+		static const size_t parallelTraversalMinWidth = 4096;
+		static const size_t minTraversalRangeWidth = 1024;
+		static const size_t traversalRangesPerThread = 4;
+
+		// NULL until a level is traversed in parallel, the ranges keep their buffers between the frames
+		UINT traversalThreadCount = 1;
+		ThreadPool *traversalThreadPool = NULL;
+		std::vector<TraversalRange> traversalRanges;
+
+		// Cached octrees up to this depth with the same .pointcloud file and build parameters are truncated instead of building a new octree
+		static const int maxTruncationSourceDepth = 32;
+
+		// Copied nodes between the checks of the progress while truncating
+		static const size_t truncationCancelInterval = 1 << 20;
+
+		void LoadOrBuild(OctreeBuildProgress *progress, UINT64 pointcloudHash);
+		bool TruncateCachedOctree(OctreeBuildProgress *progress, UINT64 pointcloudHash);
+
+		// Reads a version 1 file from the old path without key when no keyed file exists, it is rewritten under the keyed path and removed
+		bool LoadFromLegacyOctreeFile(OctreeBuildProgress *progress);
+
+		// Traverses the octree and requests the pages of a paged octree, the drawn nodes are output either as vertices or as entries (the other output is NULL)
+		void GetOutput(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries);
+		void Traverse(const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries);
+		static void AppendOutput(const OctreeNode *node, const OctreeNodeTraversalEntry &entry, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries);
+		OctreeNodeTraversalEntry GetRootEntry() const;
+
+		// Splits the level of the traversal queue into ranges that are traversed in parallel, only used without the page cache since requesting pages is not thread safe
+		void TraverseLevelParallel(size_t levelStart, size_t levelEnd, const FrustumCuller &frustumCuller, const OctreeConstantBuffer &octreeConstantBufferData, std::vector<OctreeNodeVertex> *outVertices, std::vector<OctreeNodeTraversalEntry> *outEntries);
+
+		// The node is either in the nodes array, in the page cache or decoded from the succinct topology into the given node
+		const OctreeNode* GetTraversalNode(const OctreeNode *octreeNodes, UINT index, OctreeNode &topologyNode);
+
+		// Creates the paged file from the loaded nodes when it is missing or older than the .octree file, the loaded nodes are released afterwards
+		bool OpenPagedOctree(OctreeBuildProgress *progress);
+		std::wstring GetPagedOctreeFilepath() const;
+
+		// Replaces the nodes with the succinct topology, the nodes are kept when their layout does not allow it
+		void CreateTopology();
+
+		// Word wise checksum of 64 MB blocks in parallel, the block checksums are combined in order (independent of the thread count)
+		// The remaining blocks are skipped when the progress is canceled, the exception is thrown after the file is unmapped
+		static UINT64 HashFile(const std::wstring &filename, UINT threadCount, OctreeBuildProgress *progress = NULL);
+
+		// Content hash from the .hash file in the octree directory when the size and last write time of the .pointcloud file still match, otherwise hashes the file and updates the .hash file
+		static UINT64 GetPointcloudHash(const std::wstring &pointcloudFile, UINT threadCount, OctreeBuildProgress *progress = NULL);
+		static void SaveHashFile(const std::wstring &pointcloudFile, UINT64 fileSize, UINT64 lastWriteTime, UINT64 hash);
+		static std::wstring GetHashFilepath(const std::wstring &pointcloudFile);
+
+		bool ApplyEdit(OctreeEditor &octreeEditor);
+
+		// The editor changes the nodes vector, copy the mapped nodes into it and close the file so that it can be replaced
+		// The nodes of a succinct octree are restored from the topology
+		void CopyMappedNodes();
     };
 }
 
@@ -31,7 +31,7 @@ struct OctreeNodeTraversalEntry
 	uint index;
 	float3 position;
 	float size;
-	bool parentInsideViewFrustum;
+	int parentInsidePlanes;
 	int depth;
 };
 
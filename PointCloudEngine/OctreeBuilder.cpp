@@ -0,0 +1,696 @@
+#include "OctreeBuilder.h"
+
+struct PointCloudEngine::OctreeBuilder::OctreeBuildNode
+{
+	OctreeNode node;
+	OctreeNodeCreationEntry entry;
+	byte childCount = 0;
+	OctreeBuildNode* children = NULL;
+};
+
+PointCloudEngine::OctreeBuilder::OctreeBuilder(OctreeBuildMode buildMode, bool useBottomUpAggregation, int maxDepth, UINT threadCount, OctreeBuildProgress *progress)
+{
+	this->buildMode = buildMode;
+	this->useBottomUpAggregation = useBottomUpAggregation;
+	this->maxDepth = maxDepth;
+	this->progress = progress;
+	threadPool = new ThreadPool(threadCount);
+	nodeCount = 0;
+
+	for (UINT i = 0; i <= threadPool->GetThreadCount(); i++)
+	{
+		nodeArenas.push_back(new ScratchArena());
+	}
+}
+
+PointCloudEngine::OctreeBuilder::~OctreeBuilder()
+{
+	SafeDelete(threadPool);
+
+	for (auto it = nodeArenas.begin(); it != nodeArenas.end(); it++)
+	{
+		SafeDelete(*it);
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::Build(std::vector<OctreeNode> &outNodes, std::vector<Vertex> &vertices, const Vector3 &rootPosition, const float &rootSize, int rootDepth)
+{
+	// The creation entries and the children start indices are 32 bit, larger point clouds are split by the OctreeExternalBuilder
+	if (vertices.size() > UINT_MAX)
+	{
+		throw std::exception("Too many vertices for an octree build in memory!");
+	}
+
+	// Only one array of vertices exists during the build, the nodes store index ranges into it
+	this->vertices = &vertices;
+	this->rootDepth = rootDepth;
+
+	if ((buildMode == OctreeBuildMode::Morton) && (maxDepth - rootDepth <= maxMortonDepth))
+	{
+		BuildMorton(outNodes, rootPosition, rootSize);
+	}
+	else
+	{
+		BuildTopDown(outNodes, rootPosition, rootSize);
+	}
+
+	this->vertices = NULL;
+	ThrowIfCanceled();
+
+	if (outNodes.size() > OctreeNode::maxNodeCount)
+	{
+		throw std::exception("Octrees with more than 4G nodes are not supported!");
+	}
+}
+
+const PointCloudEngine::OctreeNodeClusters& PointCloudEngine::OctreeBuilder::GetRootClusters() const
+{
+	return rootClusters;
+}
+
+void PointCloudEngine::OctreeBuilder::BuildTopDown(std::vector<OctreeNode> &outNodes, const Vector3 &rootPosition, const float &rootSize)
+{
+	OctreeNodeCreationEntry rootEntry;
+	rootEntry.vertexStart = 0;
+	rootEntry.vertexCount = vertices->size();
+	rootEntry.position = rootPosition;
+	rootEntry.size = rootSize;
+	rootEntry.depth = rootDepth;
+
+	OctreeBuildNode *root = new (nodeArenas[threadPool->GetQueueIndex()]->Allocate<OctreeBuildNode>(1)) OctreeBuildNode();
+	nodeCount = 1;
+
+	// Create the whole tree, the subtrees are created by the worker threads as soon as their parent is split
+	threadPool->Submit([this, root, rootEntry]() { CreateSubtree(root, rootEntry); });
+	threadPool->Wait();
+
+	// Assign the breadth first indices (this is the only sequential part)
+	std::vector<std::vector<OctreeNodeCreationEntry>> levels;
+
+	if (!IsCanceled())
+	{
+		Flatten(root, outNodes, useBottomUpAggregation ? &levels : NULL);
+	}
+
+	// The temporary tree is freed at once, the arenas keep their blocks for the next build with this builder
+	for (auto it = nodeArenas.begin(); it != nodeArenas.end(); it++)
+	{
+		(*it)->Reset();
+	}
+
+	ThrowIfCanceled();
+
+	if (useBottomUpAggregation)
+	{
+		AggregateProperties(outNodes, levels);
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::CreateSubtree(OctreeBuildNode *buildNode, const OctreeNodeCreationEntry &entry)
+{
+	if (IsCanceled())
+	{
+		return;
+	}
+
+	if (useBottomUpAggregation)
+	{
+		// Only create the topology here, the properties are aggregated from the leaves to the root after flattening
+		buildNode->node.properties.childrenMask = 0;
+		buildNode->entry = entry;
+	}
+	else
+	{
+		// Calculate the properties of this node
+		buildNode->node = OctreeNode(*vertices, entry, maxDepth, (entry.depth == rootDepth) ? &rootClusters : NULL);
+	}
+
+	if (progress != NULL)
+	{
+		progress->AddNodes(entry.depth, 1);
+	}
+
+	if (OctreeNode::IsLeafEntry(entry, maxDepth))
+	{
+		if (progress != NULL)
+		{
+			progress->partitionedVertexCount += entry.vertexCount;
+		}
+
+		return;
+	}
+
+	// Reorder the vertices of this node in place so that the vertices of each child cube are stored after each other
+	UINT childVertexCounts[8];
+	Partition(entry, childVertexCounts);
+
+	for (int i = 0; i < 8; i++)
+	{
+		if (childVertexCounts[i] > 0)
+		{
+			// Add this entry to the mask
+			buildNode->node.properties.childrenMask |= 1 << i;
+			buildNode->childCount++;
+		}
+	}
+
+	// The parent allocates the storage for its children from the arena of its thread, each child is written by exactly one task
+	buildNode->children = nodeArenas[threadPool->GetQueueIndex()]->Allocate<OctreeBuildNode>(buildNode->childCount);
+	nodeCount += buildNode->childCount;
+
+	for (byte i = 0; i < buildNode->childCount; i++)
+	{
+		new (&buildNode->children[i]) OctreeBuildNode();
+	}
+
+	byte count = 0;
+	UINT childVertexStart = entry.vertexStart;
+
+	for (int i = 0; i < 8; i++)
+	{
+		if (childVertexCounts[i] > 0)
+		{
+			OctreeBuildNode *childBuildNode = &buildNode->children[count++];
+
+			OctreeNodeCreationEntry childEntry;
+			childEntry.vertexStart = childVertexStart;
+			childEntry.vertexCount = childVertexCounts[i];
+			childEntry.position = OctreeNode::GetChildPosition(entry.position, entry.size, i);
+			childEntry.size = entry.size * 0.5f;
+			childEntry.depth = entry.depth + 1;
+
+			childVertexStart += childVertexCounts[i];
+
+			if (childEntry.vertexCount < minTaskVertexCount)
+			{
+				// Not worth the overhead of a new task
+				CreateSubtree(childBuildNode, childEntry);
+			}
+			else
+			{
+				// Other workers can steal this subtree, the vertex ranges of different subtrees never overlap
+				threadPool->Submit([this, childBuildNode, childEntry]() { CreateSubtree(childBuildNode, childEntry); });
+			}
+		}
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::Partition(const OctreeNodeCreationEntry &entry, UINT (&outChildVertexCounts)[8])
+{
+	Vertex *nodeVertices = vertices->data() + entry.vertexStart;
+
+	// Count the vertices that fit into each child cube
+	ZeroMemory(outChildVertexCounts, sizeof(UINT) * 8);
+
+	for (UINT i = 0; i < entry.vertexCount; i++)
+	{
+		outChildVertexCounts[OctreeNode::GetChildIndex(entry.position, nodeVertices[i].position)]++;
+	}
+
+	// Each child cube gets a contiguous range, next stores the first position in each range that is not sorted yet
+	UINT next[8];
+	UINT end[8];
+	UINT start = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		next[i] = start;
+		start += outChildVertexCounts[i];
+		end[i] = start;
+	}
+
+	// Swap every vertex directly into the range of its child cube (in place radix partition without any additional memory)
+	for (int i = 0; i < 8; i++)
+	{
+		while (next[i] < end[i])
+		{
+			int childIndex = OctreeNode::GetChildIndex(entry.position, nodeVertices[next[i]].position);
+
+			if (childIndex == i)
+			{
+				next[i]++;
+			}
+			else
+			{
+				std::swap(nodeVertices[next[i]], nodeVertices[next[childIndex]]);
+				next[childIndex]++;
+			}
+		}
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::Flatten(OctreeBuildNode *root, std::vector<OctreeNode> &outNodes, std::vector<std::vector<OctreeNodeCreationEntry>> *outLevels)
+{
+	// Stores the root first then all the children of the root node follow and so on (same order as a queue traversal)
+	// The children of a node are stored right after each other, therefore only the start index has to be assigned
+	outNodes.clear();
+	outNodes.reserve(nodeCount);
+
+	std::vector<OctreeBuildNode*> level = { root };
+	std::vector<OctreeBuildNode*> nextLevel;
+
+	while (!level.empty())
+	{
+		// The next level starts right after the nodes of this level
+		size_t levelEnd = outNodes.size() + level.size();
+		nextLevel.clear();
+
+		// The vertex ranges are only required for the bottom up aggregation
+		if (outLevels != NULL)
+		{
+			outLevels->push_back(std::vector<OctreeNodeCreationEntry>());
+			outLevels->back().reserve(level.size());
+
+			for (auto it = level.begin(); it != level.end(); it++)
+			{
+				outLevels->back().push_back((*it)->entry);
+			}
+		}
+
+		for (auto it = level.begin(); it != level.end(); it++)
+		{
+			OctreeBuildNode *buildNode = *it;
+			OctreeNode node = buildNode->node;
+
+			if (buildNode->childCount > 0)
+			{
+				node.childrenStartOrLeafPositionFactors = levelEnd + nextLevel.size();
+
+				for (byte i = 0; i < buildNode->childCount; i++)
+				{
+					nextLevel.push_back(&buildNode->children[i]);
+				}
+			}
+
+			outNodes.push_back(node);
+		}
+
+		// Both level arrays keep their capacity
+		level.swap(nextLevel);
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::BuildMorton(std::vector<OctreeNode> &outNodes, const Vector3 &rootPosition, const float &rootSize)
+{
+	int depth = max(0, maxDepth - rootDepth);
+
+	// Sort the vertices by their Morton code, then the vertices of every node at every depth are stored after each other
+	std::vector<MortonEntry> entries;
+	ComputeMortonKeys(entries, rootPosition, rootSize, depth);
+	RadixSort(entries, 3 * depth);
+	ThrowIfCanceled();
+	ReorderVertices(entries);
+
+	if (progress != NULL)
+	{
+		progress->partitionedVertexCount += entries.size();
+	}
+
+	// Find all the nodes in one sweep over the sorted keys, the nodes of each level are already in breadth first order
+	std::vector<std::vector<OctreeNodeCreationEntry>> levels;
+	CreateLevels(levels, entries, rootPosition, rootSize, depth);
+
+	if (progress != NULL)
+	{
+		for (size_t level = 0; level < levels.size(); level++)
+		{
+			progress->AddNodes(rootDepth + level, levels[level].size());
+		}
+	}
+
+	LinkLevels(outNodes, levels, entries, depth);
+	ThrowIfCanceled();
+
+	if (useBottomUpAggregation)
+	{
+		AggregateProperties(outNodes, levels);
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::ComputeMortonKeys(std::vector<MortonEntry> &outEntries, const Vector3 &rootPosition, const float &rootSize, int depth)
+{
+	outEntries.resize(vertices->size());
+
+	SubmitRange(outEntries.size(), minTaskKeyCount, [&](size_t start, size_t end)
+	{
+		for (size_t i = start; i < end; i++)
+		{
+			const Vector3 &vertexPosition = (*vertices)[i].position;
+			Vector3 position = rootPosition;
+			float size = rootSize;
+			UINT64 key = 0;
+
+			// Each 3 bits of the key are the child index at that level, which interleaves the bits of the cell coordinates (Morton order)
+			// Descend with the same floating point comparisons as the top down builder instead of quantizing, this way both builders create the same tree
+			for (int level = 0; level < depth; level++)
+			{
+				int childIndex = OctreeNode::GetChildIndex(position, vertexPosition);
+				key = (key << 3) | childIndex;
+
+				position = OctreeNode::GetChildPosition(position, size, childIndex);
+				size *= 0.5f;
+			}
+
+			outEntries[i].key = key;
+			outEntries[i].vertexIndex = i;
+		}
+	});
+
+	threadPool->Wait();
+}
+
+void PointCloudEngine::OctreeBuilder::RadixSort(std::vector<MortonEntry> &entries, UINT keyBits)
+{
+	size_t count = entries.size();
+
+	if ((keyBits == 0) || (count < 2))
+	{
+		return;
+	}
+
+	// Least significant digit radix sort with 8 bits per pass, only the used bits of the keys are sorted
+	// Each task counts the digits of its own chunk, then scatters its chunk to the offsets computed from all counts
+	std::vector<MortonEntry> buffer(count);
+	size_t chunkCount = max((size_t)1, min((size_t)threadPool->GetThreadCount(), count / minTaskKeyCount));
+	size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	std::vector<size_t> histograms(chunkCount * 256);
+
+	for (UINT shift = 0; shift < keyBits; shift += 8)
+	{
+		const MortonEntry *source = entries.data();
+		MortonEntry *destination = buffer.data();
+
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			threadPool->Submit([=, &histograms]()
+			{
+				size_t *histogram = &histograms[chunk * 256];
+				std::fill(histogram, histogram + 256, 0);
+
+				for (size_t i = chunk * chunkSize; i < min(count, (chunk + 1) * chunkSize); i++)
+				{
+					histogram[(source[i].key >> shift) & 0xff]++;
+				}
+			});
+		}
+
+		threadPool->Wait();
+
+		// Digits first, then chunks in order, this keeps the sort stable which is required for the next passes
+		size_t offset = 0;
+
+		for (UINT digit = 0; digit < 256; digit++)
+		{
+			for (size_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				size_t digitCount = histograms[chunk * 256 + digit];
+				histograms[chunk * 256 + digit] = offset;
+				offset += digitCount;
+			}
+		}
+
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			threadPool->Submit([=, &histograms]()
+			{
+				size_t *histogram = &histograms[chunk * 256];
+
+				for (size_t i = chunk * chunkSize; i < min(count, (chunk + 1) * chunkSize); i++)
+				{
+					destination[histogram[(source[i].key >> shift) & 0xff]++] = source[i];
+				}
+			});
+		}
+
+		threadPool->Wait();
+
+		entries.swap(buffer);
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::ReorderVertices(std::vector<MortonEntry> &entries)
+{
+	std::vector<Vertex> &v = *vertices;
+
+	// Apply the sorted order in place by following the cycles of the permutation, no second vertex array is required
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].vertexIndex == i)
+		{
+			continue;
+		}
+
+		Vertex first = v[i];
+		size_t current = i;
+
+		while (entries[current].vertexIndex != i)
+		{
+			size_t next = entries[current].vertexIndex;
+			v[current] = v[next];
+			entries[current].vertexIndex = current;
+			current = next;
+		}
+
+		v[current] = first;
+		entries[current].vertexIndex = current;
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::CreateLevels(std::vector<std::vector<OctreeNodeCreationEntry>> &outLevels, const std::vector<MortonEntry> &entries, const Vector3 &rootPosition, const float &rootSize, int depth)
+{
+	size_t count = entries.size();
+	outLevels.clear();
+	outLevels.resize(depth + 1);
+
+	OctreeNodeCreationEntry rootEntry;
+	rootEntry.vertexStart = 0;
+	rootEntry.vertexCount = count;
+	rootEntry.position = rootPosition;
+	rootEntry.size = rootSize;
+	rootEntry.depth = rootDepth;
+
+	outLevels[0].push_back(rootEntry);
+
+	// Index of the node in each level that contains the current vertex
+	std::vector<size_t> openNodes(depth + 1, SIZE_MAX);
+	openNodes[0] = 0;
+
+	for (size_t i = 0; i <= count; i++)
+	{
+		// Number of levels that this vertex shares with the previous and the next vertex, -1 if there is no such vertex
+		int previousLevels = (i > 0) && (i < count) ? GetCommonLevels(entries[i - 1].key, entries[i].key, depth) : -1;
+		int nextLevels = (i + 1 < count) ? GetCommonLevels(entries[i].key, entries[i + 1].key, depth) : -1;
+		int firstLevel = max(0, previousLevels) + 1;
+
+		// The nodes of the previous vertex end here if they do not contain this vertex (or at the end of the array)
+		for (int level = firstLevel; level <= depth; level++)
+		{
+			if (openNodes[level] != SIZE_MAX)
+			{
+				OctreeNodeCreationEntry &node = outLevels[level][openNodes[level]];
+				node.vertexCount = i - node.vertexStart;
+				openNodes[level] = SIZE_MAX;
+			}
+		}
+
+		if (i == count)
+		{
+			break;
+		}
+
+		// A node only exists when its parent contains more than one vertex (otherwise the parent is a leaf)
+		// The parent at level L contains another vertex exactly when the previous or next vertex shares the first L levels
+		int lastLevel = min(depth, max(previousLevels, nextLevels) + 1);
+
+		for (int level = firstLevel; level <= lastLevel; level++)
+		{
+			const OctreeNodeCreationEntry &parent = outLevels[level - 1][openNodes[level - 1]];
+
+			OctreeNodeCreationEntry entry;
+			entry.vertexStart = i;
+			entry.vertexCount = 0;
+			entry.position = OctreeNode::GetChildPosition(parent.position, parent.size, GetMortonDigit(entries[i].key, level, depth));
+			entry.size = parent.size * 0.5f;
+			entry.depth = rootDepth + level;
+
+			openNodes[level] = outLevels[level].size();
+			outLevels[level].push_back(entry);
+		}
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::LinkLevels(std::vector<OctreeNode> &outNodes, const std::vector<std::vector<OctreeNodeCreationEntry>> &levels, const std::vector<MortonEntry> &entries, int depth)
+{
+	// Same layout as the top down builder: root first, then the nodes of each level after each other
+	std::vector<size_t> levelStarts(levels.size() + 1, 0);
+
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		levelStarts[level + 1] = levelStarts[level] + levels[level].size();
+	}
+
+	outNodes.clear();
+	outNodes.resize(levelStarts.back());
+
+	// The properties of a node only depend on its own vertex range, compute all of them in parallel
+	// With bottom up aggregation the properties are computed after linking the levels
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		const std::vector<OctreeNodeCreationEntry> *levelEntries = &levels[level];
+		OctreeNode *levelNodes = outNodes.data() + levelStarts[level];
+
+		SubmitRange(levelEntries->size(), 1, [this, levelEntries, levelNodes](size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				if (useBottomUpAggregation)
+				{
+					levelNodes[i].properties.childrenMask = 0;
+				}
+				else
+				{
+					levelNodes[i] = OctreeNode(*vertices, (*levelEntries)[i], maxDepth, ((*levelEntries)[i].depth == rootDepth) ? &rootClusters : NULL);
+				}
+			}
+		});
+	}
+
+	threadPool->Wait();
+
+	// The children of a node are the next nodes of the following level that start inside its vertex range
+	for (size_t level = 0; level + 1 < levels.size(); level++)
+	{
+		threadPool->Submit([&, level]()
+		{
+			const std::vector<OctreeNodeCreationEntry> &children = levels[level + 1];
+			size_t childIndex = 0;
+
+			for (size_t i = 0; i < levels[level].size(); i++)
+			{
+				const OctreeNodeCreationEntry &entry = levels[level][i];
+				OctreeNode &node = outNodes[levelStarts[level] + i];
+
+				if (OctreeNode::IsLeafEntry(entry, maxDepth))
+				{
+					continue;
+				}
+
+				node.childrenStartOrLeafPositionFactors = levelStarts[level + 1] + childIndex;
+
+				while ((childIndex < children.size()) && (children[childIndex].vertexStart < entry.vertexStart + entry.vertexCount))
+				{
+					node.properties.childrenMask |= 1 << GetMortonDigit(entries[children[childIndex].vertexStart].key, level + 1, depth);
+					childIndex++;
+				}
+			}
+		});
+	}
+
+	threadPool->Wait();
+}
+
+void PointCloudEngine::OctreeBuilder::AggregateProperties(std::vector<OctreeNode> &nodes, const std::vector<std::vector<OctreeNodeCreationEntry>> &levels)
+{
+	// Only the clusters of the current level and the level below are kept in memory
+	std::vector<OctreeNodeClusters> levelClusters;
+	std::vector<OctreeNodeClusters> childClusters;
+	size_t levelStart = nodes.size();
+
+	for (int level = (int)levels.size() - 1; level >= 0; level--)
+	{
+		const std::vector<OctreeNodeCreationEntry> &levelEntries = levels[level];
+		size_t childLevelStart = levelStart;
+		levelStart -= levelEntries.size();
+		levelClusters.resize(levelEntries.size());
+
+		SubmitRange(levelEntries.size(), 64, [&](size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				OctreeNode &node = nodes[levelStart + i];
+
+				if (OctreeNode::IsLeafEntry(levelEntries[i], maxDepth))
+				{
+					// Leaves are computed exactly from their vertices
+					node = OctreeNode(*vertices, levelEntries[i], maxDepth, &levelClusters[i]);
+				}
+				else
+				{
+					// The children are stored after each other in the next level
+					int childCount = 0;
+
+					for (int j = 0; j < 8; j++)
+					{
+						childCount += (node.properties.childrenMask >> j) & 1;
+					}
+
+					OctreeNode::MergeClusters(&childClusters[node.childrenStartOrLeafPositionFactors - childLevelStart], childCount, levelClusters[i]);
+					node.SetProperties(levelClusters[i]);
+				}
+			}
+		});
+
+		threadPool->Wait();
+		ThrowIfCanceled();
+
+		childClusters.swap(levelClusters);
+	}
+
+	if (!childClusters.empty())
+	{
+		rootClusters = childClusters[0];
+	}
+}
+
+void PointCloudEngine::OctreeBuilder::SubmitRange(size_t count, size_t minTaskCount, std::function<void(size_t, size_t)> function)
+{
+	// A few tasks per thread so that the work stealing can balance uneven ranges, call Wait on the thread pool to complete them
+	size_t taskCount = max((size_t)1, min((size_t)threadPool->GetThreadCount() * 4, count / minTaskCount));
+	size_t taskSize = (count + taskCount - 1) / taskCount;
+
+	for (size_t start = 0; start < count; start += taskSize)
+	{
+		size_t end = min(count, start + taskSize);
+		threadPool->Submit([this, function, start, end]()
+		{
+			// Skip the remaining tasks of a canceled build, the caller throws after waiting for them
+			if (!IsCanceled())
+			{
+				function(start, end);
+			}
+		});
+	}
+}
+
+bool PointCloudEngine::OctreeBuilder::IsCanceled() const
+{
+	return (progress != NULL) && progress->canceled;
+}
+
+void PointCloudEngine::OctreeBuilder::ThrowIfCanceled() const
+{
+	if (progress != NULL)
+	{
+		progress->ThrowIfCanceled();
+	}
+}
+
+int PointCloudEngine::OctreeBuilder::GetMortonDigit(UINT64 key, int level, int depth)
+{
+	// Child index of the node at this level (1 is the first level below the root)
+	return (key >> (3 * (depth - level))) & 0x7;
+}
+
+int PointCloudEngine::OctreeBuilder::GetCommonLevels(UINT64 keyA, UINT64 keyB, int depth)
+{
+	if (keyA == keyB)
+	{
+		return depth;
+	}
+
+	// The highest different bit determines the first different child index
+	unsigned long highestBit;
+	_BitScanReverse64(&highestBit, keyA ^ keyB);
+
+	return (3 * depth - 1 - highestBit) / 3;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef OCTREEBUILDER_H
+#define OCTREEBUILDER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Builds the octree nodes from the vertices of a point cloud with multiple threads
+	// TopDown: independent subtrees are created concurrently on a work stealing thread pool
+	// Morton: the vertices are sorted by their Morton code with a parallel radix sort, then every node is a contiguous range of sorted vertices
+	// The resulting nodes array has the same breadth first layout for any thread count
+	// With bottom up aggregation only the leaf properties are computed from the vertices, the inner nodes merge the clusters of their children
+	class OctreeBuilder
+	{
+	public:
+		// The leaves end at the max depth, a thread count of 0 uses all the hardware threads
+		// The optional progress counts the partitioned vertices and created nodes, a canceled build throws an exception
+		OctreeBuilder(OctreeBuildMode buildMode, bool useBottomUpAggregation, int maxDepth, UINT threadCount = 0, OctreeBuildProgress *progress = NULL);
+		~OctreeBuilder();
+
+		// The vertices are reordered in place, each node references a contiguous range of them while building
+		// A root depth greater than 0 builds the subtree of a node at that depth, its leaves still end at the maximum octree depth
+		void Build(std::vector<OctreeNode> &outNodes, std::vector<Vertex> &vertices, const Vector3 &rootPosition, const float &rootSize, int rootDepth = 0);
+
+		// Unquantized clusters of the root node of the last build, used to aggregate the nodes above separately built subtrees
+		const OctreeNodeClusters& GetRootClusters() const;
+
+		// Morton codes store 3 bits per level in a 64 bit key, deeper octrees are always built top down
+		static const int maxMortonDepth = 21;
+
+	private:
+		// Temporary tree representation that can be filled in any order by the worker threads
+		struct OctreeBuildNode;
+
+		// Sort key of a vertex, the index is used to reorder the vertices after sorting
+		struct MortonEntry
+		{
+			UINT64 key;
+			UINT vertexIndex;
+		};
+
+		// Subtrees with less vertices are created on the same thread instead of spawning a new task
+		static const size_t minTaskVertexCount = 16384;
+
+		// Each sorting task processes at least this many keys
+		static const size_t minTaskKeyCount = 65536;
+
+		OctreeBuildMode buildMode;
+		bool useBottomUpAggregation;
+		int maxDepth;
+		int rootDepth = 0;
+		OctreeNodeClusters rootClusters;
+		ThreadPool *threadPool = NULL;
+		OctreeBuildProgress *progress = NULL;
+		std::vector<Vertex> *vertices = NULL;
+		std::atomic<size_t> nodeCount;
+
+		// One arena for each thread pool queue, the temporary tree is allocated from them and freed at once after flattening
+		std::vector<ScratchArena*> nodeArenas;
+
+		void BuildTopDown(std::vector<OctreeNode> &outNodes, const Vector3 &rootPosition, const float &rootSize);
+		void CreateSubtree(OctreeBuildNode *buildNode, const OctreeNodeCreationEntry &entry);
+		void Partition(const OctreeNodeCreationEntry &entry, UINT (&outChildVertexCounts)[8]);
+		void Flatten(OctreeBuildNode *root, std::vector<OctreeNode> &outNodes, std::vector<std::vector<OctreeNodeCreationEntry>> *outLevels);
+
+		void BuildMorton(std::vector<OctreeNode> &outNodes, const Vector3 &rootPosition, const float &rootSize);
+		void ComputeMortonKeys(std::vector<MortonEntry> &outEntries, const Vector3 &rootPosition, const float &rootSize, int depth);
+		void RadixSort(std::vector<MortonEntry> &entries, UINT keyBits);
+		void ReorderVertices(std::vector<MortonEntry> &entries);
+		void CreateLevels(std::vector<std::vector<OctreeNodeCreationEntry>> &outLevels, const std::vector<MortonEntry> &entries, const Vector3 &rootPosition, const float &rootSize, int depth);
+		void LinkLevels(std::vector<OctreeNode> &outNodes, const std::vector<std::vector<OctreeNodeCreationEntry>> &levels, const std::vector<MortonEntry> &entries, int depth);
+		void AggregateProperties(std::vector<OctreeNode> &nodes, const std::vector<std::vector<OctreeNodeCreationEntry>> &levels);
+		void SubmitRange(size_t count, size_t minTaskCount, std::function<void(size_t, size_t)> function);
+		bool IsCanceled() const;
+		void ThrowIfCanceled() const;
+
+		static int GetMortonDigit(UINT64 key, int level, int depth);
+		static int GetCommonLevels(UINT64 keyA, UINT64 keyB, int depth);
+	};
+}
+#endif
\ No newline at end of file
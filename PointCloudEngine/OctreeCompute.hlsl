@@ -59,7 +59,7 @@ void CS (uint3 id : SV_DispatchThreadID)
 			}
 
 			// View frustum culling, check if this node is fully inside the view frustum only when the parent isn't (the children of a node are always inside the view frustum then the node itself is inside it)
-			if (!entry.parentInsideViewFrustum)
+			if (entry.parentInsidePlanes != 0x3F)
 			{
 				// Generate all the 6 planes of the view frustum
 				float3 viewFrustumPlanes[6][2] =
@@ -239,7 +239,7 @@ void CS (uint3 id : SV_DispatchThreadID)
 					childEntry.index = node.childrenStartOrLeafPositionFactors + count;
 					childEntry.position = childPositions[i];
 					childEntry.size = entry.size * 0.5f;
-					childEntry.parentInsideViewFrustum = insideViewFrustum;
+					childEntry.parentInsidePlanes = insideViewFrustum ? 0x3F : 0;
 					childEntry.depth = entry.depth + 1;
 
 					outputAppendBuffer.Append(childEntry);
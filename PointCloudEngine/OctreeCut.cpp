@@ -0,0 +1,255 @@
+#include "OctreeCut.h"
+
+const std::vector<PointCloudEngine::OctreeNodeVertex>& PointCloudEngine::OctreeCut::Update(const OctreeNode *nodes, const OctreeTopology *topology, const OctreeNodeTraversalEntry &rootEntry, const OctreeConstantBuffer &octreeConstantBufferData)
+{
+	FrustumCuller currentFrustumCuller(octreeConstantBufferData);
+
+	this->nodes = nodes;
+	this->topology = topology;
+	output = &nextVertices;
+	this->octreeConstantBufferData = &octreeConstantBufferData;
+	frustumCuller = &currentFrustumCuller;
+	splatSizeFactor = octreeConstantBufferData.splatResolution * (2.0f * tan(octreeConstantBufferData.fovAngleY / 2.0f));
+	maxPositionLength = rootEntry.position.Length() + rootEntry.size * (sqrt(3.0f) / 2.0f);
+
+	// The splat resolution and fov change the splat size decisions of all the nodes
+	bool reuse = hasPreviousFrame && !records.empty()
+		&& (octreeConstantBufferData.splatResolution == previousConstantBufferData.splatResolution)
+		&& (octreeConstantBufferData.fovAngleY == previousConstantBufferData.fovAngleY)
+		&& (octreeConstantBufferData.useCulling == previousConstantBufferData.useCulling);
+
+	if (reuse)
+	{
+		// Every decision depends on the distance to the camera or to the view frustum planes, both cannot change by more than the larger movement
+		float cameraMovement = Vector3::Distance(octreeConstantBufferData.localCameraPosition, previousConstantBufferData.localCameraPosition);
+		float planeMovement = octreeConstantBufferData.useCulling ? currentFrustumCuller.GetPlaneMovement(FrustumCuller(previousConstantBufferData), maxPositionLength) : 0;
+
+		movement += max(cameraMovement, planeMovement);
+	}
+	else
+	{
+		records.clear();
+		movement = 0;
+	}
+
+	nextVertices.clear();
+	nextRecords.clear();
+	previousVertexIndex = 0;
+	evaluatedNodeCount = 0;
+	reusedNodeCount = 0;
+
+	if (records.empty())
+	{
+		CreateSubtree(rootEntry);
+	}
+	else
+	{
+		UpdateSubtree(0, rootEntry);
+	}
+
+	// The cut of this frame becomes the last frame, nothing is copied
+	records.swap(nextRecords);
+	vertices.swap(nextVertices);
+	previousConstantBufferData = octreeConstantBufferData;
+	hasPreviousFrame = true;
+	frustumCuller = NULL;
+	output = NULL;
+
+	return vertices;
+}
+
+void PointCloudEngine::OctreeCut::Clear()
+{
+	records.clear();
+	vertices.clear();
+	hasPreviousFrame = false;
+}
+
+size_t PointCloudEngine::OctreeCut::GetEvaluatedNodeCount() const
+{
+	return evaluatedNodeCount;
+}
+
+size_t PointCloudEngine::OctreeCut::GetReusedNodeCount() const
+{
+	return reusedNodeCount;
+}
+
+size_t PointCloudEngine::OctreeCut::UpdateSubtree(size_t recordIndex, const OctreeNodeTraversalEntry &entry)
+{
+	const Record &record = records[recordIndex];
+	size_t nextRecordIndex = recordIndex + record.subtreeSize;
+
+	// The children of a node whose inside planes changed have to test other planes than before
+	if ((record.entry.parentInsidePlanes == entry.parentInsidePlanes) && (record.validUntil > movement))
+	{
+		nextRecords.insert(nextRecords.end(), records.begin() + recordIndex, records.begin() + nextRecordIndex);
+		output->insert(output->end(), vertices.begin() + previousVertexIndex, vertices.begin() + previousVertexIndex + record.vertexCount);
+		previousVertexIndex += record.vertexCount;
+		reusedNodeCount += record.subtreeSize;
+
+		return nextRecordIndex;
+	}
+
+	if (record.state != RecordState::Refined)
+	{
+		previousVertexIndex += record.vertexCount;
+		CreateSubtree(entry);
+
+		return nextRecordIndex;
+	}
+
+	size_t newRecordIndex = nextRecords.size();
+	size_t vertexStart = output->size();
+	OctreeNode node = (topology != NULL) ? topology->GetNode(entry.index) : nodes[entry.index];
+	EvaluateNode(entry, node);
+
+	if (nextRecords[newRecordIndex].state != RecordState::Refined)
+	{
+		// The subtree of the last frame collapses into this node
+		previousVertexIndex += record.vertexCount;
+
+		return nextRecordIndex;
+	}
+
+	// The node stays refined, the subtrees of its children follow it in the same order as in the last frame
+	OctreeNodeTraversalEntry childEntries[8];
+	int childCount = 0;
+	size_t childRecordIndex = recordIndex + 1;
+	GetChildEntries(node, nextRecords[newRecordIndex], childEntries, childCount);
+
+	for (int i = 0; i < childCount; i++)
+	{
+		childRecordIndex = UpdateSubtree(childRecordIndex, childEntries[i]);
+	}
+
+	FinishSubtree(newRecordIndex, vertexStart);
+
+	return nextRecordIndex;
+}
+
+void PointCloudEngine::OctreeCut::CreateSubtree(const OctreeNodeTraversalEntry &entry)
+{
+	size_t newRecordIndex = nextRecords.size();
+	size_t vertexStart = output->size();
+	OctreeNode node = (topology != NULL) ? topology->GetNode(entry.index) : nodes[entry.index];
+	EvaluateNode(entry, node);
+
+	if (nextRecords[newRecordIndex].state == RecordState::Refined)
+	{
+		OctreeNodeTraversalEntry childEntries[8];
+		int childCount = 0;
+		GetChildEntries(node, nextRecords[newRecordIndex], childEntries, childCount);
+
+		for (int i = 0; i < childCount; i++)
+		{
+			CreateSubtree(childEntries[i]);
+		}
+
+		FinishSubtree(newRecordIndex, vertexStart);
+	}
+}
+
+void PointCloudEngine::OctreeCut::EvaluateNode(const OctreeNodeTraversalEntry &entry, const OctreeNode &node)
+{
+	evaluatedNodeCount++;
+
+	Record record;
+	record.entry = entry;
+	record.state = RecordState::Drawn;
+	record.insidePlanes = FrustumCuller::allPlanesInside;
+	record.subtreeSize = 1;
+	record.vertexCount = 0;
+
+	// Same decisions in the same order as OctreeNode::Traverse, each one limits the slack
+	float distanceToCamera = Vector3::Distance(octreeConstantBufferData->localCameraPosition, entry.position);
+	float slack = FLT_MAX;
+
+	if (octreeConstantBufferData->useCulling)
+	{
+		float frustumSlack = 0;
+		float cosineSlack = 0;
+		record.insidePlanes = frustumCuller->Classify(entry, frustumSlack);
+
+		if (record.insidePlanes == FrustumCuller::outside)
+		{
+			record.state = RecordState::Culled;
+			record.validUntil = movement + frustumSlack;
+			nextRecords.push_back(record);
+			return;
+		}
+
+		bool facingCamera = node.IsFacingCamera(entry.position, *octreeConstantBufferData, &cosineSlack);
+
+		// While the camera stays at least half the distance away, the direction to the node changes by at most 4 * movement / distance
+		// The forward vector is the near plane normal, it changes by at most the plane movement / max position length
+		float backfaceSlack = min(0.5f * distanceToCamera, cosineSlack * min(maxPositionLength, 0.25f * distanceToCamera));
+
+		if (!facingCamera)
+		{
+			record.state = RecordState::Culled;
+			record.validUntil = movement + backfaceSlack;
+			nextRecords.push_back(record);
+			return;
+		}
+
+		slack = min(frustumSlack, backfaceSlack);
+	}
+
+	if (!node.IsLeafNode())
+	{
+		float requiredSplatSize = splatSizeFactor * distanceToCamera;
+
+		if (entry.size >= requiredSplatSize)
+		{
+			record.state = RecordState::Refined;
+		}
+
+		// The decision changes when the camera crosses the distance at which the node has the splat size
+		if (splatSizeFactor > 0)
+		{
+			slack = min(slack, fabs(distanceToCamera - entry.size / splatSizeFactor));
+		}
+	}
+
+	if (record.state == RecordState::Drawn)
+	{
+		output->push_back(node.GetVertexFromTraversalEntry(entry));
+		record.vertexCount = 1;
+	}
+
+	record.validUntil = movement + slack;
+	nextRecords.push_back(record);
+}
+
+void PointCloudEngine::OctreeCut::GetChildEntries(const OctreeNode &node, const Record &record, OctreeNodeTraversalEntry (&outChildEntries)[8], int &outChildCount) const
+{
+	outChildCount = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		if (node.properties.childrenMask & (1 << i))
+		{
+			OctreeNodeTraversalEntry &childEntry = outChildEntries[outChildCount];
+			childEntry.index = node.childrenStartOrLeafPositionFactors + outChildCount;
+			childEntry.position = OctreeNode::GetChildPosition(record.entry.position, record.entry.size, i);
+			childEntry.size = record.entry.size * 0.5f;
+			childEntry.parentInsidePlanes = record.insidePlanes;
+			childEntry.depth = record.entry.depth + 1;
+			outChildCount++;
+		}
+	}
+}
+
+void PointCloudEngine::OctreeCut::FinishSubtree(size_t recordIndex, size_t vertexStart)
+{
+	Record &record = nextRecords[recordIndex];
+	record.subtreeSize = (UINT)(nextRecords.size() - recordIndex);
+	record.vertexCount = (UINT)(output->size() - vertexStart);
+
+	// The subtree stays the same until the first decision in it can change
+	for (size_t i = recordIndex + 1; i < nextRecords.size(); i += nextRecords[i].subtreeSize)
+	{
+		record.validUntil = min(record.validUntil, nextRecords[i].validUntil);
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef OCTREECUT_H
+#define OCTREECUT_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Keeps the level of detail cut of the last cpu traversal between the frames: the refined nodes and below them the drawn and culled nodes
+	// Every decision (frustum, backface and splat size) is stored with a slack, how far the camera can move until the decision can change
+	// The camera and view frustum movement of each frame is accumulated and only the subtrees with a decision whose slack is used up are evaluated again
+	// The other subtrees are copied from the last frame, a slow camera movement only evaluates the nodes close to a change
+	// The cut is stored in depth first order, the records and vertices of a subtree are contiguous and the children follow their parent
+	class OctreeCut
+	{
+	public:
+		// The nodes are either given as array or as succinct topology, the vertices are the same as with a full traversal (in depth first order)
+		// Only for the splat size traversal (level -1), the octree is traversed from the root again when the splat resolution, fov or culling changes
+		// Returns the vertices of the cut itself, they stay valid until the next update or clear
+		const std::vector<OctreeNodeVertex>& Update(const OctreeNode *nodes, const OctreeTopology *topology, const OctreeNodeTraversalEntry &rootEntry, const OctreeConstantBuffer &octreeConstantBufferData);
+
+		// Has to be called when the nodes change
+		void Clear();
+
+		// Number of nodes that were evaluated and number of nodes that were copied from the last frame in the last update
+		size_t GetEvaluatedNodeCount() const;
+		size_t GetReusedNodeCount() const;
+
+	private:
+		enum class RecordState : byte
+		{
+			Refined,
+			Drawn,
+			Culled
+		};
+
+		struct Record
+		{
+			OctreeNodeTraversalEntry entry;
+			RecordState state;
+			int insidePlanes;
+
+			// Number of records and vertices of the subtree including this record
+			UINT subtreeSize;
+			UINT vertexCount;
+
+			// The decisions in the subtree stay the same until the accumulated movement reaches this value
+			double validUntil;
+		};
+
+		// The records and vertices of the last frame and the ones that are created by the update, swapped after each update to reuse their capacity
+		std::vector<Record> records;
+		std::vector<Record> nextRecords;
+		std::vector<OctreeNodeVertex> vertices;
+		std::vector<OctreeNodeVertex> nextVertices;
+
+		// Sum of the camera and view frustum movement of all the updates since the cut was created
+		double movement = 0;
+
+		bool hasPreviousFrame = false;
+		OctreeConstantBuffer previousConstantBufferData;
+
+		// Parameters of the current update
+		const OctreeNode *nodes = NULL;
+		const OctreeTopology *topology = NULL;
+		const OctreeConstantBuffer *octreeConstantBufferData = NULL;
+		FrustumCuller *frustumCuller = NULL;
+		std::vector<OctreeNodeVertex> *output = NULL;
+		float splatSizeFactor = 0;
+		float maxPositionLength = 0;
+		size_t previousVertexIndex = 0;
+		size_t evaluatedNodeCount = 0;
+		size_t reusedNodeCount = 0;
+
+		// Copies or updates the subtree of the record from the last frame, returns the index of the record after that subtree
+		size_t UpdateSubtree(size_t recordIndex, const OctreeNodeTraversalEntry &entry);
+
+		// Evaluates the node and the subtree below it without the last frame
+		void CreateSubtree(const OctreeNodeTraversalEntry &entry);
+
+		// Appends the record of the node and its vertex when it is drawn, the children of refined nodes are not appended
+		void EvaluateNode(const OctreeNodeTraversalEntry &entry, const OctreeNode &node);
+		void GetChildEntries(const OctreeNode &node, const Record &record, OctreeNodeTraversalEntry (&outChildEntries)[8], int &outChildCount) const;
+		void FinishSubtree(size_t recordIndex, size_t vertexStart);
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,603 @@
+#include "OctreeEditor.h"
+
+struct PointCloudEngine::OctreeEditor::OctreeEditNode
+{
+	UINT parentIndex;
+	Vector3 position;
+	float size;
+	int depth;
+
+	// The whole subtree is built again from its vertices, an empty subtree removes the node
+	bool rebuild = false;
+	std::vector<Vertex> vertices;
+	std::vector<OctreeNode> subtree;
+
+	// Ancestors count the vertices of each child cube after the changes and keep one vertex in case that only one remains
+	UINT64 childVertexCounts[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	Vertex lastVertex;
+
+	// Inserted vertices in child cubes that did not have a node before and the subtrees that are built from them
+	std::vector<Vertex> newChildVertices[8];
+	std::vector<OctreeNode> newChildSubtrees[8];
+	OctreeNodeClusters newChildClusters[8];
+
+	// Node and clusters after the changes
+	OctreeNode node;
+	OctreeNodeClusters clusters;
+};
+
+PointCloudEngine::OctreeEditor::OctreeEditor(std::vector<OctreeNode> &nodes, const Vector3 &rootPosition, const float &rootSize, const OctreeBuildParameters &buildParameters)
+{
+	this->nodes = &nodes;
+	this->rootPosition = rootPosition;
+	this->rootSize = rootSize;
+	this->buildParameters = buildParameters;
+}
+
+PointCloudEngine::OctreeEditor::~OctreeEditor()
+{
+	for (auto it = editNodes.begin(); it != editNodes.end(); it++)
+	{
+		SafeDelete(it->second);
+	}
+}
+
+bool PointCloudEngine::OctreeEditor::Insert(const std::vector<Vertex> &vertices)
+{
+	// Vertices outside of the root cube would require a larger root cube and therefore a complete rebuild
+	Vector3 rootMin = rootPosition - 0.5f * rootSize * Vector3::One;
+	Vector3 rootMax = rootPosition + 0.5f * rootSize * Vector3::One;
+
+	for (auto it = vertices.begin(); it != vertices.end(); it++)
+	{
+		const Vector3 &p = it->position;
+
+		if ((p.x < rootMin.x) || (p.y < rootMin.y) || (p.z < rootMin.z) || (p.x > rootMax.x) || (p.y > rootMax.y) || (p.z > rootMax.z))
+		{
+			return false;
+		}
+	}
+
+	for (auto it = vertices.begin(); it != vertices.end(); it++)
+	{
+		UINT index = 0;
+		UINT parentIndex = UINT_MAX;
+		Vector3 position = rootPosition;
+		float size = rootSize;
+		int depth = 0;
+
+		// Mark the path to the deepest existing node that contains the vertex
+		while (true)
+		{
+			OctreeEditNode *editNode = GetEditNode(index, parentIndex, position, size, depth);
+			const OctreeNode &node = (*nodes)[index];
+
+			if (editNode->rebuild)
+			{
+				break;
+			}
+
+			if (node.IsLeafNode())
+			{
+				// The leaf is split or represents one more vertex
+				editNode->rebuild = true;
+				break;
+			}
+
+			int childIndex = OctreeNode::GetChildIndex(position, it->position);
+
+			// Vertices in a child cube without a node create a new subtree below this node
+			if (!(node.properties.childrenMask & (1 << childIndex)))
+			{
+				break;
+			}
+
+			parentIndex = index;
+			index = GetChild(node, childIndex);
+			position = OctreeNode::GetChildPosition(position, size, childIndex);
+			size *= 0.5f;
+			depth++;
+		}
+
+		insertedVertices.push_back(*it);
+	}
+
+	return true;
+}
+
+void PointCloudEngine::OctreeEditor::Delete(const Vector3 &boxMin, const Vector3 &boxMax)
+{
+	deleteBoxes.push_back(std::pair<Vector3, Vector3>(boxMin, boxMax));
+	MarkDelete(0, UINT_MAX, rootPosition, rootSize, 0, boxMin, boxMax);
+}
+
+bool PointCloudEngine::OctreeEditor::Apply(const std::wstring &pointcloudFile)
+{
+	rebuiltSubtreeCount = 0;
+
+	if (editNodes.empty())
+	{
+		// The delete boxes do not intersect the octree
+		return true;
+	}
+
+	RemoveNestedEditNodes();
+
+	// Write the remaining and inserted vertices to a new file while collecting the vertices of the changed subtrees
+	std::wstring outputFile = pointcloudFile + L".edit";
+	UINT64 vertexCount = 0;
+
+	if (!ReadVertices(pointcloudFile, outputFile, vertexCount) || (vertexCount == 0))
+	{
+		DeleteFile(outputFile.c_str());
+		return false;
+	}
+
+	RebuildSubtrees();
+	UpdateAncestors();
+
+	std::vector<OctreeNode> editedNodes;
+	Relink(editedNodes);
+
+	// The children start indices of the nodes are 32 bit
+	if (editedNodes.size() > OctreeNode::maxNodeCount)
+	{
+		Benchmark::Log(L"The octree would have more than 4G nodes after the edit, these are not supported");
+		DeleteFile(outputFile.c_str());
+		return false;
+	}
+
+	if (!MoveFileEx(outputFile.c_str(), pointcloudFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFile(outputFile.c_str());
+		return false;
+	}
+
+	nodes->swap(editedNodes);
+
+	// All the changes are applied, the node indices of the edit nodes are not valid anymore
+	for (auto it = editNodes.begin(); it != editNodes.end(); it++)
+	{
+		SafeDelete(it->second);
+	}
+
+	editNodes.clear();
+	insertedVertices.clear();
+	deleteBoxes.clear();
+
+	return true;
+}
+
+size_t PointCloudEngine::OctreeEditor::GetRebuiltSubtreeCount() const
+{
+	return rebuiltSubtreeCount;
+}
+
+PointCloudEngine::OctreeEditor::OctreeEditNode* PointCloudEngine::OctreeEditor::GetEditNode(UINT index, UINT parentIndex, const Vector3 &position, const float &size, int depth)
+{
+	auto it = editNodes.find(index);
+
+	if (it != editNodes.end())
+	{
+		return it->second;
+	}
+
+	OctreeEditNode *editNode = new OctreeEditNode();
+	editNode->parentIndex = parentIndex;
+	editNode->position = position;
+	editNode->size = size;
+	editNode->depth = depth;
+	editNode->node = (*nodes)[index];
+
+	editNodes[index] = editNode;
+
+	return editNode;
+}
+
+void PointCloudEngine::OctreeEditor::MarkDelete(UINT index, UINT parentIndex, const Vector3 &position, const float &size, int depth, const Vector3 &boxMin, const Vector3 &boxMax)
+{
+	Vector3 cubeMin = position - 0.5f * size * Vector3::One;
+	Vector3 cubeMax = position + 0.5f * size * Vector3::One;
+
+	if ((cubeMax.x < boxMin.x) || (cubeMax.y < boxMin.y) || (cubeMax.z < boxMin.z) || (cubeMin.x > boxMax.x) || (cubeMin.y > boxMax.y) || (cubeMin.z > boxMax.z))
+	{
+		// None of the vertices of this cube can be inside the box
+		return;
+	}
+
+	OctreeEditNode *editNode = GetEditNode(index, parentIndex, position, size, depth);
+	const OctreeNode &node = (*nodes)[index];
+
+	if (editNode->rebuild)
+	{
+		return;
+	}
+
+	bool inside = (cubeMin.x >= boxMin.x) && (cubeMin.y >= boxMin.y) && (cubeMin.z >= boxMin.z) && (cubeMax.x <= boxMax.x) && (cubeMax.y <= boxMax.y) && (cubeMax.z <= boxMax.z);
+
+	// Leaves are built again from their remaining vertices, cubes inside the box lose all their vertices and are removed
+	if (node.IsLeafNode() || inside)
+	{
+		editNode->rebuild = true;
+		return;
+	}
+
+	for (int i = 0; i < 8; i++)
+	{
+		if (node.properties.childrenMask & (1 << i))
+		{
+			MarkDelete(GetChild(node, i), index, OctreeNode::GetChildPosition(position, size, i), size * 0.5f, depth + 1, boxMin, boxMax);
+		}
+	}
+}
+
+void PointCloudEngine::OctreeEditor::RemoveNestedEditNodes()
+{
+	// A subtree that is built again already contains all the changes of the nodes below it
+	std::vector<UINT> nestedIndices;
+
+	for (auto it = editNodes.begin(); it != editNodes.end(); it++)
+	{
+		UINT parentIndex = it->second->parentIndex;
+
+		while (parentIndex != UINT_MAX)
+		{
+			OctreeEditNode *parent = editNodes[parentIndex];
+
+			if (parent->rebuild)
+			{
+				nestedIndices.push_back(it->first);
+				break;
+			}
+
+			parentIndex = parent->parentIndex;
+		}
+	}
+
+	for (auto it = nestedIndices.begin(); it != nestedIndices.end(); it++)
+	{
+		SafeDelete(editNodes[*it]);
+		editNodes.erase(*it);
+	}
+}
+
+bool PointCloudEngine::OctreeEditor::ReadVertices(const std::wstring &pointcloudFile, const std::wstring &outputFile, UINT64 &outVertexCount)
+{
+	std::ifstream file(pointcloudFile, std::ios::in | std::ios::binary);
+
+	Vector3 boundingCubePosition;
+	float boundingCubeSize;
+	UINT64 vertexCount;
+
+	if (!ReadPointcloudHeader(file, boundingCubePosition, boundingCubeSize, vertexCount))
+	{
+		return false;
+	}
+
+	// Same header, the vertex count is written at the end and its size is reserved for all the vertices that could remain
+	UINT64 maxVertexCount = vertexCount + insertedVertices.size();
+	std::ofstream output(outputFile, std::ios::out | std::ios::binary);
+	WritePointcloudHeader(output, boundingCubePosition, boundingCubeSize, vertexCount, maxVertexCount);
+
+	std::vector<PointcloudVertex> chunk(min((UINT64)chunkSize, vertexCount));
+	std::vector<PointcloudVertex> remainingVertices;
+	outVertexCount = 0;
+
+	for (UINT64 chunkStart = 0; chunkStart < vertexCount; chunkStart += chunk.size())
+	{
+		size_t count = min((UINT64)chunk.size(), vertexCount - chunkStart);
+		file.read((char*)chunk.data(), count * sizeof(PointcloudVertex));
+
+		if (!file)
+		{
+			return false;
+		}
+
+		remainingVertices.clear();
+
+		for (size_t i = 0; i < count; i++)
+		{
+			Vertex vertex = chunk[i].GetVertex();
+
+			if (!IsDeleted(vertex.position))
+			{
+				remainingVertices.push_back(chunk[i]);
+				AddVertex(vertex);
+			}
+		}
+
+		output.write((char*)remainingVertices.data(), remainingVertices.size() * sizeof(PointcloudVertex));
+		outVertexCount += remainingVertices.size();
+	}
+
+	// The inserted vertices are appended, use the quantized normals like any other vertex of the file
+	for (auto it = insertedVertices.begin(); it != insertedVertices.end(); it++)
+	{
+		if (!IsDeleted(it->position))
+		{
+			PointcloudVertex pointcloudVertex(*it);
+			output.write((char*)&pointcloudVertex, sizeof(PointcloudVertex));
+			AddVertex(pointcloudVertex.GetVertex());
+			outVertexCount++;
+		}
+	}
+
+	output.seekp(0);
+	WritePointcloudHeader(output, boundingCubePosition, boundingCubeSize, outVertexCount, maxVertexCount);
+	output.close();
+
+	return !output.fail();
+}
+
+void PointCloudEngine::OctreeEditor::AddVertex(const Vertex &vertex)
+{
+	auto it = editNodes.find(0);
+
+	// Follow the changed nodes, the vertices of unchanged subtrees are not required
+	while (it != editNodes.end())
+	{
+		OctreeEditNode *editNode = it->second;
+
+		if (editNode->rebuild)
+		{
+			editNode->vertices.push_back(vertex);
+			return;
+		}
+
+		const OctreeNode &node = (*nodes)[it->first];
+		int childIndex = OctreeNode::GetChildIndex(editNode->position, vertex.position);
+
+		editNode->childVertexCounts[childIndex]++;
+		editNode->lastVertex = vertex;
+
+		if (!(node.properties.childrenMask & (1 << childIndex)))
+		{
+			editNode->newChildVertices[childIndex].push_back(vertex);
+			return;
+		}
+
+		it = editNodes.find(GetChild(node, childIndex));
+	}
+}
+
+void PointCloudEngine::OctreeEditor::RebuildSubtrees()
+{
+	OctreeBuilder octreeBuilder(buildParameters.buildMode, buildParameters.useBottomUpAggregation, buildParameters.maxDepth, buildParameters.threadCount);
+
+	for (auto it = editNodes.begin(); it != editNodes.end(); it++)
+	{
+		OctreeEditNode *editNode = it->second;
+
+		if (editNode->rebuild)
+		{
+			if (!editNode->vertices.empty())
+			{
+				octreeBuilder.Build(editNode->subtree, editNode->vertices, editNode->position, editNode->size, editNode->depth);
+				editNode->clusters = octreeBuilder.GetRootClusters();
+			}
+
+			std::vector<Vertex>().swap(editNode->vertices);
+			rebuiltSubtreeCount++;
+		}
+		else
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				if (!editNode->newChildVertices[i].empty())
+				{
+					octreeBuilder.Build(editNode->newChildSubtrees[i], editNode->newChildVertices[i], OctreeNode::GetChildPosition(editNode->position, editNode->size, i), editNode->size * 0.5f, editNode->depth + 1);
+					editNode->newChildClusters[i] = octreeBuilder.GetRootClusters();
+
+					std::vector<Vertex>().swap(editNode->newChildVertices[i]);
+					rebuiltSubtreeCount++;
+				}
+			}
+		}
+	}
+}
+
+void PointCloudEngine::OctreeEditor::UpdateAncestors()
+{
+	// Update the deepest ancestors first, then the clusters of all the changed children are known
+	std::vector<std::pair<UINT, OctreeEditNode*>> ancestors;
+
+	for (auto it = editNodes.begin(); it != editNodes.end(); it++)
+	{
+		if (!it->second->rebuild)
+		{
+			ancestors.push_back(*it);
+		}
+	}
+
+	std::stable_sort(ancestors.begin(), ancestors.end(), [](const std::pair<UINT, OctreeEditNode*> &a, const std::pair<UINT, OctreeEditNode*> &b) { return a.second->depth > b.second->depth; });
+
+	for (auto it = ancestors.begin(); it != ancestors.end(); it++)
+	{
+		OctreeEditNode *editNode = it->second;
+		const OctreeNode &node = (*nodes)[it->first];
+		UINT64 vertexCount = 0;
+
+		for (int i = 0; i < 8; i++)
+		{
+			vertexCount += editNode->childVertexCounts[i];
+		}
+
+		if (vertexCount <= 1)
+		{
+			// At most one vertex remains, then this node becomes a leaf or is removed
+			editNode->rebuild = true;
+
+			if (vertexCount == 1)
+			{
+				std::vector<Vertex> vertices = { editNode->lastVertex };
+
+				OctreeNodeCreationEntry entry;
+				entry.vertexStart = 0;
+				entry.vertexCount = 1;
+				entry.position = editNode->position;
+				entry.size = editNode->size;
+				entry.depth = editNode->depth;
+
+				editNode->subtree.push_back(OctreeNode(vertices, entry, buildParameters.maxDepth, &editNode->clusters));
+			}
+
+			continue;
+		}
+
+		OctreeNodeClusters childClusters[8];
+		int childCount = 0;
+
+		editNode->node.properties.childrenMask = 0;
+
+		for (int i = 0; i < 8; i++)
+		{
+			if (editNode->childVertexCounts[i] == 0)
+			{
+				continue;
+			}
+
+			editNode->node.properties.childrenMask |= 1 << i;
+
+			if (node.properties.childrenMask & (1 << i))
+			{
+				// Unchanged children only store the quantized properties
+				UINT childIndex = GetChild(node, i);
+				auto child = editNodes.find(childIndex);
+
+				if (child == editNodes.end())
+				{
+					(*nodes)[childIndex].GetClusters(editNode->childVertexCounts[i], childClusters[childCount++]);
+				}
+				else
+				{
+					childClusters[childCount++] = child->second->clusters;
+				}
+			}
+			else
+			{
+				childClusters[childCount++] = editNode->newChildClusters[i];
+			}
+		}
+
+		OctreeNode::MergeClusters(childClusters, childCount, editNode->clusters);
+		editNode->node.SetProperties(editNode->clusters);
+	}
+}
+
+void PointCloudEngine::OctreeEditor::Relink(std::vector<OctreeNode> &outNodes)
+{
+	// Same breadth first layout as the OctreeBuilder, the children of a node are stored after each other in the next level
+	std::vector<NodeReference> level = { GetReference(0) };
+
+	outNodes.clear();
+	outNodes.reserve(nodes->size());
+
+	while (!level.empty())
+	{
+		size_t levelEnd = outNodes.size() + level.size();
+		std::vector<NodeReference> nextLevel;
+
+		for (auto it = level.begin(); it != level.end(); it++)
+		{
+			OctreeNode node;
+
+			if (it->subtree != NULL)
+			{
+				node = (*it->subtree)[it->index];
+			}
+			else
+			{
+				auto editNode = editNodes.find(it->index);
+
+				if (editNode != editNodes.end())
+				{
+					// Ancestor of changed subtrees, some of its children can be new or built again
+					const OctreeNode &existingNode = (*nodes)[it->index];
+					node = editNode->second->node;
+					node.childrenStartOrLeafPositionFactors = levelEnd + nextLevel.size();
+
+					for (int i = 0; i < 8; i++)
+					{
+						if (node.properties.childrenMask & (1 << i))
+						{
+							if (existingNode.properties.childrenMask & (1 << i))
+							{
+								nextLevel.push_back(GetReference(GetChild(existingNode, i)));
+							}
+							else
+							{
+								nextLevel.push_back({ &editNode->second->newChildSubtrees[i], 0 });
+							}
+						}
+					}
+
+					outNodes.push_back(node);
+					continue;
+				}
+
+				node = (*nodes)[it->index];
+			}
+
+			// Unchanged nodes keep their children
+			if (!node.IsLeafNode())
+			{
+				UINT childrenStart = node.childrenStartOrLeafPositionFactors;
+				node.childrenStartOrLeafPositionFactors = levelEnd + nextLevel.size();
+
+				for (int i = 0; i < 8; i++)
+				{
+					if (node.properties.childrenMask & (1 << i))
+					{
+						nextLevel.push_back({ it->subtree, childrenStart++ });
+					}
+				}
+			}
+
+			outNodes.push_back(node);
+		}
+
+		level.swap(nextLevel);
+	}
+}
+
+PointCloudEngine::OctreeEditor::NodeReference PointCloudEngine::OctreeEditor::GetReference(UINT index)
+{
+	auto it = editNodes.find(index);
+
+	// The root of a subtree that was built again replaces the existing node
+	if ((it != editNodes.end()) && it->second->rebuild)
+	{
+		return { &it->second->subtree, 0 };
+	}
+
+	return { NULL, index };
+}
+
+bool PointCloudEngine::OctreeEditor::IsDeleted(const Vector3 &position)
+{
+	for (auto it = deleteBoxes.begin(); it != deleteBoxes.end(); it++)
+	{
+		const Vector3 &boxMin = it->first;
+		const Vector3 &boxMax = it->second;
+
+		if ((position.x >= boxMin.x) && (position.y >= boxMin.y) && (position.z >= boxMin.z) && (position.x <= boxMax.x) && (position.y <= boxMax.y) && (position.z <= boxMax.z))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+UINT PointCloudEngine::OctreeEditor::GetChild(const OctreeNode &node, int childIndex)
+{
+	// The existing children are stored after each other in the order of the mask bits
+	UINT index = node.childrenStartOrLeafPositionFactors;
+
+	for (int i = 0; i < childIndex; i++)
+	{
+		index += (node.properties.childrenMask >> i) & 1;
+	}
+
+	return index;
+}
@@ -0,0 +1,71 @@
+#ifndef OCTREEEDITOR_H
+#define OCTREEEDITOR_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Inserts and deletes vertices of an existing octree without building the whole octree again
+	// Only the smallest subtrees that contain changed vertices are built again, their vertices are collected in one pass over the .pointcloud file
+	// The ancestors of these subtrees merge the clusters of their children like the bottom up aggregation (unchanged children are dequantized)
+	// Afterwards the nodes are linked again in breadth first order and the .pointcloud file is replaced by a file that contains the changes
+	class OctreeEditor
+	{
+	public:
+		// The subtrees are built again with the parameters that the octree was built with, otherwise the .octree file key would not match its nodes
+		OctreeEditor(std::vector<OctreeNode> &nodes, const Vector3 &rootPosition, const float &rootSize, const OctreeBuildParameters &buildParameters);
+		~OctreeEditor();
+
+		// Returns false without any changes when one of the vertices is outside of the root bounding cube
+		bool Insert(const std::vector<Vertex> &vertices);
+
+		// Removes all the vertices inside the axis aligned box, this includes inserted vertices
+		void Delete(const Vector3 &boxMin, const Vector3 &boxMax);
+
+		// Applies all the insertions and deletions to the nodes and the .pointcloud file
+		// Returns false when the .pointcloud file cannot be read or written or when no vertices would remain, then nothing is changed
+		bool Apply(const std::wstring &pointcloudFile);
+
+		// Number of subtrees that were built again by the last call to Apply
+		size_t GetRebuiltSubtreeCount() const;
+
+	private:
+		// Changed node of the existing octree, either the root of a subtree that is built again or an ancestor of such a subtree
+		struct OctreeEditNode;
+
+		// Node of the new octree, either an existing node or a node of a subtree that was built again
+		struct NodeReference
+		{
+			const std::vector<OctreeNode> *subtree;
+			UINT index;
+		};
+
+		// Vertices that are read from the .pointcloud file at once
+		static const size_t chunkSize = 1 << 20;
+
+		std::vector<OctreeNode> *nodes = NULL;
+		Vector3 rootPosition;
+		float rootSize;
+		OctreeBuildParameters buildParameters;
+		size_t rebuiltSubtreeCount = 0;
+
+		std::vector<Vertex> insertedVertices;
+		std::vector<std::pair<Vector3, Vector3>> deleteBoxes;
+		std::map<UINT, OctreeEditNode*> editNodes;
+
+		OctreeEditNode* GetEditNode(UINT index, UINT parentIndex, const Vector3 &position, const float &size, int depth);
+		void MarkDelete(UINT index, UINT parentIndex, const Vector3 &position, const float &size, int depth, const Vector3 &boxMin, const Vector3 &boxMax);
+		void RemoveNestedEditNodes();
+		bool ReadVertices(const std::wstring &pointcloudFile, const std::wstring &outputFile, UINT64 &outVertexCount);
+		void AddVertex(const Vertex &vertex);
+		void RebuildSubtrees();
+		void UpdateAncestors();
+		void Relink(std::vector<OctreeNode> &outNodes);
+		NodeReference GetReference(UINT index);
+
+		bool IsDeleted(const Vector3 &position);
+		static UINT GetChild(const OctreeNode &node, int childIndex);
+	};
+}
+#endif
\ No newline at end of file
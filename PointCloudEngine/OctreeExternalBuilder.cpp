@@ -0,0 +1,532 @@
+#include "OctreeExternalBuilder.h"
+
+PointCloudEngine::OctreeExternalBuilder::OctreeExternalBuilder(const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress)
+{
+	this->buildMode = buildParameters.buildMode;
+	this->useBottomUpAggregation = buildParameters.useBottomUpAggregation;
+	this->maxDepth = buildParameters.maxDepth;
+	this->threadCount = buildParameters.threadCount;
+	this->memoryBudget = (UINT64)buildParameters.memoryBudget * 1024 * 1024;
+	this->compress = buildParameters.compress;
+	this->progress = progress;
+}
+
+PointCloudEngine::OctreeExternalBuilder::~OctreeExternalBuilder()
+{
+	SafeDelete(octreeBuilder);
+
+	for (auto it = levelFiles.begin(); it != levelFiles.end(); it++)
+	{
+		SafeDelete(*it);
+	}
+}
+
+bool PointCloudEngine::OctreeExternalBuilder::IsRequired(const std::wstring &pointcloudFile)
+{
+	std::ifstream file(pointcloudFile, std::ios::in | std::ios::binary);
+
+	Vector3 rootPosition;
+	float rootSize;
+	UINT64 vertexCount;
+
+	return ReadPointcloudHeader(file, rootPosition, rootSize, vertexCount) && IsRequired(vertexCount);
+}
+
+bool PointCloudEngine::OctreeExternalBuilder::IsRequired(UINT64 vertexCount)
+{
+	return !FitsIntoMemory(vertexCount);
+}
+
+PointCloudEngine::OctreeBuildStatistics PointCloudEngine::OctreeExternalBuilder::Build(const std::wstring &pointcloudFile, const std::wstring &octreeFile)
+{
+	Vector3 rootPosition;
+	float rootSize;
+	UINT64 vertexCount;
+
+	std::ifstream file(pointcloudFile, std::ios::in | std::ios::binary);
+
+	if (!ReadPointcloudHeader(file, rootPosition, rootSize, vertexCount))
+	{
+		throw std::exception("Could not load .pointcloud file!");
+	}
+
+	// The size of the header depends on the vertex count
+	UINT64 headerSize = file.tellg();
+	file.close();
+
+	OctreeBuildStatistics statistics;
+	statistics.vertexCount = vertexCount;
+	Benchmark::StartBuildStatistics(statistics);
+
+	// Builds that run at the same time (e.g. in another instance) never use the same temporary files
+	temporaryDirectory = Octree::CreateTemporaryDirectory();
+
+	if (progress != NULL)
+	{
+		progress->vertexCount = vertexCount;
+	}
+
+	// One builder for all the subtrees, this way the worker threads are only created once
+	octreeBuilder = new OctreeBuilder(buildMode, useBottomUpAggregation, maxDepth, threadCount, progress);
+
+	// The vertices of the root cube are read directly from the .pointcloud file which is never deleted
+	VertexRun rootRun;
+	rootRun.filename = pointcloudFile;
+	rootRun.offset = headerSize;
+	rootRun.count = vertexCount;
+	rootRun.temporary = false;
+
+	try
+	{
+		BuildCube(rootRun, rootPosition, rootSize, 0);
+		SafeDelete(octreeBuilder);
+
+		Stitch(rootPosition, rootSize, octreeFile);
+	}
+	catch (...)
+	{
+		DeleteTemporaryFiles();
+		throw;
+	}
+
+	RemoveDirectory(temporaryDirectory.c_str());
+
+	for (auto it = levelNodeCounts.begin(); it != levelNodeCounts.end(); it++)
+	{
+		statistics.nodeCount += *it;
+	}
+
+	Benchmark::FinishBuildStatistics(statistics);
+
+	return statistics;
+}
+
+PointCloudEngine::OctreeNodeClusters PointCloudEngine::OctreeExternalBuilder::BuildCube(const VertexRun &run, const Vector3 &position, const float &size, int depth)
+{
+	// Cubes at the maximum depth are leaves and cannot be partitioned any further
+	if (FitsIntoMemory(run.count) || (run.count <= 1) || (depth >= maxDepth))
+	{
+		return BuildSubtree(&run, 1, position, size, depth);
+	}
+
+	// Spill the vertices into the cubes of the next levels, afterwards the vertices of this run are not needed anymore
+	int levels = min(partitionLevels, maxDepth - depth);
+	std::vector<VertexRun> runs;
+
+	Partition(run, position, size, levels, runs);
+	DeleteRun(run);
+
+	return BuildPartition(runs, 0, levels, position, size, depth);
+}
+
+PointCloudEngine::OctreeNodeClusters PointCloudEngine::OctreeExternalBuilder::BuildPartition(const std::vector<VertexRun> &runs, size_t firstRun, int levels, const Vector3 &position, const float &size, int depth)
+{
+	// Reached the cubes of the temporary files, these might have to be partitioned again
+	if (levels == 0)
+	{
+		return BuildCube(runs[firstRun], position, size, depth);
+	}
+
+	// The runs of the cubes inside this cube are stored after each other (same order as the Morton code)
+	size_t runCount = (size_t)1 << (3 * levels);
+	UINT64 vertexCount = 0;
+
+	for (size_t i = firstRun; i < firstRun + runCount; i++)
+	{
+		vertexCount += runs[i].count;
+	}
+
+	if (FitsIntoMemory(vertexCount) || (vertexCount <= 1))
+	{
+		return BuildSubtree(&runs[firstRun], runCount, position, size, depth);
+	}
+
+	// Reserve the position of this node in its level before any of its children are appended to the next level
+	// Then its first child is the next node that is appended to the next level
+	UINT64 nodeIndex = ReserveNode(depth);
+
+	OctreeNode node;
+	node.properties.childrenMask = 0;
+	node.childrenStartOrLeafPositionFactors = levelNodeCounts[depth + 1];
+
+	OctreeNodeClusters childClusters[8];
+	int childCount = 0;
+	size_t childRunCount = runCount / 8;
+
+	for (int i = 0; i < 8; i++)
+	{
+		size_t childFirstRun = firstRun + i * childRunCount;
+		UINT64 childVertexCount = 0;
+
+		for (size_t j = childFirstRun; j < childFirstRun + childRunCount; j++)
+		{
+			childVertexCount += runs[j].count;
+		}
+
+		if (childVertexCount > 0)
+		{
+			node.properties.childrenMask |= 1 << i;
+			childClusters[childCount++] = BuildPartition(runs, childFirstRun, levels - 1, OctreeNode::GetChildPosition(position, size, i), size * 0.5f, depth + 1);
+		}
+	}
+
+	OctreeNodeClusters clusters;
+	OctreeNode::MergeClusters(childClusters, childCount, clusters);
+	node.SetProperties(clusters);
+	innerNodes[depth][nodeIndex] = node;
+
+	return clusters;
+}
+
+PointCloudEngine::OctreeNodeClusters PointCloudEngine::OctreeExternalBuilder::BuildSubtree(const VertexRun *runs, size_t runCount, const Vector3 &position, const float &size, int depth)
+{
+	std::vector<Vertex> vertices;
+	UINT64 vertexCount = 0;
+
+	for (size_t i = 0; i < runCount; i++)
+	{
+		vertexCount += runs[i].count;
+	}
+
+	vertices.reserve(vertexCount);
+
+	for (size_t i = 0; i < runCount; i++)
+	{
+		if (runs[i].count > 0)
+		{
+			ReadVertices(runs[i], vertices);
+			DeleteRun(runs[i]);
+		}
+	}
+
+	std::vector<OctreeNode> nodes;
+	octreeBuilder->Build(nodes, vertices, position, size, depth);
+
+	// Free the vertices before the nodes are written
+	std::vector<Vertex>().swap(vertices);
+	AppendNodes(nodes, depth);
+
+	return octreeBuilder->GetRootClusters();
+}
+
+void PointCloudEngine::OctreeExternalBuilder::Partition(const VertexRun &run, const Vector3 &position, const float &size, int levels, std::vector<VertexRun> &outRuns)
+{
+	size_t runCount = (size_t)1 << (3 * levels);
+	// The streams are closed during unwinding, otherwise the temporary files and their directory could not be deleted after an exception
+	std::vector<std::unique_ptr<std::ofstream>> files(runCount);
+	std::vector<std::vector<PointcloudVertex>> buffers(runCount);
+
+	outRuns.resize(runCount);
+
+	for (size_t i = 0; i < runCount; i++)
+	{
+		outRuns[i].filename = temporaryDirectory + L"/" + std::to_wstring(temporaryFileCount++) + L".tmp";
+		outRuns[i].offset = 0;
+		outRuns[i].count = 0;
+		outRuns[i].temporary = true;
+	}
+
+	// Files are only created for cubes that contain vertices
+	auto writeBuffer = [&](size_t i)
+	{
+		if (files[i] == NULL)
+		{
+			files[i].reset(new std::ofstream(outRuns[i].filename, std::ios::out | std::ios::binary));
+		}
+
+		files[i]->write((char*)buffers[i].data(), buffers[i].size() * sizeof(PointcloudVertex));
+
+		if (!*files[i])
+		{
+			throw std::exception("Could not write temporary octree file!");
+		}
+
+		outRuns[i].count += buffers[i].size();
+		buffers[i].clear();
+	};
+
+	std::ifstream file(run.filename, std::ios::in | std::ios::binary);
+	file.seekg(run.offset);
+
+	std::vector<PointcloudVertex> chunk(min((UINT64)chunkSize, run.count));
+
+	for (UINT64 chunkStart = 0; chunkStart < run.count; chunkStart += chunk.size())
+	{
+		size_t count = min((UINT64)chunk.size(), run.count - chunkStart);
+		file.read((char*)chunk.data(), count * sizeof(PointcloudVertex));
+
+		if (!file)
+		{
+			throw std::exception("Could not read vertices for the octree generation!");
+		}
+
+		if (progress != NULL)
+		{
+			// Stop after closing the temporary files
+			if (progress->canceled)
+			{
+				break;
+			}
+
+			if (!run.temporary)
+			{
+				progress->loadedVertexCount += count;
+			}
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			// Descend with the same floating point comparisons as the in memory builders, the index is the Morton code of the cube
+			Vector3 cubePosition = position;
+			float cubeSize = size;
+			size_t runIndex = 0;
+
+			for (int level = 0; level < levels; level++)
+			{
+				int childIndex = OctreeNode::GetChildIndex(cubePosition, chunk[i].position);
+				runIndex = (runIndex << 3) | childIndex;
+
+				cubePosition = OctreeNode::GetChildPosition(cubePosition, cubeSize, childIndex);
+				cubeSize *= 0.5f;
+			}
+
+			buffers[runIndex].push_back(chunk[i]);
+
+			if (buffers[runIndex].size() >= runBufferSize)
+			{
+				writeBuffer(runIndex);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < runCount; i++)
+	{
+		if (!buffers[i].empty())
+		{
+			writeBuffer(i);
+		}
+
+		files[i].reset();
+	}
+
+	if (progress != NULL)
+	{
+		progress->ThrowIfCanceled();
+	}
+}
+
+void PointCloudEngine::OctreeExternalBuilder::ReadVertices(const VertexRun &run, std::vector<Vertex> &outVertices)
+{
+	std::ifstream file(run.filename, std::ios::in | std::ios::binary);
+	file.seekg(run.offset);
+
+	std::vector<PointcloudVertex> chunk(min((UINT64)chunkSize, run.count));
+
+	for (UINT64 chunkStart = 0; chunkStart < run.count; chunkStart += chunk.size())
+	{
+		size_t count = min((UINT64)chunk.size(), run.count - chunkStart);
+		file.read((char*)chunk.data(), count * sizeof(PointcloudVertex));
+
+		if (!file)
+		{
+			throw std::exception("Could not read vertices for the octree generation!");
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			outVertices.push_back(chunk[i].GetVertex());
+		}
+
+		if ((progress != NULL) && !run.temporary)
+		{
+			progress->loadedVertexCount += count;
+		}
+	}
+}
+
+void PointCloudEngine::OctreeExternalBuilder::DeleteRun(const VertexRun &run)
+{
+	if (run.temporary && (run.count > 0))
+	{
+		DeleteFile(run.filename.c_str());
+	}
+}
+
+UINT64 PointCloudEngine::OctreeExternalBuilder::ReserveNode(int level)
+{
+	// The node is written when stitching the levels, until then an empty node keeps its position in the level file
+	AddLevels(level + 2);
+
+	OctreeNode node;
+	ZeroMemory(&node, sizeof(OctreeNode));
+	levelFiles[level]->write((char*)&node, sizeof(OctreeNode));
+	AddNodeCount(1);
+
+	if (progress != NULL)
+	{
+		progress->AddNodes(level, 1);
+	}
+
+	return levelNodeCounts[level]++;
+}
+
+void PointCloudEngine::OctreeExternalBuilder::AppendNodes(std::vector<OctreeNode> &nodes, int depth)
+{
+	AddNodeCount(nodes.size());
+
+	// The nodes of the subtree are stored level by level, the children of each level follow right after it
+	size_t levelStart = 0;
+	size_t levelEnd = min((size_t)1, nodes.size());
+
+	for (int level = depth; levelStart < levelEnd; level++)
+	{
+		AddLevels(level + 2);
+
+		size_t nextLevelEnd = levelEnd;
+
+		for (size_t i = levelStart; i < levelEnd; i++)
+		{
+			if (!nodes[i].IsLeafNode())
+			{
+				// The children index is relative to the start of the next level in the subtree, convert it to the position in the level file
+				for (int j = 0; j < 8; j++)
+				{
+					nextLevelEnd += (nodes[i].properties.childrenMask >> j) & 1;
+				}
+
+				nodes[i].childrenStartOrLeafPositionFactors = levelNodeCounts[level + 1] + (nodes[i].childrenStartOrLeafPositionFactors - levelEnd);
+			}
+		}
+
+		levelFiles[level]->write((char*)&nodes[levelStart], (levelEnd - levelStart) * sizeof(OctreeNode));
+
+		if (!*levelFiles[level])
+		{
+			throw std::exception("Could not write temporary octree file!");
+		}
+
+		levelNodeCounts[level] += levelEnd - levelStart;
+		levelStart = levelEnd;
+		levelEnd = nextLevelEnd;
+	}
+}
+
+void PointCloudEngine::OctreeExternalBuilder::Stitch(const Vector3 &rootPosition, const float &rootSize, const std::wstring &octreeFile)
+{
+	// The children positions are relative to their level, the levels are stored after each other in the .octree file
+	std::vector<UINT64> levelStarts(levelNodeCounts.size() + 1, 0);
+
+	for (size_t level = 0; level < levelNodeCounts.size(); level++)
+	{
+		levelStarts[level + 1] = levelStarts[level] + levelNodeCounts[level];
+		SafeDelete(levelFiles[level]);
+	}
+
+	// The nodes are streamed into the file level by level
+	OctreeFile file;
+
+	if (!file.Create(octreeFile, levelStarts.back(), rootPosition, rootSize, compress, threadCount))
+	{
+		throw std::exception("Could not write .octree file!");
+	}
+
+	std::vector<OctreeNode> chunk;
+
+	for (size_t level = 0; level < levelNodeCounts.size(); level++)
+	{
+		std::ifstream levelFile(GetLevelFilename(level), std::ios::in | std::ios::binary);
+		auto innerNode = innerNodes[level].begin();
+
+		chunk.resize(min((UINT64)chunkSize, levelNodeCounts[level]));
+
+		for (UINT64 chunkStart = 0; chunkStart < levelNodeCounts[level]; chunkStart += chunk.size())
+		{
+			size_t count = min((UINT64)chunk.size(), levelNodeCounts[level] - chunkStart);
+			levelFile.read((char*)chunk.data(), count * sizeof(OctreeNode));
+
+			if (!levelFile)
+			{
+				throw std::exception("Could not read temporary octree file!");
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				// Fill in the reserved nodes, they are sorted by their position
+				if ((innerNode != innerNodes[level].end()) && (innerNode->first == chunkStart + i))
+				{
+					chunk[i] = innerNode->second;
+					innerNode++;
+				}
+
+				if (!chunk[i].IsLeafNode())
+				{
+					chunk[i].childrenStartOrLeafPositionFactors += levelStarts[level + 1];
+				}
+			}
+
+			if (!file.Append(chunk.data(), count))
+			{
+				throw std::exception("Could not write .octree file!");
+			}
+		}
+
+		levelFile.close();
+		DeleteFile(GetLevelFilename(level).c_str());
+	}
+
+	if (!file.Finish())
+	{
+		throw std::exception("Could not write .octree file!");
+	}
+}
+
+void PointCloudEngine::OctreeExternalBuilder::AddNodeCount(UINT64 count)
+{
+	nodeCount += count;
+
+	// The children start indices in the level files are already 32 bit, stop before the remaining cubes are built
+	if (nodeCount > OctreeNode::maxNodeCount)
+	{
+		throw std::exception("Octrees with more than 4G nodes are not supported!");
+	}
+}
+
+void PointCloudEngine::OctreeExternalBuilder::AddLevels(int levelCount)
+{
+	for (int level = levelFiles.size(); level < levelCount; level++)
+	{
+		levelFiles.push_back(new std::ofstream(GetLevelFilename(level), std::ios::out | std::ios::binary));
+		levelNodeCounts.push_back(0);
+		innerNodes.push_back(std::map<UINT64, OctreeNode>());
+	}
+}
+
+std::wstring PointCloudEngine::OctreeExternalBuilder::GetLevelFilename(int level)
+{
+	return temporaryDirectory + L"/Level" + std::to_wstring(level) + L".tmp";
+}
+
+void PointCloudEngine::OctreeExternalBuilder::DeleteTemporaryFiles()
+{
+	SafeDelete(octreeBuilder);
+
+	// The files of the vertex runs are numbered, the ones that were already deleted are skipped
+	for (UINT i = 0; i < temporaryFileCount; i++)
+	{
+		DeleteFile((temporaryDirectory + L"/" + std::to_wstring(i) + L".tmp").c_str());
+	}
+
+	for (size_t level = 0; level < levelFiles.size(); level++)
+	{
+		SafeDelete(levelFiles[level]);
+		DeleteFile(GetLevelFilename(level).c_str());
+	}
+
+	RemoveDirectory(temporaryDirectory.c_str());
+}
+
+bool PointCloudEngine::OctreeExternalBuilder::FitsIntoMemory(UINT64 vertexCount)
+{
+	// The in memory builder uses 32 bit vertex ranges
+	return (vertexCount * bytesPerVertex <= memoryBudget) && (vertexCount <= UINT_MAX);
+}
@@ -0,0 +1,89 @@
+#ifndef OCTREEEXTERNALBUILDER_H
+#define OCTREEEXTERNALBUILDER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Builds the .octree file of point clouds that are too large to build in memory
+	// The .pointcloud file is streamed in chunks and the vertices are spilled into one temporary file for each cube two levels below
+	// Cubes that fit into the memory budget are built in memory by the OctreeBuilder, larger cubes are partitioned again
+	// The nodes are appended to one temporary file per level, which keeps the breadth first order, and stitched into one .octree file at the end
+	// The few nodes above the cubes that are built in memory are always aggregated bottom up from the clusters of their children
+	// Only the vertex count is unlimited, the octree has at most OctreeNode::maxNodeCount nodes like every other octree
+	class OctreeExternalBuilder
+	{
+	public:
+		// The memory budget of the parameters is given in megabytes
+		OctreeExternalBuilder(const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress = NULL);
+		~OctreeExternalBuilder();
+
+		// True if building this point cloud in memory would exceed the memory budget
+		bool IsRequired(const std::wstring &pointcloudFile);
+		bool IsRequired(UINT64 vertexCount);
+
+		// Writes the .octree file without ever loading all the vertices or nodes into memory
+		// The temporary files are deleted when the build fails or is canceled
+		OctreeBuildStatistics Build(const std::wstring &pointcloudFile, const std::wstring &octreeFile);
+
+	private:
+		// Vertices that are stored after each other in a .pointcloud or temporary file
+		struct VertexRun
+		{
+			std::wstring filename;
+			UINT64 offset;
+			UINT64 count;
+			bool temporary;
+		};
+
+		// Estimated peak memory per vertex of an in memory build (vertices, temporary build nodes or sort keys and the resulting nodes)
+		static const UINT64 bytesPerVertex = 160;
+
+		// Octree levels that are partitioned in one pass over a file, creates up to 8^2 temporary files at once
+		static const int partitionLevels = 2;
+
+		// Vertices or nodes that are read from a file at once
+		static const size_t chunkSize = 1 << 20;
+
+		// Vertices that are buffered for each temporary file before writing them
+		static const size_t runBufferSize = 1 << 14;
+
+		OctreeBuildMode buildMode;
+		bool useBottomUpAggregation;
+		int maxDepth;
+		UINT threadCount;
+		UINT64 memoryBudget;
+		bool compress;
+		OctreeBuildProgress *progress = NULL;
+
+		OctreeBuilder *octreeBuilder = NULL;
+		std::wstring temporaryDirectory;
+		UINT temporaryFileCount = 0;
+
+		// Temporary file, node count and the nodes above the in memory subtrees (key is the position in the level) of each level
+		std::vector<std::ofstream*> levelFiles;
+		std::vector<UINT64> levelNodeCounts;
+		std::vector<std::map<UINT64, OctreeNode>> innerNodes;
+		UINT64 nodeCount = 0;
+
+		OctreeNodeClusters BuildCube(const VertexRun &run, const Vector3 &position, const float &size, int depth);
+		OctreeNodeClusters BuildPartition(const std::vector<VertexRun> &runs, size_t firstRun, int levels, const Vector3 &position, const float &size, int depth);
+		OctreeNodeClusters BuildSubtree(const VertexRun *runs, size_t runCount, const Vector3 &position, const float &size, int depth);
+		void Partition(const VertexRun &run, const Vector3 &position, const float &size, int levels, std::vector<VertexRun> &outRuns);
+		void ReadVertices(const VertexRun &run, std::vector<Vertex> &outVertices);
+		void DeleteRun(const VertexRun &run);
+
+		UINT64 ReserveNode(int level);
+		void AppendNodes(std::vector<OctreeNode> &nodes, int depth);
+		void Stitch(const Vector3 &rootPosition, const float &rootSize, const std::wstring &octreeFile);
+		// Throws as soon as the octree exceeds OctreeNode::maxNodeCount instead of after all the cubes were built
+		void AddNodeCount(UINT64 count);
+		void AddLevels(int levelCount);
+		std::wstring GetLevelFilename(int level);
+		void DeleteTemporaryFiles();
+
+		bool FitsIntoMemory(UINT64 vertexCount);
+	};
+}
+#endif
\ No newline at end of file
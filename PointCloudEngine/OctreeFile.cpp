@@ -0,0 +1,696 @@
+#include "OctreeFile.h"
+
+const char PointCloudEngine::OctreeFile::magic[8] = { 'P', 'C', 'O', 'C', 'T', 'R', 'E', 'E' };
+
+// The checksum reads whole 64 bit words, the nodes are appended in parts that have to keep this alignment
+static_assert(sizeof(PointCloudEngine::OctreeNode) % 8 == 0, "The octree node size has to be a multiple of 8 bytes");
+
+PointCloudEngine::OctreeFile::OctreeFile()
+{
+	ZeroMemory(&header, sizeof(OctreeFileHeader));
+}
+
+PointCloudEngine::OctreeFile::~OctreeFile()
+{
+	// Files that were not finished are removed, e.g. when the compression threw an exception
+	DiscardOutput();
+	Close();
+	SafeDelete(threadPool);
+}
+
+bool PointCloudEngine::OctreeFile::Open(const std::wstring &filename, const FileReadParameters &fileReadParameters, OctreeBuildProgress *progress)
+{
+	Close();
+
+	// Other processes can open and map the same file at the same time
+	file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size) || (size.QuadPart < sizeof(OctreeFileHeader)))
+	{
+		Close();
+		return false;
+	}
+
+	fileSize = size.QuadPart;
+	this->filename = filename;
+
+	mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	view = (mapping != NULL) ? (const byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (view == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	memcpy(&header, view, sizeof(OctreeFileHeader));
+
+	if (!IsHeaderValid())
+	{
+		Close();
+		return false;
+	}
+
+	// Compressed files are read completely and verified while decompressing, the pages of paged files are checked by the page cache when they are read
+	if (IsCompressed() || IsPaged())
+	{
+		return true;
+	}
+
+	// The mapped nodes are traversed and uploaded without copying them, a corrupt or partly copied file must not contain child indices past the nodes
+	// Files that were checked before (or written by this program) are not read again, only their pages that are actually used are loaded
+	if (!fileReadParameters.verifyOctreeFiles && IsValidated())
+	{
+		return true;
+	}
+
+	// The mapping only reads a few pages at a time, larger reads of multiple threads load the nodes into the file cache ahead of the checks
+	ParallelFileReader reader(fileReadParameters.threadCount, false, fileReadParameters.backendType);
+	reader.Start(filename, header.nodesOffset, header.nodeCount * sizeof(OctreeNode), NULL);
+
+	// Read the nodes in chunks in order to report the progress
+	const UINT64 chunkSize = 1 << 20;
+	UINT64 checksum = checksumSeed;
+	bool childrenValid = true;
+
+	for (UINT64 chunkStart = 0; childrenValid && (chunkStart < header.nodeCount); chunkStart += chunkSize)
+	{
+		UINT64 count = min(chunkSize, header.nodeCount - chunkStart);
+		childrenValid = AreChildrenValid(GetNodes() + chunkStart, count, header.nodeCount);
+
+		if (fileReadParameters.verifyOctreeFiles)
+		{
+			checksum = ComputeChecksum(GetNodes() + chunkStart, count * sizeof(OctreeNode), checksum);
+		}
+
+		if (progress != NULL)
+		{
+			progress->ThrowIfCanceled();
+			progress->loadedNodeCount += count;
+		}
+	}
+
+	reader.Wait();
+	Benchmark::Log(L"Read " + filename + L": " + reader.GetStatistics());
+
+	if (!childrenValid)
+	{
+		Benchmark::Log(L"The child indices of " + filename + L" are outside of the nodes");
+		Close();
+		return false;
+	}
+
+	if (fileReadParameters.verifyOctreeFiles && (checksum != header.nodesChecksum))
+	{
+		Benchmark::Log(L"The nodes checksum of " + filename + L" does not match");
+		Close();
+		return false;
+	}
+
+	SaveValidated(filename);
+
+	return true;
+}
+
+void PointCloudEngine::OctreeFile::Close()
+{
+	if (view != NULL)
+	{
+		UnmapViewOfFile(view);
+		view = NULL;
+	}
+
+	if (mapping != NULL)
+	{
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+}
+
+bool PointCloudEngine::OctreeFile::IsOpen() const
+{
+	return view != NULL;
+}
+
+bool PointCloudEngine::OctreeFile::IsCompressed() const
+{
+	return header.encoding == compressedEncoding;
+}
+
+bool PointCloudEngine::OctreeFile::IsPaged() const
+{
+	return header.encoding == pagedEncoding;
+}
+
+const PointCloudEngine::OctreeNode* PointCloudEngine::OctreeFile::GetNodes() const
+{
+	return ((view != NULL) && (header.encoding == rawEncoding)) ? (const OctreeNode*)(view + header.nodesOffset) : NULL;
+}
+
+UINT64 PointCloudEngine::OctreeFile::GetNodeCount() const
+{
+	return header.nodeCount;
+}
+
+const PointCloudEngine::OctreeFileHeader& PointCloudEngine::OctreeFile::GetHeader() const
+{
+	return header;
+}
+
+const PointCloudEngine::OctreeFileChunk* PointCloudEngine::OctreeFile::GetChunks() const
+{
+	return ((view != NULL) && (header.encoding != rawEncoding)) ? (const OctreeFileChunk*)(view + header.nodesOffset) : NULL;
+}
+
+UINT64 PointCloudEngine::OctreeFile::GetChunkCount() const
+{
+	return (header.chunkNodeCount > 0) ? ((header.nodeCount + header.chunkNodeCount - 1) / header.chunkNodeCount) : 0;
+}
+
+bool PointCloudEngine::OctreeFile::Decompress(std::vector<OctreeNode> &outNodes, UINT threadCount, OctreeBuildProgress *progress)
+{
+	if (!IsOpen() || !IsCompressed())
+	{
+		return false;
+	}
+
+	const OctreeFileChunk *chunkTable = (const OctreeFileChunk*)(view + header.nodesOffset);
+	UINT64 chunkCount = GetChunkCount();
+	std::atomic<bool> valid(true);
+
+	outNodes.resize(header.nodeCount);
+
+	// The chunks are independent, each task reads its chunk from the mapping and decodes it directly into the nodes
+	ThreadPool decompressionThreadPool(threadCount);
+
+	for (UINT64 i = 0; i < chunkCount; i++)
+	{
+		decompressionThreadPool.Submit([&, i]()
+		{
+			if ((progress != NULL) && progress->canceled)
+			{
+				return;
+			}
+
+			UINT64 chunkStart = i * header.chunkNodeCount;
+			size_t count = min((UINT64)header.chunkNodeCount, header.nodeCount - chunkStart);
+			const OctreeFileChunk &chunk = chunkTable[i];
+
+			if ((chunk.offset > fileSize) || (chunk.size > fileSize - chunk.offset) || !DecodeChunk(view + chunk.offset, chunk.size, outNodes.data() + chunkStart, count))
+			{
+				valid = false;
+			}
+
+			if (progress != NULL)
+			{
+				progress->loadedNodeCount += count;
+			}
+		});
+	}
+
+	decompressionThreadPool.Wait();
+
+	if (progress != NULL)
+	{
+		progress->ThrowIfCanceled();
+	}
+
+	if (!valid || (ComputeChecksum(outNodes.data(), outNodes.size() * sizeof(OctreeNode)) != header.nodesChecksum))
+	{
+		Benchmark::Log(L"The compressed nodes of " + filename + L" are corrupt");
+		std::vector<OctreeNode>().swap(outNodes);
+
+		return false;
+	}
+
+	return true;
+}
+
+bool PointCloudEngine::OctreeFile::Create(const std::wstring &filename, UINT64 nodeCount, const Vector3 &rootPosition, const float &rootSize, bool compress, UINT threadCount)
+{
+	ZeroMemory(&header, sizeof(OctreeFileHeader));
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.byteOrder = 0x01020304;
+	header.headerSize = sizeof(OctreeFileHeader);
+	header.nodeSize = sizeof(OctreeNode);
+	header.nodeCount = nodeCount;
+	header.nodesOffset = nodesAlignment;
+	header.rootPosition = rootPosition;
+	header.rootSize = rootSize;
+	header.encoding = compress ? compressedEncoding : rawEncoding;
+	header.chunkNodeCount = compress ? chunkNodeCount : 0;
+	header.nodesChecksum = checksumSeed;
+
+	// Each writer has its own temporary file, other threads or processes can write the same octree at the same time
+	DiscardOutput();
+	this->filename = filename;
+	this->temporaryFilename = filename + L"." + Octree::GetUniqueTemporaryName() + L".tmp";
+	appendedNodeCount = 0;
+	appendedChildrenValid = true;
+	pendingNodes.clear();
+	chunks.clear();
+
+	if (compress && (threadPool == NULL))
+	{
+		threadPool = new ThreadPool(threadCount);
+	}
+
+	// The header is written again with the checksums at the end, the padding keeps the nodes page aligned for the mapping
+	output.open(temporaryFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	std::vector<char> padding(nodesAlignment, 0);
+	output.write(padding.data(), padding.size());
+
+	// The chunk table is filled in at the end as well
+	if (compress)
+	{
+		std::vector<OctreeFileChunk> emptyChunks(GetChunkCount());
+		ZeroMemory(emptyChunks.data(), emptyChunks.size() * sizeof(OctreeFileChunk));
+		output.write((char*)emptyChunks.data(), emptyChunks.size() * sizeof(OctreeFileChunk));
+	}
+
+	return output.good();
+}
+
+bool PointCloudEngine::OctreeFile::Append(const OctreeNode *nodes, size_t count)
+{
+	header.nodesChecksum = ComputeChecksum(nodes, count * sizeof(OctreeNode), header.nodesChecksum);
+	appendedNodeCount += count;
+
+	if (IsCompressed())
+	{
+		pendingNodes.insert(pendingNodes.end(), nodes, nodes + count);
+
+		// Compress a batch as soon as every thread can work on its own chunk
+		if (pendingNodes.size() >= (size_t)chunkNodeCount * (threadPool->GetThreadCount() + 1))
+		{
+			return CompressPendingNodes(false);
+		}
+	}
+	else
+	{
+		// The nodes are still in the cache, checking them here saves the pass over the mapped file when it is opened
+		appendedChildrenValid = appendedChildrenValid && AreChildrenValid(nodes, count, header.nodeCount);
+		output.write((char*)nodes, count * sizeof(OctreeNode));
+	}
+
+	return output.good();
+}
+
+bool PointCloudEngine::OctreeFile::CreatePaged(const std::wstring &filename, UINT64 pageCount, UINT pageNodeCount, const Vector3 &rootPosition, const float &rootSize)
+{
+	if (!Create(filename, pageCount * pageNodeCount, rootPosition, rootSize))
+	{
+		return false;
+	}
+
+	header.encoding = pagedEncoding;
+	header.chunkNodeCount = pageNodeCount;
+
+	// The page table is filled in at the end like the chunk table
+	std::vector<OctreeFileChunk> emptyPages(pageCount);
+	ZeroMemory(emptyPages.data(), emptyPages.size() * sizeof(OctreeFileChunk));
+	output.write((char*)emptyPages.data(), emptyPages.size() * sizeof(OctreeFileChunk));
+
+	return output.good();
+}
+
+bool PointCloudEngine::OctreeFile::AppendPage(const OctreeNode *nodes, size_t count)
+{
+	if (!IsPaged() || (count > header.chunkNodeCount))
+	{
+		output.setstate(std::ios::failbit);
+		return false;
+	}
+
+	header.nodesChecksum = ComputeChecksum(nodes, count * sizeof(OctreeNode), header.nodesChecksum);
+	appendedNodeCount += count;
+
+	OctreeFileChunk page;
+	page.offset = output.tellp();
+	page.size = count * sizeof(OctreeNode);
+	chunks.push_back(page);
+
+	output.write((char*)nodes, count * sizeof(OctreeNode));
+
+	return output.good();
+}
+
+bool PointCloudEngine::OctreeFile::Finish()
+{
+	if (IsCompressed() && output.is_open())
+	{
+		CompressPendingNodes(true);
+	}
+
+	// The pages do not fill the whole index space of paged files
+	if (output.is_open() && (IsPaged() || (appendedNodeCount == header.nodeCount)) && (chunks.size() == GetChunkCount()))
+	{
+		if (IsCompressed() || IsPaged())
+		{
+			output.seekp(header.nodesOffset);
+			output.write((char*)chunks.data(), chunks.size() * sizeof(OctreeFileChunk));
+		}
+
+		header.headerChecksum = ComputeHeaderChecksum(header);
+		output.seekp(0);
+		output.write((char*)&header, sizeof(OctreeFileHeader));
+		output.flush();
+	}
+	else
+	{
+		output.setstate(std::ios::failbit);
+	}
+
+	bool success = output.good();
+	output.close();
+
+	// Replace the previous file only when the new one is complete
+	if (success && MoveFileEx(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		if ((header.encoding == rawEncoding) && appendedChildrenValid)
+		{
+			SaveValidated(filename);
+		}
+
+		return true;
+	}
+
+	DeleteFile(temporaryFilename.c_str());
+
+	return false;
+}
+
+bool PointCloudEngine::OctreeFile::Write(const std::wstring &filename, const OctreeNode *nodes, UINT64 nodeCount, const Vector3 &rootPosition, const float &rootSize, bool compress, UINT threadCount, OctreeBuildProgress *progress)
+{
+	OctreeFile octreeFile;
+
+	try
+	{
+		if (!octreeFile.Create(filename, nodeCount, rootPosition, rootSize, compress, threadCount))
+		{
+			return false;
+		}
+
+		for (UINT64 start = 0; start < nodeCount; start += writeNodeCount)
+		{
+			if (progress != NULL)
+			{
+				progress->ThrowIfCanceled();
+			}
+
+			if (!octreeFile.Append(nodes + start, (size_t)min((UINT64)writeNodeCount, nodeCount - start)))
+			{
+				return false;
+			}
+		}
+
+		return octreeFile.Finish();
+	}
+	catch (...)
+	{
+		octreeFile.DiscardOutput();
+		throw;
+	}
+}
+
+bool PointCloudEngine::OctreeFile::ReadVersion1(const std::wstring &filename, std::vector<OctreeNode> &outNodes, Vector3 &outRootPosition, float &outRootSize, const FileReadParameters &fileReadParameters, OctreeBuildProgress *progress)
+{
+	std::ifstream octreeFile(filename, std::ios::in | std::ios::binary | std::ios::ate);
+
+	if (!octreeFile.is_open())
+	{
+		return false;
+	}
+
+	UINT64 fileSize = octreeFile.tellg();
+	octreeFile.seekg(0);
+
+	// Read the root position, root size and size of the nodes vector
+	UINT nodesSize = 0;
+	octreeFile.read((char*)&outRootPosition, sizeof(Vector3));
+	octreeFile.read((char*)&outRootSize, sizeof(float));
+	octreeFile.read((char*)&nodesSize, sizeof(UINT));
+
+	// There is no magic number, the file size has to match exactly
+	if (!octreeFile || (fileSize != sizeof(Vector3) + sizeof(float) + sizeof(UINT) + (UINT64)nodesSize * sizeof(OctreeNode)))
+	{
+		return false;
+	}
+
+	UINT64 nodesOffset = octreeFile.tellg();
+	octreeFile.close();
+
+	// Read the binary data directly into the nodes vector, in chunks with multiple threads that report the progress
+	ParallelFileReader reader(fileReadParameters);
+	UINT chunkSize = (ParallelFileReader::defaultChunkSize / sizeof(OctreeNode)) * sizeof(OctreeNode);
+	outNodes.resize(nodesSize);
+
+	bool read = reader.Read(filename, nodesOffset, (UINT64)nodesSize * sizeof(OctreeNode), outNodes.data(), chunkSize, [&](UINT64 chunkStart, UINT64 chunkBytes, const byte *chunk)
+	{
+		if (progress != NULL)
+		{
+			progress->loadedNodeCount += chunkBytes / sizeof(OctreeNode);
+		}
+	});
+
+	Benchmark::Log(L"Read " + filename + L": " + reader.GetStatistics());
+
+	if (progress != NULL)
+	{
+		progress->ThrowIfCanceled();
+	}
+
+	// There is no checksum in the first version
+	return read && AreChildrenValid(outNodes.data(), outNodes.size(), outNodes.size());
+}
+
+bool PointCloudEngine::OctreeFile::AreChildrenValid(const OctreeNode *nodes, size_t count, UINT64 nodeCount)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!nodes[i].IsLeafNode() && ((UINT64)nodes[i].childrenStartOrLeafPositionFactors + __popcnt(nodes[i].properties.childrenMask) > nodeCount))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool PointCloudEngine::OctreeFile::IsValidated() const
+{
+	// Size and last write time of the file when its child indices were checked
+	UINT64 validatedData[2] = { 0, 0 };
+	UINT64 fileData[2] = { 0, 0 };
+	std::ifstream validatedFile(filename + L".valid", std::ios::in | std::ios::binary);
+
+	return validatedFile.read((char*)validatedData, sizeof(validatedData)) && GetFileSizeAndLastWriteTime(filename, fileData) && (memcmp(validatedData, fileData, sizeof(fileData)) == 0);
+}
+
+void PointCloudEngine::OctreeFile::SaveValidated(const std::wstring &filename)
+{
+	UINT64 fileData[2] = { 0, 0 };
+
+	if (GetFileSizeAndLastWriteTime(filename, fileData))
+	{
+		std::ofstream validatedFile(filename + L".valid", std::ios::out | std::ios::binary | std::ios::trunc);
+		validatedFile.write((char*)fileData, sizeof(fileData));
+	}
+}
+
+bool PointCloudEngine::OctreeFile::GetFileSizeAndLastWriteTime(const std::wstring &filename, UINT64 outData[2])
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+	if (!GetFileAttributesExW(filename.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return false;
+	}
+
+	outData[0] = ((UINT64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	outData[1] = ((UINT64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+
+	return true;
+}
+
+UINT64 PointCloudEngine::OctreeFile::ComputeChecksum(const void *data, size_t size, UINT64 checksum)
+{
+	// FNV-1a on 64 bit words instead of single bytes, the remaining bytes at the end are added one by one
+	const UINT64 prime = 1099511628211ull;
+	const byte *bytes = (const byte*)data;
+	size_t wordCount = size / 8;
+
+	for (size_t i = 0; i < wordCount; i++)
+	{
+		UINT64 word;
+		memcpy(&word, bytes + 8 * i, 8);
+		checksum = (checksum ^ word) * prime;
+	}
+
+	for (size_t i = 8 * wordCount; i < size; i++)
+	{
+		checksum = (checksum ^ bytes[i]) * prime;
+	}
+
+	return checksum;
+}
+
+bool PointCloudEngine::OctreeFile::IsHeaderValid() const
+{
+	// Files from a machine with a different byte order or node layout are rejected and built again
+	if ((memcmp(header.magic, magic, sizeof(magic)) != 0) || (header.version != version) || (header.byteOrder != 0x01020304))
+	{
+		return false;
+	}
+
+	if ((header.headerSize != sizeof(OctreeFileHeader)) || (header.nodeSize != sizeof(OctreeNode)) || (header.headerChecksum != ComputeHeaderChecksum(header)))
+	{
+		return false;
+	}
+
+	if ((header.nodesOffset % nodesAlignment != 0) || (header.nodesOffset > fileSize))
+	{
+		return false;
+	}
+
+	if ((header.encoding == compressedEncoding) || (header.encoding == pagedEncoding))
+	{
+		return (header.chunkNodeCount > 0) && (GetChunkCount() <= (fileSize - header.nodesOffset) / sizeof(OctreeFileChunk));
+	}
+
+	return (header.encoding == rawEncoding) && (header.nodeCount <= (fileSize - header.nodesOffset) / sizeof(OctreeNode));
+}
+
+bool PointCloudEngine::OctreeFile::CompressPendingNodes(bool last)
+{
+	// Only full chunks are compressed until the last call, the remaining nodes stay pending
+	size_t chunkCount = last ? ((pendingNodes.size() + chunkNodeCount - 1) / chunkNodeCount) : (pendingNodes.size() / chunkNodeCount);
+	std::vector<std::vector<byte>> chunkData(chunkCount);
+
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		threadPool->Submit([&, i]()
+		{
+			size_t chunkStart = i * chunkNodeCount;
+			EncodeChunk(pendingNodes.data() + chunkStart, min((size_t)chunkNodeCount, pendingNodes.size() - chunkStart), chunkData[i]);
+		});
+	}
+
+	threadPool->Wait();
+
+	// Write the chunks in order after each other
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		OctreeFileChunk chunk;
+		chunk.offset = output.tellp();
+		chunk.size = chunkData[i].size();
+		chunks.push_back(chunk);
+
+		output.write((char*)chunkData[i].data(), chunkData[i].size());
+	}
+
+	pendingNodes.erase(pendingNodes.begin(), pendingNodes.begin() + min(pendingNodes.size(), chunkCount * chunkNodeCount));
+
+	return output.good();
+}
+
+void PointCloudEngine::OctreeFile::DiscardOutput()
+{
+	if (output.is_open())
+	{
+		output.close();
+		DeleteFile(temporaryFilename.c_str());
+	}
+}
+
+UINT64 PointCloudEngine::OctreeFile::ComputeHeaderChecksum(const OctreeFileHeader &header)
+{
+	return ComputeChecksum(&header, offsetof(OctreeFileHeader, headerChecksum));
+}
+
+void PointCloudEngine::OctreeFile::EncodeChunk(const OctreeNode *nodes, size_t count, std::vector<byte> &outData)
+{
+	// Byte shuffle the nodes, the n-th bytes of all the nodes are stored after each other (similar values are next to each other for the deflate)
+	// The children start indices increase in the breadth first layout, store the difference to the previous inner node in the chunk instead
+	ScratchArena::Scope scratchScope(ScratchArena::GetThreadArena());
+	size_t size = count * sizeof(OctreeNode);
+	byte *shuffled = ScratchArena::GetThreadArena().Allocate<byte>(size);
+	UINT previousChildrenStart = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		OctreeNode node = nodes[i];
+
+		if (!node.IsLeafNode())
+		{
+			UINT childrenStart = node.childrenStartOrLeafPositionFactors;
+			node.childrenStartOrLeafPositionFactors -= previousChildrenStart;
+			previousChildrenStart = childrenStart;
+		}
+
+		const byte *nodeBytes = (const byte*)&node;
+
+		for (size_t b = 0; b < sizeof(OctreeNode); b++)
+		{
+			shuffled[b * count + i] = nodeBytes[b];
+		}
+	}
+
+	uLongf compressedSize = compressBound(size);
+	outData.resize(compressedSize);
+
+	if (compress2(outData.data(), &compressedSize, shuffled, size, Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		throw std::exception("Could not compress .octree file chunk!");
+	}
+
+	outData.resize(compressedSize);
+}
+
+bool PointCloudEngine::OctreeFile::DecodeChunk(const byte *data, size_t size, OctreeNode *outNodes, size_t count)
+{
+	ScratchArena::Scope scratchScope(ScratchArena::GetThreadArena());
+	uLongf uncompressedSize = count * sizeof(OctreeNode);
+	byte *shuffled = ScratchArena::GetThreadArena().Allocate<byte>(uncompressedSize);
+
+	if ((uncompress(shuffled, &uncompressedSize, data, size) != Z_OK) || (uncompressedSize != count * sizeof(OctreeNode)))
+	{
+		return false;
+	}
+
+	// Inverse of the encoding, the childrenMask is restored before the children start because it is stored in a later byte
+	UINT previousChildrenStart = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		byte *nodeBytes = (byte*)&outNodes[i];
+
+		for (size_t b = 0; b < sizeof(OctreeNode); b++)
+		{
+			nodeBytes[b] = shuffled[b * count + i];
+		}
+
+		if (!outNodes[i].IsLeafNode())
+		{
+			outNodes[i].childrenStartOrLeafPositionFactors += previousChildrenStart;
+			previousChildrenStart = outNodes[i].childrenStartOrLeafPositionFactors;
+		}
+	}
+
+	return true;
+}
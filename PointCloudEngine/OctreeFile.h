@@ -0,0 +1,115 @@
+#ifndef OCTREEFILE_H
+#define OCTREEFILE_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Reads and writes the version 2 .octree files: a self describing header followed by the page aligned nodes array
+	// Opening a file maps it into memory, the nodes are used directly from the mapping without copying them (the page cache is shared between processes)
+	// Compressed files split the nodes into independent chunks that are byte shuffled, delta encoded and deflated, they are decompressed in parallel
+	// Paged files group subtrees into pages that are read on demand by the OctreePageCache, the chunk table stores the pages then
+	// Version 1 files only store the root position, root size, node count and nodes, they can still be read into a vector
+	class OctreeFile
+	{
+	public:
+		static const UINT version = 2;
+		static const UINT64 nodesAlignment = 4096;
+
+		static const UINT rawEncoding = 0;
+		static const UINT compressedEncoding = 1;
+		static const UINT pagedEncoding = 2;
+
+		// Nodes per compressed chunk (1.5 MB before compressing)
+		static const UINT chunkNodeCount = 1 << 16;
+
+		// Nodes that Write appends at once before checking the progress
+		static const UINT writeNodeCount = 16 * chunkNodeCount;
+
+		OctreeFile();
+		~OctreeFile();
+
+		// Returns false when the file does not exist or is not a valid version 2 file of this machine
+		// The child indices of raw files are checked against the node count once, the result is kept in a .valid file next to it (size and last write time)
+		// The mapped nodes are used without copying them, verifyOctreeFiles of the parameters checks the indices and the nodes checksum on every open
+		bool Open(const std::wstring &filename, const FileReadParameters &fileReadParameters, OctreeBuildProgress *progress = NULL);
+		void Close();
+		bool IsOpen() const;
+		bool IsCompressed() const;
+		bool IsPaged() const;
+
+		// Only valid while the file is open, compressed files have to be decompressed and paged files are read by the page cache instead
+		const OctreeNode* GetNodes() const;
+		UINT64 GetNodeCount() const;
+		const OctreeFileHeader& GetHeader() const;
+
+		// Table of the compressed chunks or the pages, points into the mapping of the open file
+		const OctreeFileChunk* GetChunks() const;
+		UINT64 GetChunkCount() const;
+
+		// Decodes all the chunks of an open compressed file with multiple threads, the checksum is always verified
+		// Returns false when a chunk is corrupt, a canceled progress throws an exception
+		bool Decompress(std::vector<OctreeNode> &outNodes, UINT threadCount = 0, OctreeBuildProgress *progress = NULL);
+
+		// Writes the nodes in parts, the file is written to a temporary file first and replaces the file in Finish
+		// Finish returns false when less or more nodes were appended or when writing failed
+		bool Create(const std::wstring &filename, UINT64 nodeCount, const Vector3 &rootPosition, const float &rootSize, bool compress = false, UINT threadCount = 0);
+		bool Append(const OctreeNode *nodes, size_t count);
+
+		// Paged files are written page by page, the node indices of page i start at i * pageNodeCount
+		// The node count in the header is the size of the index space including the unused indices at the end of the pages
+		bool CreatePaged(const std::wstring &filename, UINT64 pageCount, UINT pageNodeCount, const Vector3 &rootPosition, const float &rootSize);
+		bool AppendPage(const OctreeNode *nodes, size_t count);
+
+		bool Finish();
+
+		// Appends the nodes in parts, a canceled progress throws an exception between the parts and the file is not written
+		static bool Write(const std::wstring &filename, const OctreeNode *nodes, UINT64 nodeCount, const Vector3 &rootPosition, const float &rootSize, bool compress = false, UINT threadCount = 0, OctreeBuildProgress *progress = NULL);
+		static bool ReadVersion1(const std::wstring &filename, std::vector<OctreeNode> &outNodes, Vector3 &outRootPosition, float &outRootSize, const FileReadParameters &fileReadParameters, OctreeBuildProgress *progress = NULL);
+
+		// Continues the checksum of the previous parts, all the parts except the last one have to be a multiple of 8 bytes
+		static UINT64 ComputeChecksum(const void *data, size_t size, UINT64 checksum = checksumSeed);
+
+		// True when the children of all the inner nodes are inside of the nodes array
+		static bool AreChildrenValid(const OctreeNode *nodes, size_t count, UINT64 nodeCount);
+
+	private:
+		static const UINT64 checksumSeed = 14695981039346656037ull;
+		static const char magic[8];
+
+		OctreeFileHeader header;
+
+		// Reading
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+		const byte *view = NULL;
+		UINT64 fileSize = 0;
+
+		// Writing
+		std::wstring filename;
+		std::wstring temporaryFilename;
+		std::ofstream output;
+		UINT64 appendedNodeCount = 0;
+		bool appendedChildrenValid = true;
+
+		// Compressed writing, the appended nodes are collected until there are enough chunks for all the threads
+		ThreadPool *threadPool = NULL;
+		std::vector<OctreeNode> pendingNodes;
+		std::vector<OctreeFileChunk> chunks;
+
+		bool IsHeaderValid() const;
+
+		// The .valid file only matches as long as the file is not replaced or changed
+		bool IsValidated() const;
+		static void SaveValidated(const std::wstring &filename);
+		static bool GetFileSizeAndLastWriteTime(const std::wstring &filename, UINT64 outData[2]);
+		bool CompressPendingNodes(bool last);
+		void DiscardOutput();
+
+		static UINT64 ComputeHeaderChecksum(const OctreeFileHeader &header);
+		static void EncodeChunk(const OctreeNode *nodes, size_t count, std::vector<byte> &outData);
+		static bool DecodeChunk(const byte *data, size_t size, OctreeNode *outNodes, size_t count);
+	};
+}
+#endif
\ No newline at end of file
@@ -5,9 +5,11 @@ PointCloudEngine::OctreeNode::OctreeNode()
     // Default constructor used for parsing from file
 }
 
-PointCloudEngine::OctreeNode::OctreeNode(std::queue<OctreeNodeCreationEntry> &nodeCreationQueue, std::vector<OctreeNode> &nodes, std::vector<UINT>& children, const OctreeNodeCreationEntry &entry)
+PointCloudEngine::OctreeNode::OctreeNode(const std::vector<Vertex> &vertices, const OctreeNodeCreationEntry &entry, int maxDepth, OctreeNodeClusters *outClusters)
 {
-    size_t vertexCount = entry.vertices.size();
+    // The vertices of this node are stored right after each other in the shared vertices array
+    const Vertex *nodeVertices = vertices.data() + entry.vertexStart;
+    size_t vertexCount = entry.vertexCount;
     
     if (vertexCount == 0)
     {
@@ -16,238 +18,38 @@ PointCloudEngine::OctreeNode::OctreeNode(std::queue<OctreeNodeCreationEntry> &no
     }
 
     // The octree is generated by fitting the vertices into a cube at the center position
-    // Then this cube is splitted into 8 smaller child cubes along the center
+    // Then this cube is splitted into 8 smaller child cubes along the center (done by the OctreeBuilder)
     // For each child cube the octree generation is repeated
-    // Assign this child to its parent
-    if (entry.nodesIndex != UINT_MAX && entry.childrenIndex != UINT_MAX)
-    {
-		children[entry.childrenIndex] = entry.nodesIndex;
-    }
-
-    // Apply the k-means clustering algorithm to find clusters for the normals
-    Vector3 means[4];
-    const int k = min(vertexCount, 4);
-    UINT verticesPerMean[4] = { 0, 0, 0, 0 };
-
-    // Set initial means to the first k normals
-    for (int i = 0; i < k; i++)
-    {
-        means[i] = entry.vertices[i].normal;
-        verticesPerMean[i] = 1;
-    }
-
-    // Save the index of the mean that each vertex is assigned to
-    bool meanChanged = true;
-    byte *clusters = new byte[vertexCount];
-    ZeroMemory(clusters, sizeof(byte) * vertexCount);
-
-    while (meanChanged)
-    {
-        // Assign all the vertices to the closest mean to them
-        for (UINT i = 0; i < vertexCount; i++)
-        {
-            float minDistance = Vector3::Distance(entry.vertices[i].normal, means[clusters[i]]);
-
-            for (UINT j = 0; j < k; j++)
-            {
-                float distance = Vector3::Distance(entry.vertices[i].normal, means[j]);
-
-                if (distance < minDistance)
-                {
-                    clusters[i] = j;
-                    minDistance = distance;
-                }
-            }
-        }
-
-        // Calculate the new means from the vertices in each cluster
-        Vector3 newMeans[4];
-
-        for (int i = 0; i < k; i++)
-        {
-            verticesPerMean[i] = 0;
-        }
-
-        for (UINT i = 0; i < vertexCount; i++)
-        {
-            newMeans[clusters[i]] += entry.vertices[i].normal;
-            verticesPerMean[clusters[i]] += 1;
-        }
-
-        meanChanged = false;
-
-        // Update the means
-        for (int i = 0; i < k; i++)
-        {
-            if (verticesPerMean[i] > 0)
-            {
-                newMeans[i] /= verticesPerMean[i];
-
-                if (Vector3::DistanceSquared(means[i], newMeans[i]) > FLT_EPSILON)
-                {
-                    meanChanged = true;
-                }
-
-                means[i] = newMeans[i];
-            }
-        }
-
-    }
-
-	// Normalize the means
-	for (UINT i = 0; i < k; i++)
-	{
-		means[i].Normalize();
-	}
-
-    // Initialize average colors that are calculated per cluster
-	float normalCones[4] = { 0, 0, 0, 0 };
-    double averageReds[4] = { 0, 0, 0, 0 };
-    double averageGreens[4] = { 0, 0, 0, 0 };
-    double averageBlues[4] = { 0, 0, 0, 0 };
-
-    // Calculate color
-    for (UINT i = 0; i < vertexCount; i++)
-    {
-        averageReds[clusters[i]] += entry.vertices[i].color[0];
-        averageGreens[clusters[i]] += entry.vertices[i].color[1];
-        averageBlues[clusters[i]] += entry.vertices[i].color[2];
-
-		// Calculate the angle in [0, pi] between the mean normal and this vertex normal
-		float angle = acos(means[clusters[i]].Dot(entry.vertices[i].normal));
-
-		// Save the maximum angle to any of the vertices in the cluster as normal cone
-		normalCones[clusters[i]] = max(normalCones[clusters[i]], angle);
-    }
 
-	delete[] clusters;
+    // Find clusters for the normals and their average colors
+    OctreeNodeClusters clusters;
+    ComputeClusters(nodeVertices, vertexCount, clusters);
 
     // Assign node properties
 	properties.childrenMask = 0;
+	SetProperties(clusters);
 
-    for (int i = 0; i < 4; i++)
-    {
-        if (verticesPerMean[i] > 0)
-        {
-            averageReds[i] /= verticesPerMean[i];
-            averageGreens[i] /= verticesPerMean[i];
-            averageBlues[i] /= verticesPerMean[i];
-
-            properties.normals[i] = ClusterNormal(means[i], normalCones[i]);
-            properties.colors[i] = Color16(averageReds[i], averageGreens[i], averageBlues[i]);
-        }
-    }
-
-	// Assign weights (one of the 4 can be omitted because the sum is always 100%)
-	for (int i = 0; i < 3; i++)
+	if (outClusters != NULL)
 	{
-		properties.weights[i] = (255.0f * verticesPerMean[i]) / vertexCount;
+		*outClusters = clusters;
 	}
 
-    // Only subdivide further when this is not a leaf node and the max octree depth is not met yet
-    if ((vertexCount > 1) && (entry.depth < settings->maxOctreeDepth))
-    {
-		// Split and create children vertices
-		std::vector<Vertex> childVertices[8];
-
-		// Fit each vertex into its corresponding child cube
-		for (auto it = entry.vertices.begin(); it != entry.vertices.end(); it++)
-		{
-			Vertex v = *it;
-
-			if (v.position.x > entry.position.x)
-			{
-				if (v.position.y > entry.position.y)
-				{
-					if (v.position.z > entry.position.z)
-					{
-						childVertices[0].push_back(v);
-					}
-					else
-					{
-						childVertices[1].push_back(v);
-					}
-				}
-				else
-				{
-					if (v.position.z > entry.position.z)
-					{
-						childVertices[2].push_back(v);
-					}
-					else
-					{
-						childVertices[3].push_back(v);
-					}
-				}
-			}
-			else
-			{
-				if (v.position.y > entry.position.y)
-				{
-					if (v.position.z > entry.position.z)
-					{
-						childVertices[4].push_back(v);
-					}
-					else
-					{
-						childVertices[5].push_back(v);
-					}
-				}
-				else
-				{
-					if (v.position.z > entry.position.z)
-					{
-						childVertices[6].push_back(v);
-					}
-					else
-					{
-						childVertices[7].push_back(v);
-					}
-				}
-			}
-		}
+    // The OctreeBuilder assigns the children and the children start index when this is not a leaf node
+	childrenStartOrLeafPositionFactors = 0;
 
-		// Store the start index of the children in the children array
-		childrenStartOrLeafPositionFactors = children.size();
-
-        for (int i = 0; i < 8; i++)
-        {
-            if (childVertices[i].size() > 0)
-            {
-                // Add a new entry to the queue
-                OctreeNodeCreationEntry childEntry;
-                childEntry.nodesIndex = UINT_MAX;
-				childEntry.childrenIndex = children.size();
-                childEntry.vertices = childVertices[i];
-                childEntry.position = GetChildPosition(entry.position, entry.size, i);
-                childEntry.size = entry.size * 0.5f;
-                childEntry.depth = entry.depth + 1;
-
-				// Add this entry to the mask
-				properties.childrenMask |= 1 << i;
-
-				// Reserve a spot for the children index that will be assigned later
-				children.push_back(UINT_MAX);
-
-				// Add this to the queue
-                nodeCreationQueue.push(childEntry);
-            }
-        }
-    }
-	else
+    if (IsLeafEntry(entry, maxDepth))
 	{
 		// This is a leaf node with childrenMask=0 representing exactly one or more vertices
 		// The bounding cube can be much larger than the vertices that it represents -> the bounding cube position does not represent the vertex positions well
 		// Idea: store factors from the average vertex position in the childrenStartOrLeafPositionFactors to representing a more accurate position
 		// Each 8 bits store the distance factor from the smallest position of the bounding cube in respect to the size of the cube in each axis (x, y, z)
-		childrenStartOrLeafPositionFactors = 0;
 
 		// Compute the average position of the vertices contained in this leaf node
 		Vector3 averagePosition = Vector3::Zero;
 
 		for (UINT i = 0; i < vertexCount; i++)
 		{
-			averagePosition += entry.vertices[i].position;
+			averagePosition += nodeVertices[i].position;
 		}
 
 		averagePosition /= vertexCount;
@@ -266,174 +68,255 @@ PointCloudEngine::OctreeNode::OctreeNode(std::queue<OctreeNodeCreationEntry> &no
 	}
 }
 
-void PointCloudEngine::OctreeNode::GetVertices(const std::vector<OctreeNode>& nodes, std::queue<OctreeNodeTraversalEntry> &nodesQueue, std::vector<OctreeNodeVertex> &octreeVertices, const OctreeNodeTraversalEntry &entry, const OctreeConstantBuffer &octreeConstantBufferData) const
+void PointCloudEngine::OctreeNode::SetProperties(const OctreeNodeClusters &clusters)
 {
-	bool visible = false;
-	bool insideViewFrustum = true;
-	bool traverseChildren = true;
+	UINT vertexCount = 0;
 
-	if (octreeConstantBufferData.useCulling)
+	for (int i = 0; i < 4; i++)
 	{
-		// Backface culling by comparing the maximum angle (normal cone) from the mean to all normals in the cluster against the view direction
-		OctreeNode node = nodes[entry.index];
-		Vector3 localViewDirection = entry.position - octreeConstantBufferData.localCameraPosition;
-		localViewDirection.Normalize();
+		vertexCount += clusters.counts[i];
+	}
 
-		// Calculate the angle between the view direction, camera forward vector and each normal
-		for (int i = 0; i < 4; i++)
+	for (int i = 0; i < 4; i++)
+	{
+		if (clusters.counts[i] > 0)
+		{
+			properties.normals[i] = ClusterNormal(clusters.normals[i], clusters.cones[i]);
+			properties.colors[i] = Color16(clusters.colors[i][0], clusters.colors[i][1], clusters.colors[i][2]);
+		}
+		else
 		{
-			ClusterNormal clusterNormal = node.properties.normals[i];
-			Vector3 normal = clusterNormal.GetVector3();
-			float cone = clusterNormal.GetCone();
+			properties.normals[i] = ClusterNormal();
+			properties.colors[i] = Color16();
+		}
+	}
+
+	// Assign weights (one of the 4 can be omitted because the sum is always 100%)
+	for (int i = 0; i < 3; i++)
+	{
+		properties.weights[i] = (255.0f * clusters.counts[i]) / vertexCount;
+	}
+}
+
+void PointCloudEngine::OctreeNode::GetClusters(UINT vertexCount, OctreeNodeClusters &outClusters) const
+{
+	UINT remainingCount = vertexCount;
+
+	for (int i = 0; i < 4; i++)
+	{
+		ClusterNormal clusterNormal = properties.normals[i];
+		outClusters.normals[i] = clusterNormal.GetVector3();
+		outClusters.cones[i] = clusterNormal.GetCone();
+
+		// 6 bits red, 6 bits green, 4 bits blue
+		USHORT color = properties.colors[i].data;
+		outClusters.colors[i][0] = DecodeTables::GetSixBitChannel((color >> 10) & 0x3f);
+		outClusters.colors[i][1] = DecodeTables::GetSixBitChannel((color >> 4) & 0x3f);
+		outClusters.colors[i][2] = DecodeTables::GetFourBitChannel(color & 0xf);
+
+		// The omitted last weight gets the remaining vertices, empty clusters have the empty normal
+		UINT count = (i < 3) ? min(remainingCount, (UINT)round(vertexCount * (properties.weights[i] / 255.0))) : remainingCount;
+		outClusters.counts[i] = (clusterNormal.thetaPhiCone == 0) ? 0 : count;
+		remainingCount -= outClusters.counts[i];
+	}
+
+	// Rounding can leave vertices without a cluster, the first cluster always exists
+	outClusters.counts[0] += remainingCount;
+}
+
+void PointCloudEngine::OctreeNode::ComputeClusters(const Vertex *vertices, size_t vertexCount, OctreeNodeClusters &outClusters)
+{
+	// Apply the k-means clustering algorithm to find clusters for the normals (vectorized when the processor supports AVX2)
+	const int k = min(vertexCount, 4);
+
+	// Save the index of the mean that each vertex is assigned to, the scratch memory of this thread is reused for every node
+	ScratchArena::Scope scratchScope(ScratchArena::GetThreadArena());
+	byte *clusters = ScratchArena::GetThreadArena().Allocate<byte>(vertexCount);
+	NormalClustering::Cluster(vertices, vertexCount, outClusters.normals, outClusters.counts, clusters);
+
+	// Normalize the means
+	for (UINT i = 0; i < k; i++)
+	{
+		outClusters.normals[i].Normalize();
+	}
 
-			// Also check against the camera forward vector since the node position can yield a heavily different view direction
-			float firstAngle = acos(normal.Dot(-localViewDirection));
-			float secondAngle = acos(normal.Dot(octreeConstantBufferData.localViewPlaneNearNormal));
-			float angle = min(firstAngle, secondAngle);
+	// Initialize average colors that are calculated per cluster
+	for (int i = 0; i < 4; i++)
+	{
+		outClusters.cones[i] = 0;
+		outClusters.colors[i][0] = outClusters.colors[i][1] = outClusters.colors[i][2] = 0;
+	}
 
-			// At the edge of the cone the angle can be up to pi/2 larger for the node to be still visible
-			if (angle < (XM_PI / 2) + cone)
+	// Calculate color
+	for (UINT i = 0; i < vertexCount; i++)
+	{
+		outClusters.colors[clusters[i]][0] += vertices[i].color[0];
+		outClusters.colors[clusters[i]][1] += vertices[i].color[1];
+		outClusters.colors[clusters[i]][2] += vertices[i].color[2];
+
+		// Calculate the angle in [0, pi] between the mean normal and this vertex normal
+		float angle = acos(outClusters.normals[clusters[i]].Dot(vertices[i].normal));
+
+		// Save the maximum angle to any of the vertices in the cluster as normal cone
+		outClusters.cones[clusters[i]] = max(outClusters.cones[clusters[i]], angle);
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (outClusters.counts[i] > 0)
+		{
+			outClusters.colors[i][0] /= outClusters.counts[i];
+			outClusters.colors[i][1] /= outClusters.counts[i];
+			outClusters.colors[i][2] /= outClusters.counts[i];
+		}
+	}
+}
+
+void PointCloudEngine::OctreeNode::MergeClusters(const OctreeNodeClusters *children, int childCount, OctreeNodeClusters &outClusters)
+{
+	// Each non empty cluster of the children is one sample that is weighted by its vertex count
+	const OctreeNodeClusters *sampleChildren[32];
+	int sampleIndices[32];
+	int sampleCount = 0;
+
+	for (int i = 0; i < childCount; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			if (children[i].counts[j] > 0)
 			{
-				visible = true;
-				break;
+				sampleChildren[sampleCount] = &children[i];
+				sampleIndices[sampleCount] = j;
+				sampleCount++;
 			}
 		}
+	}
+
+	// Use the normals of the largest child clusters as initial means
+	// Stable insertion sort of the at most 32 samples, std::stable_sort would allocate a temporary buffer for every node
+	int order[32];
+
+	for (int i = 0; i < sampleCount; i++)
+	{
+		int sample = i;
+		UINT count = sampleChildren[i]->counts[sampleIndices[i]];
+		int j = i;
 
-		if (!visible)
+		while ((j > 0) && (sampleChildren[order[j - 1]]->counts[sampleIndices[order[j - 1]]] < count))
 		{
-			// The node and all of its children face away from the camera, don't draw it or traverse further
-			return;
+			order[j] = order[j - 1];
+			j--;
 		}
 
-		// View frustum culling, check if this node is fully inside the view frustum only when the parent isn't (the children of a node are always inside the view frustum then the node itself is inside it)
-		if (!entry.parentInsideViewFrustum)
-		{
-			// Generate all the 6 planes of the view frustum
-			Plane viewFrustumPlanes[6] =
-			{
-				Plane(octreeConstantBufferData.localViewFrustumNearTopLeft, octreeConstantBufferData.localViewPlaneNearNormal),			// Near Plane
-				Plane(octreeConstantBufferData.localViewFrustumFarBottomRight, octreeConstantBufferData.localViewPlaneFarNormal),		// Far Plane
-				Plane(octreeConstantBufferData.localViewFrustumNearTopLeft, octreeConstantBufferData.localViewPlaneLeftNormal),			// Left Plane
-				Plane(octreeConstantBufferData.localViewFrustumFarBottomRight, octreeConstantBufferData.localViewPlaneRightNormal),		// Right Plane
-				Plane(octreeConstantBufferData.localViewFrustumNearTopLeft, octreeConstantBufferData.localViewPlaneTopNormal),			// Top Plane
-				Plane(octreeConstantBufferData.localViewFrustumFarBottomRight, octreeConstantBufferData.localViewPlaneBottomNormal)		// Bottom Plane
-			};
+		order[j] = sample;
+	}
 
-			float extends = entry.size / 2.0f;
+	const int k = min(sampleCount, 4);
+	Vector3 means[4];
+	byte clusters[32] = { 0 };
 
-			Vector3 boundingCube[8] =
-			{
-				entry.position + Vector3(extends, extends, extends),
-				entry.position + Vector3(-extends, extends, extends),
-				entry.position + Vector3(extends, -extends, extends),
-				entry.position + Vector3(extends, extends, -extends),
-				entry.position + Vector3(-extends, -extends, extends),
-				entry.position + Vector3(extends, -extends, -extends),
-				entry.position + Vector3(-extends, extends, -extends),
-				entry.position + Vector3(-extends, -extends, -extends),
-			};
-
-			int outsideCount = 0;
-			int insideCount = 0;
-
-			// Check if the bounding cube is fully inside, fully outside or overlapping the view frustum
-			for (int i = 0; i < 8; i++)
-			{
-				// Check for each position if it is inside the view frustum
-				bool positionIsInside = true;
+	for (int i = 0; i < k; i++)
+	{
+		means[i] = sampleChildren[order[i]]->normals[sampleIndices[order[i]]];
+	}
 
-				for (int j = 0; j < 6; j++)
-				{
-					// Compute the signed distance to each of the planes
-					if (viewFrustumPlanes[j].DotCoordinate(boundingCube[i]) > 0)
-					{
-						// The position cannot be fully inside the view frustum when it is on the wrong side of one of the 6 planes
-						positionIsInside = false;
-						break;
-					}
-				}
+	// Weighted k-means with the same iteration limit as the clustering of the vertices
+	for (int iteration = 0; iteration < NormalClustering::maxIterations; iteration++)
+	{
+		Vector3 sums[4];
+		UINT counts[4] = { 0, 0, 0, 0 };
 
-				if (positionIsInside)
-				{
-					insideCount++;
-				}
-				else
+		for (int i = 0; i < sampleCount; i++)
+		{
+			const Vector3 &normal = sampleChildren[i]->normals[sampleIndices[i]];
+			UINT count = sampleChildren[i]->counts[sampleIndices[i]];
+			float minDistance = Vector3::DistanceSquared(normal, means[clusters[i]]);
+
+			for (int j = 0; j < k; j++)
+			{
+				float distance = Vector3::DistanceSquared(normal, means[j]);
+
+				if (distance < minDistance)
 				{
-					outsideCount++;
+					clusters[i] = j;
+					minDistance = distance;
 				}
 			}
 
-			if (outsideCount == 8)
+			sums[clusters[i]] += normal * (float)count;
+			counts[clusters[i]] += count;
+		}
+
+		bool meanChanged = false;
+
+		for (int j = 0; j < k; j++)
+		{
+			if (counts[j] > 0)
 			{
-				// Handle the case that the bounding cube positions are not inside the view frustum but it is still overlapping (e.g. edge only intersection, cube contains view frustum)
-				// Do ray sphere intersection for all the 12 view frustum rays against the sphere representation of the bounding cube (radius is half the diagonal)
-				Vector3 rays[12][2] =
-				{
-					{ octreeConstantBufferData.localViewFrustumNearTopRight, octreeConstantBufferData.localViewFrustumNearTopLeft },
-					{ octreeConstantBufferData.localViewFrustumNearBottomRight, octreeConstantBufferData.localViewFrustumNearBottomLeft },
-					{ octreeConstantBufferData.localViewFrustumNearBottomLeft, octreeConstantBufferData.localViewFrustumNearTopLeft },
-					{ octreeConstantBufferData.localViewFrustumNearBottomRight, octreeConstantBufferData.localViewFrustumNearTopRight },
-					{ octreeConstantBufferData.localViewFrustumFarTopRight, octreeConstantBufferData.localViewFrustumFarTopLeft },
-					{ octreeConstantBufferData.localViewFrustumFarBottomRight, octreeConstantBufferData.localViewFrustumFarBottomLeft },
-					{ octreeConstantBufferData.localViewFrustumFarBottomLeft, octreeConstantBufferData.localViewFrustumFarTopLeft },
-					{ octreeConstantBufferData.localViewFrustumFarBottomRight, octreeConstantBufferData.localViewFrustumFarTopRight },
-					{ octreeConstantBufferData.localViewFrustumNearTopLeft, octreeConstantBufferData.localViewFrustumFarTopLeft },
-					{ octreeConstantBufferData.localViewFrustumNearTopRight, octreeConstantBufferData.localViewFrustumFarTopRight },
-					{ octreeConstantBufferData.localViewFrustumNearBottomLeft, octreeConstantBufferData.localViewFrustumFarBottomLeft },
-					{ octreeConstantBufferData.localViewFrustumNearBottomRight, octreeConstantBufferData.localViewFrustumFarBottomRight }
-				};
-
-				// Create a sphere that encloses the bounding cube to test against
-				bool intersects = false;
-				Vector3 c = entry.position;
-				float r = Vector3(extends, extends, extends).Length();
-
-				for (int i = 0; i < 12; i++)
-				{
-					Vector3 o = rays[i][0];
-					Vector3 v = rays[i][1] - rays[i][0];
-
-					// Store the length of the frustum line and normalize it
-					float l = v.Length();
-					v /= l;
-
-					// Calculate the factor under the square root
-					float vDotOMinusC = v.Dot(o - c);
-					float f = vDotOMinusC * vDotOMinusC - ((o - c).LengthSquared() - r * r);
-
-					if (f > 0)
-					{
-						// Intersecting the sphere at two points, calculate whether this point is on the line of the view frustum
-						float s = sqrt(f);
-						float d1 = -vDotOMinusC + s;
-						float d2 = -vDotOMinusC - s;
-
-						if ((d1 >= 0 && d1 <= l) || (d2 >= 0 && d2 <= l))
-						{
-							// Interecting, check children again
-							insideViewFrustum = false;
-							intersects = true;
-							break;
-						}
-					}
-				}
+				Vector3 newMean = sums[j] / (float)counts[j];
 
-				if (!intersects)
+				if (Vector3::DistanceSquared(means[j], newMean) > FLT_EPSILON)
 				{
-					// The whole cube is outside, don't add it or any of its children
-					return;
+					meanChanged = true;
 				}
+
+				means[j] = newMean;
 			}
-			else if (insideCount != 0 && outsideCount != 0)
-			{
-				// Some positions are outside and some are inside the view frustum, check the children again
-				insideViewFrustum = false;
-			}
+		}
 
-			// Otherwise the cube is fully inside the view frustum as assumed
+		if (!meanChanged)
+		{
+			break;
 		}
 	}
 
+	// Sum up the counts and colors of the samples in each cluster
+	for (int i = 0; i < 4; i++)
+	{
+		means[i].Normalize();
+		outClusters.normals[i] = means[i];
+		outClusters.cones[i] = 0;
+		outClusters.colors[i][0] = outClusters.colors[i][1] = outClusters.colors[i][2] = 0;
+		outClusters.counts[i] = 0;
+	}
+
+	for (int i = 0; i < sampleCount; i++)
+	{
+		const OctreeNodeClusters *child = sampleChildren[i];
+		int j = sampleIndices[i];
+		int cluster = clusters[i];
+
+		outClusters.counts[cluster] += child->counts[j];
+		outClusters.colors[cluster][0] += child->colors[j][0] * child->counts[j];
+		outClusters.colors[cluster][1] += child->colors[j][1] * child->counts[j];
+		outClusters.colors[cluster][2] += child->colors[j][2] * child->counts[j];
+
+		// Every normal of the child cluster is within its cone around the child normal, the merged cone has to contain that whole cone
+		float angle = acos(max(-1.0f, min(1.0f, outClusters.normals[cluster].Dot(child->normals[j]))));
+		outClusters.cones[cluster] = max(outClusters.cones[cluster], min(XM_PI, angle + child->cones[j]));
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (outClusters.counts[i] > 0)
+		{
+			outClusters.colors[i][0] /= outClusters.counts[i];
+			outClusters.colors[i][1] /= outClusters.counts[i];
+			outClusters.colors[i][2] /= outClusters.counts[i];
+		}
+	}
+}
+
+bool PointCloudEngine::OctreeNode::Traverse(std::vector<OctreeNodeTraversalEntry> &nodesQueue, const OctreeNodeTraversalEntry &entry, int insidePlanes, const OctreeConstantBuffer &octreeConstantBufferData) const
+{
+	bool traverseChildren = true;
+
+	if (octreeConstantBufferData.useCulling && !IsFacingCamera(entry.position, octreeConstantBufferData))
+	{
+		// The node and all of its children face away from the camera, don't draw it or traverse further
+		return false;
+	}
+
 	// Check if only to return the vertices at the given level
 	if (octreeConstantBufferData.level >= 0)
 	{
@@ -441,7 +324,6 @@ void PointCloudEngine::OctreeNode::GetVertices(const std::vector<OctreeNode>& no
 		{
 			// Draw this vertex and don't traverse further
 			traverseChildren = false;
-			octreeVertices.push_back(GetVertexFromTraversalEntry(entry));
 		}
 	}
 	else
@@ -456,7 +338,6 @@ void PointCloudEngine::OctreeNode::GetVertices(const std::vector<OctreeNode>& no
 		{
 			// Draw this vertex, don't traverse further
 			traverseChildren = false;
-			octreeVertices.push_back(GetVertexFromTraversalEntry(entry));
 		}
 	}
 
@@ -474,15 +355,17 @@ void PointCloudEngine::OctreeNode::GetVertices(const std::vector<OctreeNode>& no
 				childEntry.index = childrenStartOrLeafPositionFactors + count;
 				childEntry.position = GetChildPosition(entry.position, entry.size, i);
 				childEntry.size = entry.size * 0.5f;
-				childEntry.parentInsideViewFrustum = insideViewFrustum;
+				childEntry.parentInsidePlanes = insidePlanes;
 				childEntry.depth = entry.depth + 1;
 
-				nodesQueue.push(childEntry);
+				nodesQueue.push_back(childEntry);
 
 				count++;
 			}
 		}
 	}
+
+	return !traverseChildren;
 }
 
 bool PointCloudEngine::OctreeNode::IsLeafNode() const
@@ -490,7 +373,25 @@ bool PointCloudEngine::OctreeNode::IsLeafNode() const
 	return (properties.childrenMask == 0);
 }
 
-Vector3 PointCloudEngine::OctreeNode::GetChildPosition(const Vector3& parentPosition, const float& parentSize, int childIndex) const
+bool PointCloudEngine::OctreeNode::IsLeafEntry(const OctreeNodeCreationEntry &entry, int maxDepth)
+{
+	// Only subdivide further when there is more than one vertex and the max octree depth is not met yet
+	return (entry.vertexCount <= 1) || (entry.depth >= maxDepth);
+}
+
+int PointCloudEngine::OctreeNode::GetChildIndex(const Vector3 &parentPosition, const Vector3 &position)
+{
+	// Same bit layout as in GetChildPosition, a set bit means that the position is on the negative side of that axis
+	int childIndex = 0;
+
+	childIndex |= (position.x > parentPosition.x) ? 0 : 0x4;
+	childIndex |= (position.y > parentPosition.y) ? 0 : 0x2;
+	childIndex |= (position.z > parentPosition.z) ? 0 : 0x1;
+
+	return childIndex;
+}
+
+Vector3 PointCloudEngine::OctreeNode::GetChildPosition(const Vector3& parentPosition, const float& parentSize, int childIndex)
 {
 	/*
 	Vector3 childPositions[8] =
@@ -516,6 +417,59 @@ Vector3 PointCloudEngine::OctreeNode::GetChildPosition(const Vector3& parentPosi
 	);
 }
 
+bool PointCloudEngine::OctreeNode::IsFacingCamera(const Vector3 &position, const OctreeConstantBuffer &octreeConstantBufferData, float *outSlack) const
+{
+	bool visible = false;
+	float visibleSlack = 0;
+	float hiddenSlack = FLT_MAX;
+
+	// Backface culling by comparing the maximum angle (normal cone) from the mean to all normals in the cluster against the view direction
+	Vector3 viewDirection = octreeConstantBufferData.localCameraPosition - position;
+	viewDirection.Normalize();
+
+	for (int i = 0; i < 4; i++)
+	{
+		ClusterNormal clusterNormal = properties.normals[i];
+		Vector3 normal = clusterNormal.GetVector3();
+		float cone = clusterNormal.GetCone();
+
+		// Cones wider than pi/2 are visible from every direction
+		if (cone > XM_PI / 2)
+		{
+			visible = true;
+			visibleSlack = FLT_MAX;
+			break;
+		}
+
+		// Also check against the camera forward vector since the node position can yield a heavily different view direction
+		// Since acos is decreasing, the smaller of both angles is below pi/2 + cone exactly when the larger cosine is above cos(pi/2 + cone) = -sin(cone)
+		float cosine = max(normal.Dot(viewDirection), normal.Dot(octreeConstantBufferData.localViewPlaneNearNormal));
+		float threshold = -clusterNormal.GetConeSine();
+
+		if (cosine > threshold)
+		{
+			visible = true;
+			visibleSlack = max(visibleSlack, cosine - threshold);
+
+			if (outSlack == NULL)
+			{
+				break;
+			}
+		}
+		else
+		{
+			hiddenSlack = min(hiddenSlack, threshold - cosine);
+		}
+	}
+
+	if (outSlack != NULL)
+	{
+		*outSlack = visible ? visibleSlack : hiddenSlack;
+	}
+
+	return visible;
+}
+
 OctreeNodeVertex PointCloudEngine::OctreeNode::GetVertexFromTraversalEntry(const OctreeNodeTraversalEntry& entry) const
 {
 	OctreeNodeVertex vertex;
@@ -10,11 +10,35 @@ namespace PointCloudEngine
     {
     public:
         OctreeNode();
-        OctreeNode (std::queue<OctreeNodeCreationEntry> &nodeCreationQueue, std::vector<OctreeNode> &nodes, std::vector<UINT> &children, const OctreeNodeCreationEntry &entry);
+        OctreeNode (const std::vector<Vertex> &vertices, const OctreeNodeCreationEntry &entry, int maxDepth, OctreeNodeClusters *outClusters = NULL);
 
-		void GetVertices(const std::vector<OctreeNode> &nodes, std::queue<OctreeNodeTraversalEntry>& nodesQueue, std::vector<OctreeNodeVertex>& octreeVertices, const OctreeNodeTraversalEntry& entry, const OctreeConstantBuffer& octreeConstantBufferData) const;
+		// Quantizes the clusters into the weights, normals and colors, the childrenMask and the children start index are not changed
+		void SetProperties(const OctreeNodeClusters &clusters);
+
+		// Approximate inverse of SetProperties, the cluster counts are computed from the weights and the vertex count of the node
+		void GetClusters(UINT vertexCount, OctreeNodeClusters &outClusters) const;
+
+		// Returns true when the node is drawn, otherwise its children are added to the queue unless the node faces away from the camera
+		// The view frustum test is done before for many entries at once by the FrustumCuller, the inside planes of the entry are passed on to the children
+		bool Traverse(std::vector<OctreeNodeTraversalEntry>& nodesQueue, const OctreeNodeTraversalEntry& entry, int insidePlanes, const OctreeConstantBuffer& octreeConstantBufferData) const;
         bool IsLeafNode() const;
 
+		// Backface test of the normal cones against the direction to the camera and the camera forward vector
+		// The optional slack is how much the cosines can change until the result can change
+		bool IsFacingCamera(const Vector3 &position, const OctreeConstantBuffer &octreeConstantBufferData, float *outSlack = NULL) const;
+		OctreeNodeVertex GetVertexFromTraversalEntry(const OctreeNodeTraversalEntry& entry) const;
+
+		static bool IsLeafEntry(const OctreeNodeCreationEntry &entry, int maxDepth);
+		static int GetChildIndex(const Vector3 &parentPosition, const Vector3 &position);
+		static Vector3 GetChildPosition(const Vector3 &parentPosition, const float &parentSize, int childIndex);
+
+		// Exact k-means clustering of the vertex normals
+		static void ComputeClusters(const Vertex *vertices, size_t vertexCount, OctreeNodeClusters &outClusters);
+
+		// Approximates the clusters of a parent with a weighted k-means of the cluster normals of its children
+		// The cones are merged conservatively (angle between the normals plus the child cone), colors and counts are weighted sums
+		static void MergeClusters(const OctreeNodeClusters *children, int childCount, OctreeNodeClusters &outClusters);
+
 		// Stores either (1) the start index in the nodes array where the actual child indices are stored or (2) the leaf position factors
 		// (1) The childrenMask from the properties determines which children corresponds to which index
 		// (1) E.g. a childrenMask of 01011011 means that the array only stores the 2nd, 4th, 5th, 7th and 8th indices from the start right after each other
@@ -22,12 +46,13 @@ namespace PointCloudEngine
 		// (2) Each 8 bits store the distance factor from the smallest position of the bounding cube in respect to the size of the cube in each axis (x, y, z)
 		UINT childrenStartOrLeafPositionFactors = 0;
 
+		// The children start indices are 32 bit in every octree (built in memory or out of core, mapped, paged and on the gpu)
+		// Every index that is traversed was read from this field, wider indices in the traversal, the pages or the stitch alone would not reach more nodes
+		// There is no variant with wider indices, octrees with more nodes are not supported and their builds fail with an exception
+		static const UINT64 maxNodeCount = UINT_MAX;
+
 		// Stores the childrenMask, weights, normals and colors
 		OctreeNodeProperties properties;
-
-	private:
-		Vector3 GetChildPosition(const Vector3 &parentPosition, const float &parentSize, int childIndex) const;
-		OctreeNodeVertex GetVertexFromTraversalEntry(const OctreeNodeTraversalEntry& entry) const;
     };
 }
 
@@ -0,0 +1,305 @@
+#include "OctreePageCache.h"
+
+PointCloudEngine::OctreePageCache::OctreePageCache(UINT memoryBudget, const FileReadParameters &fileReadParameters, UINT loadThreadCount)
+{
+	ZeroMemory(&header, sizeof(OctreeFileHeader));
+
+	// At least the root page and one more page have to fit into the budget
+	size_t slotCount = ((size_t)memoryBudget * 1024 * 1024) / (pageNodeCount * sizeof(OctreeNode));
+	slots = std::vector<Slot>(max(slotCount, (size_t)2));
+
+	this->fileReadParameters = fileReadParameters;
+	backend = ParallelFileReader::CreateBackend(fileReadParameters.backendType, loadThreadCount);
+}
+
+PointCloudEngine::OctreePageCache::~OctreePageCache()
+{
+	// Wait for the reads that are still in flight before the slots are released
+	SafeDelete(backend);
+}
+
+bool PointCloudEngine::OctreePageCache::Open(const std::wstring &filename)
+{
+	// The header and page table are validated by the octree file, the pages are read without the mapping afterwards
+	OctreeFile octreeFile;
+
+	if (!octreeFile.Open(filename, fileReadParameters) || !octreeFile.IsPaged() || (octreeFile.GetHeader().chunkNodeCount != pageNodeCount))
+	{
+		return false;
+	}
+
+	header = octreeFile.GetHeader();
+	pageTable.assign(octreeFile.GetChunks(), octreeFile.GetChunks() + octreeFile.GetChunkCount());
+	octreeFile.Close();
+
+	nodeCount = 0;
+
+	for (auto it = pageTable.begin(); it != pageTable.end(); it++)
+	{
+		nodeCount += it->size / sizeof(OctreeNode);
+	}
+
+	pageSlots.assign(pageTable.size(), (int)noSlot);
+	pageLastUsedFrames.assign(pageTable.size(), 0);
+
+	if (pageTable.empty() || !backend->Open(filename, false))
+	{
+		return false;
+	}
+
+	// The root page is read directly and kept in the first slot
+	usedSlotCount = 1;
+	pageSlots[0] = 0;
+	slots[0].page = 0;
+	QueuePageRead(0);
+	backend->Submit();
+	backend->Wait();
+
+	return slots[0].state == PageState::Resident;
+}
+
+const PointCloudEngine::OctreeFileHeader& PointCloudEngine::OctreePageCache::GetHeader() const
+{
+	return header;
+}
+
+void PointCloudEngine::OctreePageCache::BeginFrame()
+{
+	frame++;
+}
+
+bool PointCloudEngine::OctreePageCache::RequestPage(UINT nodeIndex)
+{
+	UINT page = nodeIndex / pageNodeCount;
+
+	if ((page >= pageTable.size()) || (pageSlots[page] == failedSlot))
+	{
+		return false;
+	}
+
+	pageLastUsedFrames[page] = frame;
+	int slot = pageSlots[page];
+
+	if (slot != noSlot)
+	{
+		PageState state = slots[slot].state;
+
+		if (state == PageState::Failed)
+		{
+			// Keep the coarser nodes instead of trying to read the page in every frame
+			Benchmark::Log(L"Could not read page " + std::to_wstring(page) + L" of the paged octree");
+			pageSlots[page] = failedSlot;
+			freeSlots.push_back(slot);
+		}
+
+		return state == PageState::Resident;
+	}
+
+	slot = AcquireSlot();
+
+	if (slot == noSlot)
+	{
+		// All the pages in memory are needed for this frame, the parent nodes are drawn instead
+		return false;
+	}
+
+	pageSlots[page] = slot;
+	slots[slot].page = page;
+	QueuePageRead(slot);
+
+	return false;
+}
+
+void PointCloudEngine::OctreePageCache::SubmitRequests()
+{
+	backend->Submit();
+}
+
+const PointCloudEngine::OctreeNode* PointCloudEngine::OctreePageCache::GetNode(UINT nodeIndex) const
+{
+	return slots[pageSlots[nodeIndex / pageNodeCount]].nodes.data() + (nodeIndex % pageNodeCount);
+}
+
+UINT64 PointCloudEngine::OctreePageCache::GetNodeCount() const
+{
+	return nodeCount;
+}
+
+UINT64 PointCloudEngine::OctreePageCache::GetPageCount() const
+{
+	return pageTable.size();
+}
+
+bool PointCloudEngine::OctreePageCache::Write(const std::wstring &filename, const OctreeNode *nodes, UINT64 nodeCount, const Vector3 &rootPosition, const float &rootSize, OctreeBuildProgress *progress)
+{
+	// A group stores the children of one node, the children are placed into a page together
+	struct Group
+	{
+		UINT start;
+		UINT count;
+	};
+
+	// Groups that did not fit into the page of their parent start new pages, a page is filled breadth first from its groups
+	// When the subtrees of a page are complete the next waiting groups are packed into the same page
+	std::vector<Group> waitingGroups = { { 0, 1 } };
+	std::vector<Group> pageGroups;
+	std::vector<UINT> newIndices(nodeCount);
+	std::vector<UINT> pageOrder;
+	std::vector<UINT> pageSizes;
+	pageOrder.reserve(nodeCount);
+
+	for (size_t waitingFront = 0; waitingFront < waitingGroups.size();)
+	{
+		UINT64 pageStart = (UINT64)pageSizes.size() * pageNodeCount;
+		UINT pageSize = 0;
+		size_t pageFront = 0;
+		pageGroups.clear();
+
+		// The index space includes the unused indices at the end of the pages
+		if (pageStart + pageNodeCount > OctreeNode::maxNodeCount)
+		{
+			Benchmark::Log(L"The paged octree would have more than 4G node indices, these are not supported");
+			return false;
+		}
+
+		while (true)
+		{
+			Group group;
+
+			if (pageFront < pageGroups.size())
+			{
+				group = pageGroups[pageFront++];
+			}
+			else if ((waitingFront < waitingGroups.size()) && (waitingGroups[waitingFront].count <= pageNodeCount - pageSize))
+			{
+				group = waitingGroups[waitingFront++];
+			}
+			else
+			{
+				break;
+			}
+
+			if (group.count > pageNodeCount - pageSize)
+			{
+				waitingGroups.push_back(group);
+				continue;
+			}
+
+			for (UINT i = group.start; i < group.start + group.count; i++)
+			{
+				newIndices[i] = (UINT)pageStart + pageSize++;
+				pageOrder.push_back(i);
+
+				if (!nodes[i].IsLeafNode())
+				{
+					pageGroups.push_back({ nodes[i].childrenStartOrLeafPositionFactors, (UINT)__popcnt(nodes[i].properties.childrenMask) });
+				}
+			}
+		}
+
+		pageSizes.push_back(pageSize);
+	}
+
+	// Copy the nodes in the page order and point the inner nodes to the new indices of their children
+	OctreeFile octreeFile;
+	std::vector<OctreeNode> page(pageNodeCount);
+	size_t orderIndex = 0;
+
+	if (!octreeFile.CreatePaged(filename, pageSizes.size(), pageNodeCount, rootPosition, rootSize))
+	{
+		return false;
+	}
+
+	for (auto it = pageSizes.begin(); it != pageSizes.end(); it++)
+	{
+		if (progress != NULL)
+		{
+			progress->ThrowIfCanceled();
+		}
+
+		for (UINT i = 0; i < *it; i++)
+		{
+			page[i] = nodes[pageOrder[orderIndex++]];
+
+			if (!page[i].IsLeafNode())
+			{
+				page[i].childrenStartOrLeafPositionFactors = newIndices[page[i].childrenStartOrLeafPositionFactors];
+			}
+		}
+
+		if (!octreeFile.AppendPage(page.data(), *it))
+		{
+			break;
+		}
+	}
+
+	return octreeFile.Finish();
+}
+
+int PointCloudEngine::OctreePageCache::AcquireSlot()
+{
+	if (!freeSlots.empty())
+	{
+		int slot = freeSlots.back();
+		freeSlots.pop_back();
+
+		return slot;
+	}
+
+	if (usedSlotCount < slots.size())
+	{
+		return (int)usedSlotCount++;
+	}
+
+	// Evict the least recently used resident page, the root page and the pages of this frame are kept
+	int leastRecentlyUsedSlot = noSlot;
+	UINT64 leastRecentlyUsedFrame = frame;
+
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		UINT page = slots[i].page;
+
+		if ((page != 0) && (pageSlots[page] == (int)i) && (slots[i].state == PageState::Resident) && (pageLastUsedFrames[page] < leastRecentlyUsedFrame))
+		{
+			leastRecentlyUsedSlot = (int)i;
+			leastRecentlyUsedFrame = pageLastUsedFrames[page];
+		}
+	}
+
+	if (leastRecentlyUsedSlot != noSlot)
+	{
+		pageSlots[slots[leastRecentlyUsedSlot].page] = noSlot;
+	}
+
+	return leastRecentlyUsedSlot;
+}
+
+void PointCloudEngine::OctreePageCache::QueuePageRead(int slot)
+{
+	Slot &pageSlot = slots[slot];
+	const OctreeFileChunk &page = pageTable[pageSlot.page];
+
+	if ((page.size > pageNodeCount * sizeof(OctreeNode)) || (page.size % sizeof(OctreeNode) != 0))
+	{
+		pageSlot.state = PageState::Failed;
+		return;
+	}
+
+	if (pageSlot.nodes.empty())
+	{
+		pageSlot.nodes.resize(pageNodeCount);
+	}
+
+	pageSlot.state = PageState::Loading;
+	Slot *readSlot = &pageSlot;
+	UINT64 size = page.size;
+
+	UINT64 indexCount = pageTable.size() * pageNodeCount;
+
+	backend->QueueRead(page.offset, (UINT)size, pageSlot.nodes.data(), [=](DWORD readBytes)
+	{
+		// Pages of a corrupt file with child indices outside of the index space are never traversed
+		bool valid = (readBytes == size) && OctreeFile::AreChildrenValid(readSlot->nodes.data(), (size_t)(size / sizeof(OctreeNode)), indexCount);
+		readSlot->state = valid ? PageState::Resident : PageState::Failed;
+	});
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef OCTREEPAGECACHE_H
+#define OCTREEPAGECACHE_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Keeps the pages of a paged .octree file in memory that were used recently, the other pages are read in the background when they are requested
+	// Each page stores a part of a subtree, all the children of a node are always in the same page
+	// The root page is never evicted, the other pages are evicted in least recently used order when the memory budget is reached
+	// Only the thread that traverses the octree calls the functions, the reads of the requested pages are submitted together once per frame
+	class OctreePageCache
+	{
+	public:
+		// Nodes per page (384 KB), the index of a node is its page times the page node count plus its position in the page
+		static const UINT pageNodeCount = 1 << 14;
+
+		// The memory budget is given in megabytes and limits the number of resident and loading pages
+		OctreePageCache(UINT memoryBudget, const FileReadParameters &fileReadParameters, UINT loadThreadCount = 2);
+		~OctreePageCache();
+
+		// Reads the page table and the root page, returns false when the file is not a valid paged .octree file
+		bool Open(const std::wstring &filename);
+		const OctreeFileHeader& GetHeader() const;
+
+		// Starts a new frame, the pages that are requested in this frame are not evicted until the next frame
+		void BeginFrame();
+
+		// Returns true when the page of the node is resident, otherwise the page is queued to be read in the background when there is enough budget
+		bool RequestPage(UINT nodeIndex);
+
+		// Issues the reads of all the pages that were requested since the last submit
+		void SubmitRequests();
+
+		// The page of the node has to be resident and requested in this frame, it is not evicted before the next frame
+		const OctreeNode* GetNode(UINT nodeIndex) const;
+
+		UINT64 GetNodeCount() const;
+		UINT64 GetPageCount() const;
+
+		// Groups the breadth first nodes into pages and writes them, the children start indices are replaced with the indices in the pages
+		// Returns false when the index space of the pages exceeds the 32 bit node indices or when writing failed
+		static bool Write(const std::wstring &filename, const OctreeNode *nodes, UINT64 nodeCount, const Vector3 &rootPosition, const float &rootSize, OctreeBuildProgress *progress = NULL);
+
+	private:
+		enum class PageState
+		{
+			Loading,
+			Resident,
+			Failed
+		};
+
+		// Memory for one page, the nodes are allocated when the slot is used the first time
+		struct Slot
+		{
+			std::vector<OctreeNode> nodes;
+			UINT page = 0;
+			std::atomic<PageState> state = { PageState::Loading };
+		};
+
+		// Pages that are not resident have the slot index -1, pages that could not be read have the slot index -2 and are never requested again
+		static const int noSlot = -1;
+		static const int failedSlot = -2;
+
+		FileReadParameters fileReadParameters;
+		OctreeFileHeader header;
+		UINT64 nodeCount = 0;
+		UINT64 frame = 0;
+
+		std::vector<OctreeFileChunk> pageTable;
+		std::vector<int> pageSlots;
+		std::vector<UINT64> pageLastUsedFrames;
+
+		std::vector<Slot> slots;
+		std::vector<int> freeSlots;
+		size_t usedSlotCount = 0;
+
+		IFileReadBackend *backend = NULL;
+
+		// Returns a free slot or the slot of the least recently used page that was not requested in this frame, -1 when all the slots are in use
+		int AcquireSlot();
+		void QueuePageRead(int slot);
+	};
+}
+#endif
\ No newline at end of file
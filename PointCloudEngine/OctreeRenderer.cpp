@@ -1,9 +1,9 @@
 #include "OctreeRenderer.h"
 
-OctreeRenderer::OctreeRenderer(const std::wstring &pointcloudFile)
+OctreeRenderer::OctreeRenderer(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress)
 {
-    // Create the octree, throws exception on fail
-    octree = new Octree(pointcloudFile);
+    // Create the octree, throws exception on fail (also when the progress is canceled)
+    octree = new Octree(pointcloudFile, buildParameters, progress);
 
     // Initialize constant buffer data
 	octreeConstantBufferData.fovAngleY = settings->fovAngleY;
@@ -21,32 +21,7 @@ void OctreeRenderer::Initialize()
     hr = d3d11Device->CreateBuffer(&octreeConstantBufferDesc, NULL, &octreeConstantBuffer);
 	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateBuffer) + L" failed for the " + NAMEOF(octreeRendererConstantBuffer));
 
-    // Create the buffer for the compute shader that stores all the octree nodes
-    // Maximum size is ~4.2 GB due to UINT_MAX
-    D3D11_BUFFER_DESC nodesBufferDesc;
-    ZeroMemory(&nodesBufferDesc, sizeof(nodesBufferDesc));
-    nodesBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    nodesBufferDesc.ByteWidth = octree->nodes.size() * sizeof(OctreeNode);
-    nodesBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    nodesBufferDesc.StructureByteStride = sizeof(OctreeNode);
-    nodesBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-
-    D3D11_SUBRESOURCE_DATA nodesBufferData;
-    ZeroMemory(&nodesBufferData, sizeof(nodesBufferData));
-	nodesBufferData.pSysMem = octree->nodes.data();
-
-    hr = d3d11Device->CreateBuffer(&nodesBufferDesc, &nodesBufferData, &nodesBuffer);
-	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateBuffer) + L" failed for the " + NAMEOF(nodesBuffer));
-
-    D3D11_SHADER_RESOURCE_VIEW_DESC nodesBufferSRVDesc;
-    ZeroMemory(&nodesBufferSRVDesc, sizeof(nodesBufferSRVDesc));
-    nodesBufferSRVDesc.Format = DXGI_FORMAT_UNKNOWN;
-    nodesBufferSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-    nodesBufferSRVDesc.Buffer.ElementWidth = sizeof(OctreeNode);
-    nodesBufferSRVDesc.Buffer.NumElements = octree->nodes.size();
-
-    hr = d3d11Device->CreateShaderResourceView(nodesBuffer, &nodesBufferSRVDesc, &nodesBufferSRV);
-	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateShaderResourceView) + L" failed for the " + NAMEOF(nodesBufferSRV));
+    CreateNodesBuffer();
 
     // Create general buffer description for append/consume buffer
     D3D11_BUFFER_DESC appendConsumeBufferDesc;
@@ -199,9 +174,11 @@ void OctreeRenderer::Draw()
     d3d11DevCon->GSSetConstantBuffers(0, 1, &octreeConstantBuffer);
 	d3d11DevCon->PSSetConstantBuffers(0, 1, &octreeConstantBuffer);
 
-    // Get the vertex buffer and use the specified implementation
-    if (settings->useGPUTraversal)
+    // Get the vertex buffer and use the specified implementation, paged and succinct octrees have no nodes array for the gpu
+    if (settings->useGPUTraversal && octree->HasNodesArray())
     {
+        // The cpu traversal threads would only idle while the octree is traversed on the gpu
+        octree->ReleaseTraversalThreads();
         DrawOctreeCompute();
     }
     else
@@ -225,6 +202,9 @@ void OctreeRenderer::Release()
 	SAFE_RELEASE(vertexAppendBufferSRV);
     SAFE_RELEASE(vertexAppendBufferUAV);
     SAFE_RELEASE(octreeConstantBuffer);
+    SAFE_RELEASE(vertexBuffer);
+    SAFE_RELEASE(entriesBuffer);
+    SAFE_RELEASE(entriesBufferSRV);
 }
 
 void PointCloudEngine::OctreeRenderer::GetBoundingCubePositionAndSize(Vector3 &outPosition, float &outSize)
@@ -233,6 +213,30 @@ void PointCloudEngine::OctreeRenderer::GetBoundingCubePositionAndSize(Vector3 &o
 	outSize = octree->rootSize;
 }
 
+bool PointCloudEngine::OctreeRenderer::InsertVertices(const std::vector<Vertex> &vertices)
+{
+	if (!octree->InsertVertices(vertices))
+	{
+		return false;
+	}
+
+	CreateNodesBuffer();
+
+	return true;
+}
+
+bool PointCloudEngine::OctreeRenderer::DeleteVertices(const Vector3 &boxMin, const Vector3 &boxMax)
+{
+	if (!octree->DeleteVertices(boxMin, boxMax))
+	{
+		return false;
+	}
+
+	CreateNodesBuffer();
+
+	return true;
+}
+
 void PointCloudEngine::OctreeRenderer::RemoveComponentFromSceneObject()
 {
 	sceneObject->RemoveComponent(this);
@@ -240,31 +244,29 @@ void PointCloudEngine::OctreeRenderer::RemoveComponentFromSceneObject()
 
 void PointCloudEngine::OctreeRenderer::DrawOctree()
 {
-	// Create new buffer from the current octree traversal on the cpu
-    std::vector<OctreeNodeVertex> octreeVertices = octree->GetVertices(octreeConstantBufferData);
+	// Only upload the entries of the cpu traversal and read the node properties from the nodes buffer like the gpu traversal
+	if (settings->useCPUTraversalEntries && (nodesBufferSRV != NULL))
+	{
+		octree->GetEntries(octreeConstantBufferData, octreeEntries);
 
-    vertexBufferCount = octreeVertices.size();
+		vertexBufferCount = UpdateDynamicBuffer(entriesBuffer, &entriesBufferSRV, entriesBufferCapacity, octreeEntries.data(), octreeEntries.size(), sizeof(OctreeNodeTraversalEntry));
 
-    if (vertexBufferCount > 0)
-    {
-        ID3D11Buffer* vertexBuffer = NULL;
+		if (vertexBufferCount > 0)
+		{
+			DrawEntries(entriesBufferSRV);
+		}
 
-        // Create a vertex buffer description
-        D3D11_BUFFER_DESC vertexBufferDesc;
-        ZeroMemory(&vertexBufferDesc, sizeof(vertexBufferDesc));
-        vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-        vertexBufferDesc.ByteWidth = sizeof(OctreeNodeVertex) * vertexBufferCount;
-        vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-        vertexBufferDesc.CPUAccessFlags = 0;
+		return;
+	}
 
-        // Fill a D3D11_SUBRESOURCE_DATA struct with the data we want in the buffer
-        D3D11_SUBRESOURCE_DATA vertexBufferData;
-        ZeroMemory(&vertexBufferData, sizeof(vertexBufferData));
-        vertexBufferData.pSysMem = &octreeVertices[0];
+	// Upload the current octree traversal on the cpu into the vertex buffer that is kept between the frames
+	// The vertices of the incremental traversal are uploaded directly from the cut
+    const std::vector<OctreeNodeVertex> &vertices = octree->GetVertices(octreeConstantBufferData, octreeVertices);
 
-        // Create the buffer
-        hr = d3d11Device->CreateBuffer(&vertexBufferDesc, &vertexBufferData, &vertexBuffer);
-		ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateBuffer) + L" failed for the " + NAMEOF(vertexBuffer));
+    vertexBufferCount = UpdateDynamicBuffer(vertexBuffer, NULL, vertexBufferCapacity, vertices.data(), vertices.size(), sizeof(OctreeNodeVertex));
+
+    if (vertexBufferCount > 0)
+    {
 
         // Set the shaders
         if (settings->viewMode == ViewMode::OctreeSplats)
@@ -306,8 +308,6 @@ void PointCloudEngine::OctreeRenderer::DrawOctree()
 		{
 			d3d11DevCon->Draw(vertexBufferCount, 0);
 		}
-
-        SAFE_RELEASE(vertexBuffer);
     }
 }
 
@@ -327,7 +327,7 @@ void PointCloudEngine::OctreeRenderer::DrawOctreeCompute()
 	rootEntry.index = 0;
 	rootEntry.position = octree->rootPosition;
 	rootEntry.size = octree->rootSize;
-	rootEntry.parentInsideViewFrustum = false;
+	rootEntry.parentInsidePlanes = 0;
 	rootEntry.depth = 0;
 
 	D3D11_BOX rootEntryBox;
@@ -393,6 +393,13 @@ void PointCloudEngine::OctreeRenderer::DrawOctreeCompute()
     d3d11DevCon->CSSetUnorderedAccessViews(1, 1, nullUAV, &zero);
     d3d11DevCon->CSSetUnorderedAccessViews(2, 1, nullUAV, &zero);
 
+	DrawEntries(vertexAppendBufferSRV);
+}
+
+void PointCloudEngine::OctreeRenderer::DrawEntries(ID3D11ShaderResourceView *entriesSRV)
+{
+	UINT zero = 0;
+
     // Set the shaders, only the vertex shader is different from the CPU implementation
     d3d11DevCon->VSSetShader(octreeComputeVSShader->vertexShader, 0, 0);
 
@@ -412,9 +419,9 @@ void PointCloudEngine::OctreeRenderer::DrawOctreeCompute()
         d3d11DevCon->PSSetShader(octreeClusterShader->pixelShader, 0, 0);
     }
 
-    // Set the vertex append buffer as structured buffer in the vertex shader
+    // Set the entries as structured buffer in the vertex shader
     d3d11DevCon->VSSetShaderResources(0, 1, &nodesBufferSRV);
-    d3d11DevCon->VSSetShaderResources(1, 1, &vertexAppendBufferSRV);
+    d3d11DevCon->VSSetShaderResources(1, 1, &entriesSRV);
 
     // Set an empty input layout and vertex buffer that only sends the vertex id to the shader
     d3d11DevCon->IASetInputLayout(NULL);
@@ -436,6 +443,92 @@ void PointCloudEngine::OctreeRenderer::DrawOctreeCompute()
     d3d11DevCon->VSSetShaderResources(1, 1, nullSRV);
 }
 
+UINT PointCloudEngine::OctreeRenderer::UpdateDynamicBuffer(ID3D11Buffer *&buffer, ID3D11ShaderResourceView **bufferSRV, UINT &capacity, const void *data, size_t count, UINT stride)
+{
+	// No buffer can be larger than the maximum resource size of the api, the elements behind it are not drawn
+	UINT maxCount = (UINT)min((UINT64)maxDynamicBufferBytes / stride, (UINT64)UINT_MAX);
+
+	if (count > maxCount)
+	{
+		Benchmark::Log(L"The cpu traversal output of " + std::to_wstring(count) + L" elements is larger than the maximum buffer size, only " + std::to_wstring(maxCount) + L" elements are drawn");
+		count = maxCount;
+	}
+
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	// Grow the buffer geometrically, a new buffer is only created in the few frames where the output is larger than ever before
+	if ((buffer == NULL) || (count > capacity))
+	{
+		SAFE_RELEASE(buffer);
+
+		if (bufferSRV != NULL)
+		{
+			SAFE_RELEASE(*bufferSRV);
+		}
+
+		D3D11_BUFFER_DESC bufferDesc;
+		ZeroMemory(&bufferDesc, sizeof(bufferDesc));
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.BindFlags = (bufferSRV != NULL) ? D3D11_BIND_SHADER_RESOURCE : D3D11_BIND_VERTEX_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		if (bufferSRV != NULL)
+		{
+			bufferDesc.StructureByteStride = stride;
+			bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		}
+
+		// The doubled capacity can be too large for the memory of the gpu, then try again without the headroom
+		capacity = (UINT)min(max((UINT64)count, 2 * (UINT64)capacity), (UINT64)maxCount);
+		bufferDesc.ByteWidth = capacity * stride;
+		hr = d3d11Device->CreateBuffer(&bufferDesc, NULL, &buffer);
+
+		if (FAILED(hr) && (capacity > count))
+		{
+			capacity = (UINT)count;
+			bufferDesc.ByteWidth = capacity * stride;
+			hr = d3d11Device->CreateBuffer(&bufferDesc, NULL, &buffer);
+		}
+
+		// Skip drawing instead of showing an error message in every frame, the next frame tries again
+		if (FAILED(hr))
+		{
+			Benchmark::Log(NAMEOF(d3d11Device->CreateBuffer) + L" failed for " + std::to_wstring(count) + L" elements of the cpu traversal output");
+			buffer = NULL;
+			capacity = 0;
+
+			return 0;
+		}
+
+		if (bufferSRV != NULL)
+		{
+			D3D11_SHADER_RESOURCE_VIEW_DESC bufferSRVDesc;
+			ZeroMemory(&bufferSRVDesc, sizeof(bufferSRVDesc));
+			bufferSRVDesc.Format = DXGI_FORMAT_UNKNOWN;
+			bufferSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			bufferSRVDesc.Buffer.ElementWidth = stride;
+			bufferSRVDesc.Buffer.NumElements = capacity;
+
+			hr = d3d11Device->CreateShaderResourceView(buffer, &bufferSRVDesc, bufferSRV);
+			ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateShaderResourceView) + L" failed for the " + NAMEOF(bufferSRV));
+		}
+	}
+
+	// Discarding the previous content lets the driver hand out new memory while the gpu still reads the buffer of the last frame
+	D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+	hr = d3d11DevCon->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
+	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11DevCon->Map) + L" failed for the " + NAMEOF(buffer));
+
+	memcpy(mappedSubresource.pData, data, count * stride);
+
+	d3d11DevCon->Unmap(buffer, 0);
+
+	return (UINT)count;
+}
+
 UINT PointCloudEngine::OctreeRenderer::GetStructureCount(ID3D11UnorderedAccessView *UAV)
 {
     UINT output = 0;
@@ -457,3 +550,42 @@ UINT PointCloudEngine::OctreeRenderer::GetStructureCount(ID3D11UnorderedAccessVi
 
     return output;
 }
+
+void PointCloudEngine::OctreeRenderer::CreateNodesBuffer()
+{
+    // Release the previous buffer when the nodes changed
+    SAFE_RELEASE(nodesBuffer);
+    SAFE_RELEASE(nodesBufferSRV);
+
+    if (!octree->HasNodesArray() || (octree->GetNodeCount() == 0))
+    {
+        return;
+    }
+
+    // Create the buffer for the compute shader that stores all the octree nodes (uploaded directly from the mapped .octree file)
+    // Maximum size is ~4.2 GB due to UINT_MAX
+    D3D11_BUFFER_DESC nodesBufferDesc;
+    ZeroMemory(&nodesBufferDesc, sizeof(nodesBufferDesc));
+    nodesBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    nodesBufferDesc.ByteWidth = octree->GetNodeCount() * sizeof(OctreeNode);
+    nodesBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    nodesBufferDesc.StructureByteStride = sizeof(OctreeNode);
+    nodesBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+
+    D3D11_SUBRESOURCE_DATA nodesBufferData;
+    ZeroMemory(&nodesBufferData, sizeof(nodesBufferData));
+	nodesBufferData.pSysMem = octree->GetNodes();
+
+    hr = d3d11Device->CreateBuffer(&nodesBufferDesc, &nodesBufferData, &nodesBuffer);
+	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateBuffer) + L" failed for the " + NAMEOF(nodesBuffer));
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC nodesBufferSRVDesc;
+    ZeroMemory(&nodesBufferSRVDesc, sizeof(nodesBufferSRVDesc));
+    nodesBufferSRVDesc.Format = DXGI_FORMAT_UNKNOWN;
+    nodesBufferSRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    nodesBufferSRVDesc.Buffer.ElementWidth = sizeof(OctreeNode);
+    nodesBufferSRVDesc.Buffer.NumElements = octree->GetNodeCount();
+
+    hr = d3d11Device->CreateShaderResourceView(nodesBuffer, &nodesBufferSRVDesc, &nodesBufferSRV);
+	ERROR_MESSAGE_ON_FAIL(hr, NAMEOF(d3d11Device->CreateShaderResourceView) + L" failed for the " + NAMEOF(nodesBufferSRV));
+}
@@ -9,22 +9,47 @@ namespace PointCloudEngine
     class OctreeRenderer : public Component, public IRenderer
     {
     public:
-        OctreeRenderer(const std::wstring &pointcloudFile);
+        OctreeRenderer(const std::wstring &pointcloudFile, const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress = NULL);
         void Initialize();
         void Update();
         void Draw();
         void Release();
 
         void GetBoundingCubePositionAndSize(Vector3 &outPosition, float &outSize);
+
+		// Edit the octree and upload the changed nodes for the compute shader traversal
+		bool InsertVertices(const std::vector<Vertex> &vertices);
+		bool DeleteVertices(const Vector3 &boxMin, const Vector3 &boxMax);
 		void RemoveComponentFromSceneObject();
 
     private:
         void DrawOctree();
         void DrawOctreeCompute();
+
+		// Draws the traversal entries with the nodes buffer, used by the gpu traversal and for the entries of the cpu traversal
+		void DrawEntries(ID3D11ShaderResourceView *entriesSRV);
+
+		// Writes the data into the dynamic vertex buffer (or structured buffer with the shader resource view), the buffer is only created again when it is too small
+		// Returns the number of elements that can be drawn, at most the maximum buffer size and 0 when the buffer could not be created
+		UINT UpdateDynamicBuffer(ID3D11Buffer *&buffer, ID3D11ShaderResourceView **bufferSRV, UINT &capacity, const void *data, size_t count, UINT stride);
+        void CreateNodesBuffer();
         UINT GetStructureCount(ID3D11UnorderedAccessView *UAV);
 
         int vertexBufferCount = 0;
 
+        // Output of the cpu traversal, kept between the frames to reuse its memory
+        std::vector<OctreeNodeVertex> octreeVertices;
+        std::vector<OctreeNodeTraversalEntry> octreeEntries;
+
+        // Dynamic buffers for the output of the cpu traversal, the capacity is the number of elements
+        // Largest resource that D3D11 allows, the buffers are not grown beyond it
+        static const UINT64 maxDynamicBufferBytes = (UINT64)D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_C_TERM * 1024 * 1024;
+        ID3D11Buffer *vertexBuffer = NULL;
+        UINT vertexBufferCapacity = 0;
+        ID3D11Buffer *entriesBuffer = NULL;
+        ID3D11ShaderResourceView *entriesBufferSRV = NULL;
+        UINT entriesBufferCapacity = 0;
+
         Octree *octree = NULL;
 
         // Renderer buffer
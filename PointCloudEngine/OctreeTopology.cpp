@@ -0,0 +1,144 @@
+#include "OctreeTopology.h"
+
+// Every byte of the mask words is one node
+static const UINT64 lowBits = 0x7f7f7f7f7f7f7f7full;
+static const UINT64 highBits = 0x8080808080808080ull;
+
+// Number of bytes in the word that are not zero (inner nodes), the high bit of each byte is set when any of its bits is set
+static UINT CountNonZeroBytes(UINT64 word)
+{
+	return (UINT)__popcnt64((((word & lowBits) + lowBits) | word) & highBits);
+}
+
+bool PointCloudEngine::OctreeTopology::Create(const OctreeNode *nodes, size_t nodeCount)
+{
+	this->nodeCount = nodeCount;
+
+	size_t blockCount = (nodeCount + blockNodeCount - 1) / blockNodeCount;
+	childrenMasks.assign(blockCount * blockNodeCount, 0);
+	blockChildRanks.resize(blockCount);
+	blockLeafRanks.resize(blockCount);
+	weights.resize(nodeCount * 3);
+	normals.resize(nodeCount * 4);
+	colors.resize(nodeCount * 4);
+	leafPositionFactors.clear();
+
+	UINT childCount = 0;
+	UINT leafCount = 0;
+
+	for (size_t i = 0; i < nodeCount; i++)
+	{
+		const OctreeNode &node = nodes[i];
+
+		if (i % blockNodeCount == 0)
+		{
+			blockChildRanks[i / blockNodeCount] = childCount;
+			blockLeafRanks[i / blockNodeCount] = leafCount;
+		}
+
+		if (node.IsLeafNode())
+		{
+			leafPositionFactors.push_back((node.childrenStartOrLeafPositionFactors >> 16) & 0xff);
+			leafPositionFactors.push_back((node.childrenStartOrLeafPositionFactors >> 8) & 0xff);
+			leafPositionFactors.push_back(node.childrenStartOrLeafPositionFactors & 0xff);
+			leafCount++;
+		}
+		else if (node.childrenStartOrLeafPositionFactors != 1 + childCount)
+		{
+			// Octrees with a different layout have to keep their children start indices
+			return false;
+		}
+
+		childrenMasks[i] = node.properties.childrenMask;
+		childCount += __popcnt(node.properties.childrenMask);
+
+		memcpy(&weights[i * 3], node.properties.weights, 3);
+		memcpy(&normals[i * 4], node.properties.normals, 4 * sizeof(ClusterNormal));
+		memcpy(&colors[i * 4], node.properties.colors, 4 * sizeof(Color16));
+	}
+
+	leafPositionFactors.shrink_to_fit();
+
+	return true;
+}
+
+PointCloudEngine::OctreeNode PointCloudEngine::OctreeTopology::GetNode(UINT index) const
+{
+	OctreeNode node;
+	node.properties.childrenMask = childrenMasks[index];
+
+	memcpy(node.properties.weights, &weights[index * 3], 3);
+	memcpy(node.properties.normals, &normals[index * 4], 4 * sizeof(ClusterNormal));
+	memcpy(node.properties.colors, &colors[index * 4], 4 * sizeof(Color16));
+
+	if (node.IsLeafNode())
+	{
+		const byte *factors = &leafPositionFactors[GetLeafIndex(index) * 3];
+		node.childrenStartOrLeafPositionFactors = (factors[0] << 16) | (factors[1] << 8) | factors[2];
+	}
+	else
+	{
+		node.childrenStartOrLeafPositionFactors = GetChildrenStart(index);
+	}
+
+	return node;
+}
+
+UINT PointCloudEngine::OctreeTopology::GetChildrenStart(UINT index) const
+{
+	// The popcnt of a mask word is the sum of the children counts of its 8 nodes
+	size_t wordIndex = (index / blockNodeCount) * (blockNodeCount / 8);
+	size_t lastWordIndex = index / 8;
+	UINT rank = blockChildRanks[index / blockNodeCount];
+
+	for (; wordIndex < lastWordIndex; wordIndex++)
+	{
+		rank += (UINT)__popcnt64(GetMaskWord(wordIndex));
+	}
+
+	// Only count the nodes in front of the index in the last word
+	UINT64 frontMask = (1ull << (8 * (index % 8))) - 1;
+	rank += (UINT)__popcnt64(GetMaskWord(lastWordIndex) & frontMask);
+
+	return 1 + rank;
+}
+
+UINT PointCloudEngine::OctreeTopology::GetLeafIndex(UINT index) const
+{
+	size_t wordIndex = (index / blockNodeCount) * (blockNodeCount / 8);
+	size_t lastWordIndex = index / 8;
+	UINT rank = blockLeafRanks[index / blockNodeCount];
+
+	for (; wordIndex < lastWordIndex; wordIndex++)
+	{
+		rank += 8 - CountNonZeroBytes(GetMaskWord(wordIndex));
+	}
+
+	UINT frontCount = index % 8;
+	UINT64 frontMask = (1ull << (8 * frontCount)) - 1;
+	rank += frontCount - CountNonZeroBytes(GetMaskWord(lastWordIndex) & frontMask);
+
+	return rank;
+}
+
+size_t PointCloudEngine::OctreeTopology::GetNodeCount() const
+{
+	return nodeCount;
+}
+
+size_t PointCloudEngine::OctreeTopology::GetMemoryUsage() const
+{
+	size_t memoryUsage = childrenMasks.capacity() + weights.capacity() + leafPositionFactors.capacity();
+	memoryUsage += (blockChildRanks.capacity() + blockLeafRanks.capacity()) * sizeof(UINT);
+	memoryUsage += normals.capacity() * sizeof(ClusterNormal) + colors.capacity() * sizeof(Color16);
+
+	return memoryUsage;
+}
+
+UINT64 PointCloudEngine::OctreeTopology::GetMaskWord(size_t wordIndex) const
+{
+	UINT64 word;
+	memcpy(&word, &childrenMasks[wordIndex * 8], sizeof(UINT64));
+
+	return word;
+}
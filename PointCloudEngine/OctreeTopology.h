@@ -0,0 +1,48 @@
+#ifndef OCTREETOPOLOGY_H
+#define OCTREETOPOLOGY_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Pointer free representation of a breadth first octree, the children start indices are computed instead of stored
+	// The children masks form a level ordered stream where the children of node i start at 1 + the sum of the children counts of the nodes before i
+	// Rank blocks store this sum and the number of leaves for every 64 nodes, the rest is counted with popcnt on the masks in the block
+	// The properties are stored in separate arrays and the leaf position factors are only stored for the leaf nodes
+	class OctreeTopology
+	{
+	public:
+		// Returns false when the children of the nodes are not stored in the breadth first order of their parents
+		bool Create(const OctreeNode *nodes, size_t nodeCount);
+
+		// Reconstructs the node with its computed children start index or its leaf position factors
+		OctreeNode GetNode(UINT index) const;
+		UINT GetChildrenStart(UINT index) const;
+		UINT GetLeafIndex(UINT index) const;
+
+		size_t GetNodeCount() const;
+
+		// Bytes of all the arrays, including the rank blocks
+		size_t GetMemoryUsage() const;
+
+	private:
+		static const UINT blockNodeCount = 64;
+
+		size_t nodeCount = 0;
+
+		// One byte for each node, padded to whole blocks so that always 8 masks can be read at once
+		std::vector<byte> childrenMasks;
+		std::vector<UINT> blockChildRanks;
+		std::vector<UINT> blockLeafRanks;
+
+		// Properties without the children mask and 3 bytes of position factors for each leaf
+		std::vector<byte> weights;
+		std::vector<ClusterNormal> normals;
+		std::vector<Color16> colors;
+		std::vector<byte> leafPositionFactors;
+
+		UINT64 GetMaskWord(size_t wordIndex) const;
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "OverlappedFileReadBackend.h"
+
+PointCloudEngine::OverlappedFileReadBackend::OverlappedFileReadBackend(UINT threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, threadCount);
+
+	if (completionPort == NULL)
+	{
+		throw std::exception("Could not create the I/O completion port!");
+	}
+
+	for (UINT i = 0; i < threadCount; i++)
+	{
+		threads.push_back(std::thread(&OverlappedFileReadBackend::CompletionLoop, this));
+	}
+}
+
+PointCloudEngine::OverlappedFileReadBackend::~OverlappedFileReadBackend()
+{
+	// A callback exception that was not rethrown by Wait is dropped, throwing from the destructor would terminate the process
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+
+	// A completion without an overlapped structure stops one thread
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		PostQueuedCompletionStatus(completionPort, 0, 0, NULL);
+	}
+
+	for (auto it = threads.begin(); it != threads.end(); it++)
+	{
+		it->join();
+	}
+
+	CloseHandle(completionPort);
+
+	for (auto it = queuedRequests.begin(); it != queuedRequests.end(); it++)
+	{
+		delete *it;
+	}
+
+	for (auto it = freeRequests.begin(); it != freeRequests.end(); it++)
+	{
+		delete *it;
+	}
+}
+
+bool PointCloudEngine::OverlappedFileReadBackend::Open(const std::wstring &filename, bool unbuffered)
+{
+	Close();
+
+	DWORD flags = FILE_FLAG_OVERLAPPED | FILE_FLAG_RANDOM_ACCESS | (unbuffered ? FILE_FLAG_NO_BUFFERING : 0);
+	file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, flags, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// The completions of all the reads of this file are sent to the completion port
+	if (CreateIoCompletionPort(file, completionPort, 0, 0) == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void PointCloudEngine::OverlappedFileReadBackend::Close()
+{
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		Wait();
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+}
+
+void PointCloudEngine::OverlappedFileReadBackend::QueueRead(UINT64 offset, UINT size, void *destination, std::function<void(DWORD)> completed)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Request *request = NULL;
+
+	if (freeRequests.empty())
+	{
+		request = new Request();
+	}
+	else
+	{
+		request = freeRequests.back();
+		freeRequests.pop_back();
+	}
+
+	ZeroMemory(&request->overlapped, sizeof(OVERLAPPED));
+	request->overlapped.Offset = (DWORD)offset;
+	request->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+	request->size = size;
+	request->destination = destination;
+	request->completed = completed;
+
+	queuedRequests.push_back(request);
+}
+
+void PointCloudEngine::OverlappedFileReadBackend::Submit()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	pendingCount += queuedRequests.size();
+	submittedRequests.insert(submittedRequests.end(), queuedRequests.begin(), queuedRequests.end());
+	queuedRequests.clear();
+
+	IssueRequests();
+}
+
+void PointCloudEngine::OverlappedFileReadBackend::Wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	completedCondition.wait(lock, [&] { return pendingCount == 0; });
+
+	// Rethrow the first exception of a callback in the waiting thread like the thread pool of the blocking backend
+	if (firstException != NULL)
+	{
+		std::exception_ptr exception = firstException;
+		firstException = NULL;
+		std::rethrow_exception(exception);
+	}
+}
+
+UINT PointCloudEngine::OverlappedFileReadBackend::GetThreadCount() const
+{
+	return (UINT)threads.size();
+}
+
+std::wstring PointCloudEngine::OverlappedFileReadBackend::GetName() const
+{
+	return L"overlapped";
+}
+
+void PointCloudEngine::OverlappedFileReadBackend::IssueRequests()
+{
+	while ((inFlightCount < maxQueueDepth) && !submittedRequests.empty())
+	{
+		Request *request = submittedRequests.front();
+		submittedRequests.pop_front();
+		inFlightCount++;
+
+		// Reads that complete synchronously also post their completion to the port, so only failed reads have to be completed here
+		// The failed reads (e.g. behind the end of the file) are posted with 0 bytes to call their callbacks on the completion threads
+		if (!ReadFile(file, request->destination, request->size, NULL, &request->overlapped) && (GetLastError() != ERROR_IO_PENDING))
+		{
+			PostQueuedCompletionStatus(completionPort, 0, 0, &request->overlapped);
+		}
+	}
+}
+
+void PointCloudEngine::OverlappedFileReadBackend::CompletionLoop()
+{
+	OVERLAPPED_ENTRY entries[completionBatchSize];
+
+	while (true)
+	{
+		ULONG entryCount = 0;
+
+		// Reads that failed asynchronously are also dequeued, their entries have the error status and 0 bytes
+		if (!GetQueuedCompletionStatusEx(completionPort, entries, completionBatchSize, &entryCount, INFINITE, FALSE))
+		{
+			continue;
+		}
+
+		UINT stopCount = 0;
+
+		for (ULONG i = 0; i < entryCount; i++)
+		{
+			if (entries[i].lpOverlapped == NULL)
+			{
+				stopCount++;
+				continue;
+			}
+
+			Request *request = (Request*)entries[i].lpOverlapped;
+			std::exception_ptr exception = NULL;
+
+			// An exception must not leave the completion thread, the read is completed anyway so that Wait returns
+			try
+			{
+				request->completed(entries[i].dwNumberOfBytesTransferred);
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+
+			request->completed = NULL;
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if ((exception != NULL) && (firstException == NULL))
+			{
+				firstException = exception;
+			}
+
+			freeRequests.push_back(request);
+			inFlightCount--;
+			pendingCount--;
+			IssueRequests();
+
+			if (pendingCount == 0)
+			{
+				completedCondition.notify_all();
+			}
+		}
+
+		if (stopCount > 0)
+		{
+			// Each thread has to receive its own stop completion, pass on the ones that were dequeued together with this one
+			for (UINT i = 1; i < stopCount; i++)
+			{
+				PostQueuedCompletionStatus(completionPort, 0, 0, NULL);
+			}
+
+			return;
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef OVERLAPPEDFILEREADBACKEND_H
+#define OVERLAPPEDFILEREADBACKEND_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Asynchronous reads with overlapped I/O and an I/O completion port, a few threads keep a deep queue of reads in flight
+	// Submit issues all the queued reads at once up to the maximum queue depth, the remaining reads are issued when earlier ones complete
+	// The completion threads dequeue the completed reads in batches and call their callbacks
+	class OverlappedFileReadBackend : public IFileReadBackend
+	{
+	public:
+		// Maximum number of reads that are in flight at the same time, enough to saturate the queues of fast drives
+		static const UINT maxQueueDepth = 128;
+
+		// A thread count of 0 uses all the hardware threads, the threads only run the callbacks and do not block on the reads
+		OverlappedFileReadBackend(UINT threadCount);
+		~OverlappedFileReadBackend();
+
+		bool Open(const std::wstring &filename, bool unbuffered);
+		void Close();
+		void QueueRead(UINT64 offset, UINT size, void *destination, std::function<void(DWORD)> completed);
+		void Submit();
+		void Wait();
+		UINT GetThreadCount() const;
+		std::wstring GetName() const;
+
+	private:
+		// The overlapped structure is the first member, the completion port returns it for each completed read
+		struct Request
+		{
+			OVERLAPPED overlapped;
+			UINT size;
+			void *destination;
+			std::function<void(DWORD)> completed;
+		};
+
+		// Number of completions that are dequeued at once
+		static const UINT completionBatchSize = 64;
+
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE completionPort = NULL;
+		std::vector<std::thread> threads;
+
+		// The requests are reused, queued requests wait for the submit and submitted requests wait for a free place in the queue
+		std::mutex mutex;
+		std::condition_variable completedCondition;
+		std::vector<Request*> freeRequests;
+		std::vector<Request*> queuedRequests;
+		std::deque<Request*> submittedRequests;
+		UINT inFlightCount = 0;
+		size_t pendingCount = 0;
+		std::exception_ptr firstException = NULL;
+
+		// Has to be called with the mutex locked
+		void IssueRequests();
+		void CompletionLoop();
+	};
+}
+#endif
\ No newline at end of file
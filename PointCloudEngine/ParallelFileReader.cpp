@@ -0,0 +1,228 @@
+#include "ParallelFileReader.h"
+
+PointCloudEngine::ParallelFileReader::ParallelFileReader(const FileReadParameters &fileReadParameters) : ParallelFileReader(fileReadParameters.threadCount, fileReadParameters.unbuffered, fileReadParameters.backendType)
+{
+}
+
+PointCloudEngine::ParallelFileReader::ParallelFileReader(UINT threadCount, bool unbuffered, FileReadBackendType backendType)
+{
+	this->unbuffered = unbuffered;
+	failed = false;
+	readBytes = 0;
+	nextChunk = 0;
+	backend = CreateBackend(backendType, threadCount);
+}
+
+PointCloudEngine::ParallelFileReader::~ParallelFileReader()
+{
+	// Wait for the reads that are still in flight before the buffers are released, an exception of a callback is dropped here
+	try
+	{
+		Wait();
+	}
+	catch (...)
+	{
+	}
+
+	SafeDelete(backend);
+	ReleaseBuffers();
+}
+
+bool PointCloudEngine::ParallelFileReader::Start(const std::wstring &filename, UINT64 offset, UINT64 size, void *destination, UINT chunkSize, std::function<void(UINT64, UINT64, const byte*)> processChunk)
+{
+	Wait();
+
+	if (!backend->Open(filename, unbuffered))
+	{
+		return false;
+	}
+
+	reading = true;
+	failed = false;
+	readBytes = 0;
+	start = std::chrono::steady_clock::now();
+
+	rangeOffset = offset;
+	rangeSize = size;
+	rangeDestination = (byte*)destination;
+	this->chunkSize = chunkSize;
+	this->processChunk = processChunk;
+	chunkCount = (size + chunkSize - 1) / chunkSize;
+
+	if ((destination != NULL) && !unbuffered)
+	{
+		// All the chunks are read directly into the destination, the backend limits the number of reads in flight
+		for (UINT64 chunk = 0; chunk < chunkCount; chunk++)
+		{
+			QueueChunk(chunk, NULL);
+		}
+	}
+	else
+	{
+		// An unaligned chunk can touch one more sector at both ends
+		size_t requiredBufferSize = (size_t)chunkSize + 2 * sectorSize;
+		size_t bufferCount = (size_t)min((UINT64)buffersPerThread * backend->GetThreadCount(), chunkCount);
+
+		if (requiredBufferSize > bufferSize)
+		{
+			ReleaseBuffers();
+			bufferSize = requiredBufferSize;
+		}
+
+		while (buffers.size() < bufferCount)
+		{
+			buffers.push_back((byte*)_aligned_malloc(bufferSize, sectorSize));
+		}
+
+		nextChunk = bufferCount;
+
+		for (size_t i = 0; i < bufferCount; i++)
+		{
+			QueueChunk(i, buffers[i]);
+		}
+	}
+
+	backend->Submit();
+
+	return true;
+}
+
+bool PointCloudEngine::ParallelFileReader::Wait()
+{
+	if (!reading)
+	{
+		return false;
+	}
+
+	// The file is also closed when a chunk callback threw, its exception is rethrown afterwards
+	std::exception_ptr exception = NULL;
+
+	try
+	{
+		backend->Wait();
+	}
+	catch (...)
+	{
+		exception = std::current_exception();
+	}
+
+	backend->Close();
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	reading = false;
+
+	if (exception != NULL)
+	{
+		std::rethrow_exception(exception);
+	}
+
+	return !failed;
+}
+
+bool PointCloudEngine::ParallelFileReader::Read(const std::wstring &filename, UINT64 offset, UINT64 size, void *destination, UINT chunkSize, std::function<void(UINT64, UINT64, const byte*)> processChunk)
+{
+	return Start(filename, offset, size, destination, chunkSize, processChunk) && Wait();
+}
+
+UINT64 PointCloudEngine::ParallelFileReader::GetReadBytes() const
+{
+	return readBytes;
+}
+
+double PointCloudEngine::ParallelFileReader::GetSeconds() const
+{
+	return seconds;
+}
+
+std::wstring PointCloudEngine::ParallelFileReader::GetStatistics() const
+{
+	double megabytes = readBytes / (1024.0 * 1024.0);
+
+	std::wstringstream stream;
+	stream << std::fixed << std::setprecision(1) << megabytes << L" MB in " << std::setprecision(3) << seconds << L" s, ";
+	stream << std::setprecision(1) << megabytes / max(seconds, 1e-9) << L" MB/s with " << backend->GetThreadCount() << L" threads";
+	stream << L" (" << backend->GetName() << (unbuffered ? L", unbuffered)" : L")");
+
+	return stream.str();
+}
+
+PointCloudEngine::IFileReadBackend* PointCloudEngine::ParallelFileReader::CreateBackend(FileReadBackendType backendType, UINT threadCount)
+{
+	if (backendType == FileReadBackendType::Overlapped)
+	{
+		return new OverlappedFileReadBackend(threadCount);
+	}
+
+	return new BlockingFileReadBackend(threadCount);
+}
+
+void PointCloudEngine::ParallelFileReader::QueueChunk(UINT64 chunk, byte *buffer)
+{
+	UINT64 chunkStart = chunk * chunkSize;
+	UINT64 count = min((UINT64)chunkSize, rangeSize - chunkStart);
+	UINT64 offset = rangeOffset + chunkStart;
+	byte *destination = (rangeDestination != NULL) ? (rangeDestination + chunkStart) : NULL;
+
+	if (buffer == NULL)
+	{
+		backend->QueueRead(offset, (UINT)count, destination, [=](DWORD bytes)
+		{
+			CompleteChunk(chunkStart, count, destination, bytes == count);
+		});
+
+		return;
+	}
+
+	// Unbuffered reads start and end at sector boundaries, the requested bytes are copied out of the aligned buffer
+	UINT64 readStart = unbuffered ? (offset / sectorSize) * sectorSize : offset;
+	UINT64 readEnd = unbuffered ? ((offset + count + sectorSize - 1) / sectorSize) * sectorSize : offset + count;
+
+	backend->QueueRead(readStart, (UINT)(readEnd - readStart), buffer, [=](DWORD bytes)
+	{
+		// The last sector of an unbuffered read can end behind the end of the file, only the requested bytes have to be read
+		bool success = bytes >= offset + count - readStart;
+
+		// Without a destination the chunk is only processed in the buffer and discarded afterwards
+		if (success && (destination != NULL))
+		{
+			memcpy(destination, buffer + (offset - readStart), count);
+		}
+
+		CompleteChunk(chunkStart, count, (destination != NULL) ? destination : (buffer + (offset - readStart)), success);
+
+		// Reuse the buffer for the next chunk, skip the remaining chunks after a failed read since the result is discarded anyway
+		UINT64 next = nextChunk++;
+
+		if (!failed && (next < chunkCount))
+		{
+			QueueChunk(next, buffer);
+			backend->Submit();
+		}
+	});
+}
+
+void PointCloudEngine::ParallelFileReader::CompleteChunk(UINT64 chunkStart, UINT64 count, const byte *chunk, bool success)
+{
+	if (!success)
+	{
+		failed = true;
+		return;
+	}
+
+	readBytes += count;
+
+	if (!failed && (processChunk != NULL))
+	{
+		processChunk(chunkStart, count, chunk);
+	}
+}
+
+void PointCloudEngine::ParallelFileReader::ReleaseBuffers()
+{
+	for (auto it = buffers.begin(); it != buffers.end(); it++)
+	{
+		_aligned_free(*it);
+	}
+
+	buffers.clear();
+	bufferSize = 0;
+}
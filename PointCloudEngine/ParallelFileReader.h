@@ -0,0 +1,78 @@
+#ifndef PARALLELFILEREADER_H
+#define PARALLELFILEREADER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Reads a byte range of a file in chunks with many positioned reads in flight, one large sequential read only uses a fraction of the bandwidth of fast storage
+	// Each chunk can be processed by the thread that completed it (e.g. converting the vertices) while the other chunks are still being read
+	// Unbuffered reads bypass the file cache (FILE_FLAG_NO_BUFFERING), the sector aligned reads go through aligned buffers then
+	// The reads are issued by a file read backend, either blocking reads on a thread pool or overlapped reads with a completion port
+	class ParallelFileReader
+	{
+	public:
+		// Chunks are read in ascending order, the callers choose the chunk size as a multiple of their element size
+		static const UINT defaultChunkSize = 8 * 1024 * 1024;
+
+		// A thread count of 0 uses all the hardware threads, the readers of a background load get the file read parameters that were copied on the main thread
+		ParallelFileReader(const FileReadParameters &fileReadParameters);
+		ParallelFileReader(UINT threadCount, bool unbuffered, FileReadBackendType backendType);
+		~ParallelFileReader();
+
+		// The callback gets the offset and size of the chunk relative to the start of the range and the bytes of the chunk in the destination
+		// Without a destination the callback gets the bytes in a reused buffer that is only valid during the callback (e.g. for converting them)
+		// Without a destination and callback the chunks are only read into the file cache, e.g. for a mapped file that is accessed afterwards
+		// Returns false when the file cannot be opened
+		bool Start(const std::wstring &filename, UINT64 offset, UINT64 size, void *destination, UINT chunkSize = defaultChunkSize, std::function<void(UINT64, UINT64, const byte*)> processChunk = NULL);
+
+		// Waits for all the chunks of the last start, returns false when any of them could not be read completely
+		// An exception of a chunk callback is rethrown after all the reads completed
+		bool Wait();
+
+		// Same as start and wait
+		bool Read(const std::wstring &filename, UINT64 offset, UINT64 size, void *destination, UINT chunkSize = defaultChunkSize, std::function<void(UINT64, UINT64, const byte*)> processChunk = NULL);
+
+		// Throughput of the last read from start to the end of the wait
+		UINT64 GetReadBytes() const;
+		double GetSeconds() const;
+		std::wstring GetStatistics() const;
+
+		// The caller owns the backend, a thread count of 0 uses all the hardware threads
+		static IFileReadBackend* CreateBackend(FileReadBackendType backendType, UINT threadCount);
+
+	private:
+		// Offsets and sizes of unbuffered reads have to be multiples of the sector size, 4096 also covers the drives with 512 byte sectors
+		static const UINT sectorSize = 4096;
+
+		// Number of aligned buffers per thread, each buffer reads its next chunk as soon as its last chunk is processed
+		static const UINT buffersPerThread = 2;
+
+		IFileReadBackend *backend = NULL;
+		bool unbuffered;
+		bool reading = false;
+		std::atomic<bool> failed;
+		std::atomic<UINT64> readBytes;
+		std::chrono::steady_clock::time_point start;
+		double seconds = 0;
+
+		// Range of the current read
+		UINT64 rangeOffset = 0;
+		UINT64 rangeSize = 0;
+		byte *rangeDestination = NULL;
+		UINT chunkSize = 0;
+		UINT64 chunkCount = 0;
+		std::atomic<UINT64> nextChunk;
+		std::function<void(UINT64, UINT64, const byte*)> processChunk;
+
+		// The sector aligned buffers of the unbuffered reads are allocated with _aligned_malloc once and reused by all the reads of this reader
+		std::vector<byte*> buffers;
+		size_t bufferSize = 0;
+
+		void QueueChunk(UINT64 chunk, byte *buffer);
+		void CompleteChunk(UINT64 chunkStart, UINT64 count, const byte *chunk, bool success);
+		void ReleaseBuffers();
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,555 @@
+#include "PlyImporter.h"
+
+PointCloudEngine::PlyImporter::PlyImporter(const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress)
+{
+	this->buildParameters = buildParameters;
+	this->progress = progress;
+}
+
+PointCloudEngine::OctreeBuildStatistics PointCloudEngine::PlyImporter::Import(const std::wstring &plyFile, const std::wstring &pointcloudFile)
+{
+	OctreeBuildStatistics statistics;
+	Benchmark::StartBuildStatistics(statistics);
+
+	std::ifstream file(plyFile, std::ios::in | std::ios::binary);
+
+	if (!ReadHeader(file))
+	{
+		throw std::exception("Could not load .ply file!");
+	}
+
+	if (progress != NULL)
+	{
+		progress->vertexCount = plyVertexCount;
+	}
+
+	minPosition = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	maxPosition = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	// The cache key depends on the content of the .pointcloud file, the octree is moved to its keyed filepath after both files are written
+	// Imports that run at the same time (e.g. in another instance) stage their octrees in their own temporary directories
+	temporaryDirectory = Octree::CreateTemporaryDirectory();
+	std::wstring octreeFile = temporaryDirectory + L"/" + pointcloudFile.substr(pointcloudFile.find_last_of(L"\\/") + 1) + L".octree";
+
+	try
+	{
+		// The vertex count in the .ply header decides about the octree generation before any vertex is read
+		OctreeExternalBuilder externalBuilder(buildParameters, progress);
+
+		bool outOfCore = externalBuilder.IsRequired(plyVertexCount);
+
+		if (outOfCore)
+		{
+			ImportOutOfCore(file, externalBuilder, pointcloudFile, octreeFile, statistics);
+		}
+		else
+		{
+			ImportInMemory(file, pointcloudFile, octreeFile, statistics);
+		}
+
+		// The .pointcloud file was hashed while writing it, loading it later uses the stored hash instead of reading the file again
+		Octree::SavePointcloudHash(pointcloudFile, pointcloudHash);
+		std::wstring cachedOctreeFile = Octree::GetOctreeFilepath(pointcloudFile, pointcloudHash, buildParameters.maxDepth, buildParameters.buildMode, buildParameters.useBottomUpAggregation, outOfCore);
+
+		if (!MoveFileEx(octreeFile.c_str(), cachedOctreeFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			throw std::exception("Could not move .octree file into the octree cache!");
+		}
+	}
+	catch (...)
+	{
+		DeleteFile(octreeFile.c_str());
+		RemoveDirectory(temporaryDirectory.c_str());
+		throw;
+	}
+
+	RemoveDirectory(temporaryDirectory.c_str());
+
+	Benchmark::FinishBuildStatistics(statistics);
+
+	return statistics;
+}
+
+void PointCloudEngine::PlyImporter::ImportInMemory(std::ifstream &file, const std::wstring &pointcloudFile, const std::wstring &octreeFile, OctreeBuildStatistics &statistics)
+{
+	std::vector<PointcloudVertex> pointcloudVertices;
+	pointcloudVertices.reserve(plyVertexCount);
+
+	for (UINT64 chunkStart = 0; chunkStart < plyVertexCount; chunkStart += chunkSize)
+	{
+		ReadVertices(file, min((UINT64)chunkSize, plyVertexCount - chunkStart), pointcloudVertices);
+	}
+
+	file.close();
+
+	Vector3 rootPosition;
+	float rootSize;
+	GetBoundingCube(rootPosition, rootSize);
+
+	// Randomly shuffle the vertices in order to be able to easily select the density by looking at the first k entries (used in GroundTruthRenderer)
+	std::shuffle(pointcloudVertices.begin(), pointcloudVertices.end(), randomEngine);
+
+	std::ofstream output(pointcloudFile, std::ios::out | std::ios::binary);
+	WritePointcloudHeader(output, pointcloudVertices.size());
+	WritePointcloud(output, pointcloudVertices.data(), pointcloudVertices.size() * sizeof(PointcloudVertex));
+	output.close();
+	pointcloudHash = hasher.Finish();
+
+	if (!output)
+	{
+		throw std::exception("Could not write .pointcloud file!");
+	}
+
+	// The octree is built from the same quantized vertices that are stored in the .pointcloud file
+	std::vector<Vertex> vertices(pointcloudVertices.size());
+
+	for (size_t i = 0; i < pointcloudVertices.size(); i++)
+	{
+		vertices[i] = pointcloudVertices[i].GetVertex();
+	}
+
+	std::vector<PointcloudVertex>().swap(pointcloudVertices);
+
+	std::vector<OctreeNode> nodes;
+	OctreeBuilder octreeBuilder(buildParameters.buildMode, buildParameters.useBottomUpAggregation, buildParameters.maxDepth, buildParameters.threadCount, progress);
+	octreeBuilder.Build(nodes, vertices, rootPosition, rootSize);
+
+	statistics.vertexCount = vertices.size();
+	statistics.nodeCount = nodes.size();
+	std::vector<Vertex>().swap(vertices);
+
+	if (!OctreeFile::Write(octreeFile, nodes.data(), nodes.size(), rootPosition, rootSize, buildParameters.compress, buildParameters.threadCount, progress))
+	{
+		throw std::exception("Could not write .octree file!");
+	}
+}
+
+void PointCloudEngine::PlyImporter::ImportOutOfCore(std::ifstream &file, OctreeExternalBuilder &externalBuilder, const std::wstring &pointcloudFile, const std::wstring &octreeFile, OctreeBuildStatistics &statistics)
+{
+	// Each vertex is assigned to a random temporary file that is shuffled in memory afterwards, this results in a uniformly random order
+	// A quarter of the memory budget is used for each temporary file to leave enough space for the buffers
+	UINT64 bucketVertexCount = max((UINT64)1, ((UINT64)buildParameters.memoryBudget * 1024 * 1024) / (4 * sizeof(PointcloudVertex)));
+	size_t bucketCount = min((UINT64)maxBucketCount, 1 + plyVertexCount / bucketVertexCount);
+
+	std::vector<std::wstring> bucketFilenames(bucketCount);
+	std::vector<std::ofstream*> bucketFiles(bucketCount, NULL);
+	std::vector<std::vector<PointcloudVertex>> buffers(bucketCount);
+	std::vector<UINT64> bucketVertexCounts(bucketCount, 0);
+	std::uniform_int_distribution<size_t> bucketDistribution(0, bucketCount - 1);
+
+	auto writeBuffer = [&](size_t i)
+	{
+		if (bucketFiles[i] == NULL)
+		{
+			bucketFilenames[i] = temporaryDirectory + L"/Import" + std::to_wstring(i) + L".tmp";
+			bucketFiles[i] = new std::ofstream(bucketFilenames[i], std::ios::out | std::ios::binary);
+		}
+
+		bucketFiles[i]->write((char*)buffers[i].data(), buffers[i].size() * sizeof(PointcloudVertex));
+
+		if (!*bucketFiles[i])
+		{
+			throw std::exception("Could not write temporary .pointcloud file!");
+		}
+
+		bucketVertexCounts[i] += buffers[i].size();
+		buffers[i].clear();
+	};
+
+	std::vector<PointcloudVertex> chunk;
+	bool pointcloudFileCreated = false;
+
+	try
+	{
+		for (UINT64 chunkStart = 0; chunkStart < plyVertexCount; chunkStart += chunkSize)
+		{
+			chunk.clear();
+			ReadVertices(file, min((UINT64)chunkSize, plyVertexCount - chunkStart), chunk);
+
+			for (auto it = chunk.begin(); it != chunk.end(); it++)
+			{
+				size_t i = bucketDistribution(randomEngine);
+				buffers[i].push_back(*it);
+
+				if (buffers[i].size() >= bucketBufferSize)
+				{
+					writeBuffer(i);
+				}
+			}
+		}
+
+		file.close();
+		UINT64 vertexCount = 0;
+
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			if (!buffers[i].empty())
+			{
+				writeBuffer(i);
+			}
+
+			SafeDelete(bucketFiles[i]);
+			vertexCount += bucketVertexCounts[i];
+		}
+
+		std::ofstream output(pointcloudFile, std::ios::out | std::ios::binary);
+		WritePointcloudHeader(output, vertexCount);
+		pointcloudFileCreated = true;
+
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			if (bucketVertexCounts[i] > 0)
+			{
+				if (progress != NULL)
+				{
+					progress->ThrowIfCanceled();
+				}
+
+				std::ifstream bucketFile(bucketFilenames[i], std::ios::in | std::ios::binary);
+				chunk.resize(bucketVertexCounts[i]);
+				bucketFile.read((char*)chunk.data(), chunk.size() * sizeof(PointcloudVertex));
+
+				if (!bucketFile)
+				{
+					throw std::exception("Could not read temporary .pointcloud file!");
+				}
+
+				bucketFile.close();
+				DeleteFile(bucketFilenames[i].c_str());
+				bucketFilenames[i].clear();
+
+				std::shuffle(chunk.begin(), chunk.end(), randomEngine);
+				WritePointcloud(output, chunk.data(), chunk.size() * sizeof(PointcloudVertex));
+			}
+		}
+
+		std::vector<PointcloudVertex>().swap(chunk);
+		output.close();
+		pointcloudHash = hasher.Finish();
+
+		if (!output)
+		{
+			throw std::exception("Could not write .pointcloud file!");
+		}
+	}
+	catch (...)
+	{
+		// Remove the temporary files when the import fails or is canceled
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			SafeDelete(bucketFiles[i]);
+
+			if (!bucketFilenames[i].empty())
+			{
+				DeleteFile(bucketFilenames[i].c_str());
+			}
+		}
+
+		// An incomplete .pointcloud file would be loaded the next time
+		if (pointcloudFileCreated)
+		{
+			DeleteFile(pointcloudFile.c_str());
+		}
+
+		throw;
+	}
+
+	// The external builder streams the new .pointcloud file with its own temporary directory
+	statistics = externalBuilder.Build(pointcloudFile, octreeFile);
+}
+
+void PointCloudEngine::PlyImporter::ReadVertices(std::ifstream &file, size_t count, std::vector<PointcloudVertex> &outVertices)
+{
+	std::vector<char> chunk;
+	std::vector<double> values(propertyCount);
+
+	if (progress != NULL)
+	{
+		progress->ThrowIfCanceled();
+	}
+
+	if (format != PlyFormat::Ascii)
+	{
+		chunk.resize(count * vertexSize);
+		file.read(chunk.data(), chunk.size());
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (format == PlyFormat::Ascii)
+		{
+			for (size_t j = 0; j < propertyCount; j++)
+			{
+				file >> values[j];
+			}
+		}
+
+		if (!file)
+		{
+			throw std::exception("Could not read .ply file!");
+		}
+
+		// Only the required properties are converted from binary
+		if (format != PlyFormat::Ascii)
+		{
+			for (auto it = properties.begin(); it != properties.end(); it++)
+			{
+				values[it->index] = GetValue(chunk.data() + i * vertexSize + it->offset, *it);
+			}
+		}
+
+		double x = values[properties[0].index];
+		double y = values[properties[1].index];
+		double z = values[properties[2].index];
+		double nx = values[properties[3].index];
+		double ny = values[properties[4].index];
+		double nz = values[properties[5].index];
+
+		Vertex vertex;
+		vertex.position = Vector3((float)x, (float)y, (float)z);
+		vertex.normal = Vector3((float)nx, (float)ny, (float)nz);
+
+		// Make sure that the normals are normalized
+		vertex.normal.Normalize();
+
+		// Only add vertices with a non zero normal
+		if (vertex.normal.LengthSquared() > 0.5f)
+		{
+			for (size_t j = 0; j < 3; j++)
+			{
+				// Floating point colors are in the range from 0 to 1
+				double color = values[properties[6 + j].index];
+
+				if (properties[6 + j].type == PlyType::Float32 || properties[6 + j].type == PlyType::Float64)
+				{
+					color = round(255 * color);
+				}
+
+				vertex.color[j] = (byte)max(0.0, min(255.0, color));
+			}
+
+			outVertices.push_back(PointcloudVertex(vertex));
+
+			minPosition = Vector3::Min(minPosition, vertex.position);
+			maxPosition = Vector3::Max(maxPosition, vertex.position);
+		}
+	}
+
+	if (progress != NULL)
+	{
+		progress->loadedVertexCount += count;
+	}
+}
+
+void PointCloudEngine::PlyImporter::GetBoundingCube(Vector3 &outPosition, float &outSize)
+{
+	if (minPosition.x > maxPosition.x)
+	{
+		throw std::exception("No vertices with a normal in the .ply file!");
+	}
+
+	// Calculate center and size of the bounding cube that fully encloses the point cloud
+	Vector3 diagonal = maxPosition - minPosition;
+	outPosition = minPosition + 0.5f * diagonal;
+	outSize = max(diagonal.x, max(diagonal.y, diagonal.z));
+}
+
+void PointCloudEngine::PlyImporter::WritePointcloudHeader(std::ofstream &file, UINT64 vertexCount)
+{
+	Vector3 boundingCubePosition;
+	float boundingCubeSize;
+
+	GetBoundingCube(boundingCubePosition, boundingCubeSize);
+
+	// The header is hashed together with the vertices
+	std::ostringstream header;
+	::WritePointcloudHeader(header, boundingCubePosition, boundingCubeSize, vertexCount);
+	WritePointcloud(file, header.str().data(), header.str().size());
+}
+
+void PointCloudEngine::PlyImporter::WritePointcloud(std::ofstream &file, const void *data, size_t size)
+{
+	hasher.Add(data, size);
+	file.write((const char*)data, size);
+}
+
+bool PointCloudEngine::PlyImporter::ReadHeader(std::ifstream &file)
+{
+	std::string line;
+	std::getline(file, line);
+
+	if (line.find("ply") != 0)
+	{
+		return false;
+	}
+
+	bool formatFound = false;
+	bool vertexElement = false;
+	bool vertexElementDone = false;
+	std::map<std::string, PlyProperty> vertexProperties;
+
+	properties.clear();
+	plyVertexCount = 0;
+	vertexSize = 0;
+	propertyCount = 0;
+
+	while (std::getline(file, line))
+	{
+		// Files written on windows might contain carriage returns
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		std::istringstream lineStream(line);
+		std::string keyword;
+		lineStream >> keyword;
+
+		if (keyword == "format")
+		{
+			std::string formatName;
+			lineStream >> formatName;
+			formatFound = true;
+
+			if (formatName == "ascii")
+			{
+				format = PlyFormat::Ascii;
+			}
+			else if (formatName == "binary_little_endian")
+			{
+				format = PlyFormat::BinaryLittleEndian;
+			}
+			else if (formatName == "binary_big_endian")
+			{
+				format = PlyFormat::BinaryBigEndian;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (keyword == "element")
+		{
+			std::string elementName;
+			UINT64 elementCount = 0;
+			lineStream >> elementName >> elementCount;
+
+			vertexElementDone |= vertexElement;
+			vertexElement = (elementName == "vertex");
+
+			if (vertexElement)
+			{
+				plyVertexCount = elementCount;
+			}
+			else if (!vertexElementDone && elementCount > 0)
+			{
+				// The vertices must be the first data in the file to be able to stream them without parsing other elements
+				return false;
+			}
+		}
+		else if (keyword == "property" && vertexElement)
+		{
+			std::string typeName;
+			PlyProperty property;
+			lineStream >> typeName >> property.name;
+
+			// List properties have no fixed size and cannot be parsed in chunks
+			if (!ParseType(typeName, property.type, property.size))
+			{
+				return false;
+			}
+
+			property.index = propertyCount;
+			property.offset = vertexSize;
+			vertexSize += property.size;
+			propertyCount++;
+			vertexProperties[property.name] = property;
+		}
+		else if (keyword == "end_header")
+		{
+			break;
+		}
+	}
+
+	if (!formatFound || line != "end_header")
+	{
+		return false;
+	}
+
+	const char* requiredProperties[] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue" };
+
+	for (const char* name : requiredProperties)
+	{
+		auto it = vertexProperties.find(name);
+
+		if (it == vertexProperties.end())
+		{
+			return false;
+		}
+
+		properties.push_back(it->second);
+	}
+
+	return true;
+}
+
+double PointCloudEngine::PlyImporter::GetValue(const char *data, const PlyProperty &property)
+{
+	char bytes[8];
+	memcpy(bytes, data, property.size);
+
+	if (format == PlyFormat::BinaryBigEndian)
+	{
+		std::reverse(bytes, bytes + property.size);
+	}
+
+	switch (property.type)
+	{
+		case PlyType::Int8:
+			return *(signed char*)bytes;
+		case PlyType::UInt8:
+			return *(unsigned char*)bytes;
+		case PlyType::Int16:
+			return *(short*)bytes;
+		case PlyType::UInt16:
+			return *(unsigned short*)bytes;
+		case PlyType::Int32:
+			return *(int*)bytes;
+		case PlyType::UInt32:
+			return *(UINT*)bytes;
+		case PlyType::Float32:
+			return *(float*)bytes;
+		default:
+			return *(double*)bytes;
+	}
+}
+
+bool PointCloudEngine::PlyImporter::ParseType(const std::string &name, PlyType &outType, size_t &outSize)
+{
+	const std::pair<const char*, PlyType> types[] =
+	{
+		{ "char", PlyType::Int8 }, { "int8", PlyType::Int8 },
+		{ "uchar", PlyType::UInt8 }, { "uint8", PlyType::UInt8 },
+		{ "short", PlyType::Int16 }, { "int16", PlyType::Int16 },
+		{ "ushort", PlyType::UInt16 }, { "uint16", PlyType::UInt16 },
+		{ "int", PlyType::Int32 }, { "int32", PlyType::Int32 },
+		{ "uint", PlyType::UInt32 }, { "uint32", PlyType::UInt32 },
+		{ "float", PlyType::Float32 }, { "float32", PlyType::Float32 },
+		{ "double", PlyType::Float64 }, { "float64", PlyType::Float64 }
+	};
+
+	const size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+	for (auto type : types)
+	{
+		if (name == type.first)
+		{
+			outType = type.second;
+			outSize = sizes[(int)type.second];
+
+			return true;
+		}
+	}
+
+	return false;
+}
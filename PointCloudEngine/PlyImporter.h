@@ -0,0 +1,94 @@
+#ifndef PLYIMPORTER_H
+#define PLYIMPORTER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Converts a .ply file into a .pointcloud file and writes the .octree file in the same run
+	// The .ply vertices are parsed in chunks, only the quantized .pointcloud vertices are kept and directly passed to the octree generation
+	// Point clouds that exceed the memory budget are shuffled through temporary files and built by the OctreeExternalBuilder
+	class PlyImporter
+	{
+	public:
+		// The memory budget of the parameters is given in megabytes
+		PlyImporter(const OctreeBuildParameters &buildParameters, OctreeBuildProgress *progress = NULL);
+
+		// Requires a vertex element with x,y,z,nx,ny,nz,red,green,blue properties, vertices without a normal are skipped
+		// The .pointcloud vertices are randomly shuffled like the ones of the PlyToPointcloud.exe
+		// The .octree file is stored in the octree cache with the key of the written .pointcloud file, its content is hashed while writing it
+		OctreeBuildStatistics Import(const std::wstring &plyFile, const std::wstring &pointcloudFile);
+
+	private:
+		enum class PlyFormat
+		{
+			Ascii,
+			BinaryLittleEndian,
+			BinaryBigEndian
+		};
+
+		enum class PlyType
+		{
+			Int8,
+			UInt8,
+			Int16,
+			UInt16,
+			Int32,
+			UInt32,
+			Float32,
+			Float64
+		};
+
+		struct PlyProperty
+		{
+			std::string name;
+			PlyType type;
+			size_t size;
+			size_t index;
+			size_t offset;
+		};
+
+		// Vertices that are parsed from the .ply file at once
+		static const size_t chunkSize = 1 << 20;
+
+		// Upper limit for the temporary files that shuffle the vertices of large point clouds
+		static const size_t maxBucketCount = 256;
+
+		// Vertices that are buffered for each temporary file before writing them
+		static const size_t bucketBufferSize = 1 << 12;
+
+		OctreeBuildParameters buildParameters;
+		OctreeBuildProgress *progress = NULL;
+
+		// Own directory of this import for the staged .octree file and the temporary files
+		std::wstring temporaryDirectory;
+
+		// Vertex element of the .ply header, the properties are stored in the order x,y,z,nx,ny,nz,red,green,blue
+		PlyFormat format;
+		UINT64 plyVertexCount = 0;
+		size_t vertexSize = 0;
+		size_t propertyCount = 0;
+		std::vector<PlyProperty> properties;
+
+		Vector3 minPosition;
+		Vector3 maxPosition;
+		std::mt19937 randomEngine;
+
+		// Everything that is written to the .pointcloud file is added to the hasher
+		FileHasher hasher;
+		UINT64 pointcloudHash = 0;
+
+		void ImportInMemory(std::ifstream &file, const std::wstring &pointcloudFile, const std::wstring &octreeFile, OctreeBuildStatistics &statistics);
+		void ImportOutOfCore(std::ifstream &file, OctreeExternalBuilder &externalBuilder, const std::wstring &pointcloudFile, const std::wstring &octreeFile, OctreeBuildStatistics &statistics);
+		void ReadVertices(std::ifstream &file, size_t count, std::vector<PointcloudVertex> &outVertices);
+		void GetBoundingCube(Vector3 &outPosition, float &outSize);
+		void WritePointcloudHeader(std::ofstream &file, UINT64 vertexCount);
+		void WritePointcloud(std::ofstream &file, const void *data, size_t size);
+
+		bool ReadHeader(std::ifstream &file);
+		double GetValue(const char *data, const PlyProperty &property);
+		static bool ParseType(const std::string &name, PlyType &outType, size_t &outSize);
+	};
+}
+#endif
\ No newline at end of file
@@ -95,47 +95,53 @@ void ErrorMessageOnFail(HRESULT hr, std::wstring message, std::wstring file, int
 	}
 }
 
-bool LoadPointcloudFile(std::vector<Vertex>& outVertices, Vector3& outBoundingCubePosition, float& outBoundingCubeSize, const std::wstring& pointcloudFile)
+bool LoadPointcloudFile(std::vector<Vertex>& outVertices, Vector3& outBoundingCubePosition, float& outBoundingCubeSize, const std::wstring& pointcloudFile, const FileReadParameters& fileReadParameters, UINT64 maxVertexCount)
 {
 	try
 	{
-		struct PointcloudVertex
-		{
-			// Stores the .pointcloud vertices
-			Vector3 position;
-			char normal[3];
-			unsigned char color[3];
-		};
-
 		// Try to load the point cloud from the file
 		// This file has a header with the bounding cube position and size followed by the length of the vertex array
 		// Then the position, 8bit normal and 8bit rgb color of each vertex is stored in binary data
 		std::ifstream file(pointcloudFile, std::ios::in | std::ios::binary);
 
-		// Load the bounding cube position and size
-		file.read((char*)&outBoundingCubePosition, sizeof(Vector3));
-		file.read((char*)&outBoundingCubeSize, sizeof(float));
+		// Load the bounding cube position, size and the size of the vertices vector
+		UINT64 vertexCount;
 
-		// Load the size of the vertices vector
-		UINT vertexCount;
-		file.read((char*)&vertexCount, sizeof(UINT));
+		if (!ReadPointcloudHeader(file, outBoundingCubePosition, outBoundingCubeSize, vertexCount))
+		{
+			return false;
+		}
 
-		// Read the binary data directly into the vertices vector
-		std::vector<PointcloudVertex> pointcloudVertices = std::vector<PointcloudVertex>(vertexCount);
-		file.read((char*)pointcloudVertices.data(), vertexCount * sizeof(PointcloudVertex));
+		UINT64 headerSize = file.tellg();
+		file.close();
 
-		// Convert to the required vertex format
+		// The vertices are randomly shuffled, therefore the first vertices are evenly distributed over the whole point cloud
+		vertexCount = min(vertexCount, maxVertexCount);
+
+		// Read the binary data in chunks of whole vertices with multiple threads, only the converted vertices are stored completely
 		outVertices = std::vector<Vertex>(vertexCount);
 
-		for (UINT i = 0; i < vertexCount; i++)
+		ParallelFileReader reader(fileReadParameters);
+		UINT chunkSize = (ParallelFileReader::defaultChunkSize / sizeof(PointcloudVertex)) * sizeof(PointcloudVertex);
+
+		// Convert each chunk to the required vertex format directly out of the read buffer while the next chunks are still being read
+		bool read = reader.Read(pointcloudFile, headerSize, vertexCount * sizeof(PointcloudVertex), NULL, chunkSize, [&](UINT64 chunkStart, UINT64 chunkBytes, const byte *chunk)
+		{
+			const PointcloudVertex *pointcloudVertices = (const PointcloudVertex*)chunk;
+			Vertex *vertices = outVertices.data() + chunkStart / sizeof(PointcloudVertex);
+			size_t count = chunkBytes / sizeof(PointcloudVertex);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				vertices[i] = pointcloudVertices[i].GetVertex();
+			}
+		});
+
+		Benchmark::Log(L"Read " + pointcloudFile + L": " + reader.GetStatistics());
+
+		if (!read)
 		{
-			outVertices[i].position = pointcloudVertices[i].position;
-			outVertices[i].normal.x = pointcloudVertices[i].normal[0] / 127.0f;
-			outVertices[i].normal.y = pointcloudVertices[i].normal[1] / 127.0f;
-			outVertices[i].normal.z = pointcloudVertices[i].normal[2] / 127.0f;
-			outVertices[i].color[0] = pointcloudVertices[i].color[0];
-			outVertices[i].color[1] = pointcloudVertices[i].color[1];
-			outVertices[i].color[2] = pointcloudVertices[i].color[2];
+			return false;
 		}
 	}
 	catch (const std::exception& e)
@@ -146,6 +152,40 @@ bool LoadPointcloudFile(std::vector<Vertex>& outVertices, Vector3& outBoundingCu
 	return true;
 }
 
+bool ReadPointcloudHeader(std::istream &file, Vector3 &outBoundingCubePosition, float &outBoundingCubeSize, UINT64 &outVertexCount)
+{
+	UINT vertexCount = 0;
+
+	file.read((char*)&outBoundingCubePosition, sizeof(Vector3));
+	file.read((char*)&outBoundingCubeSize, sizeof(float));
+	file.read((char*)&vertexCount, sizeof(UINT));
+	outVertexCount = vertexCount;
+
+	// Files with more vertices store the marker instead of the count, the 64 bit count follows
+	if (vertexCount == UINT_MAX)
+	{
+		file.read((char*)&outVertexCount, sizeof(UINT64));
+	}
+
+	return file.good();
+}
+
+void WritePointcloudHeader(std::ostream &file, const Vector3 &boundingCubePosition, const float &boundingCubeSize, UINT64 vertexCount, UINT64 maxVertexCount)
+{
+	// The 32 bit count of the first version is kept whenever it fits, this way older files and tools stay compatible
+	// The max vertex count reserves the larger header when the vertex count is only known after writing the vertices
+	UINT vertexCountUINT = (max(vertexCount, maxVertexCount) < UINT_MAX) ? (UINT)vertexCount : UINT_MAX;
+
+	file.write((char*)&boundingCubePosition, sizeof(Vector3));
+	file.write((char*)&boundingCubeSize, sizeof(float));
+	file.write((char*)&vertexCountUINT, sizeof(UINT));
+
+	if (vertexCountUINT == UINT_MAX)
+	{
+		file.write((char*)&vertexCount, sizeof(UINT64));
+	}
+}
+
 void SaveScreenshotToFile()
 {
 	// Save the texture to the hard drive
@@ -627,8 +667,8 @@ bool InitializeScene()
 
     // Compile the shared shaders
     textShader = Shader::Create(L"Shader/Text.hlsl", true, true, true, false, Shader::textLayout, 3);
-    splatShader = Shader::Create(L"Shader/Splat.hlsl", true, true, true, false, Shader::splatLayout, 3);
-	pointShader = Shader::Create(L"Shader/Point.hlsl", true, true, true, false, Shader::splatLayout, 3);
+    splatShader = Shader::Create(L"Shader/Splat.hlsl", true, true, true, false, NULL, 0);
+	pointShader = Shader::Create(L"Shader/Point.hlsl", true, true, true, false, NULL, 0);
 	waypointShader = Shader::Create(L"Shader/Waypoint.hlsl", true, false, true, false, Shader::waypointLayout, 2);
     octreeCubeShader = Shader::Create(L"Shader/OctreeCube.hlsl", true, true, true, false, Shader::octreeLayout, 14);
     octreeSplatShader = Shader::Create(L"Shader/OctreeSplat.hlsl", true, true, true, false, Shader::octreeLayout, 14);
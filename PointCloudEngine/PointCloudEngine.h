@@ -21,6 +21,25 @@ namespace PointCloudEngine
     class Settings;
     class Camera;
     class Octree;
+	class OctreeBuilder;
+	class OctreeExternalBuilder;
+	class OctreeEditor;
+	class PlyImporter;
+	class ScratchArena;
+	class OctreeFile;
+	class OctreePageCache;
+	class OctreeTopology;
+	class ParallelFileReader;
+	class PointcloudFile;
+	class IFileReadBackend;
+	class BlockingFileReadBackend;
+	class OverlappedFileReadBackend;
+	class ThreadPool;
+	class Benchmark;
+	class NormalClustering;
+	class FrustumCuller;
+	class OctreeCut;
+	class DecodeTables;
 	class GUI;
     struct OctreeNode;
 
@@ -43,6 +62,18 @@ namespace PointCloudEngine
 		Normal,
 		NormalScreen
 	};
+
+	enum class OctreeBuildMode
+	{
+		TopDown,
+		Morton
+	};
+
+	enum class FileReadBackendType
+	{
+		Blocking,
+		Overlapped
+	};
 }
 
 using namespace PointCloudEngine;
@@ -55,10 +86,30 @@ using namespace PointCloudEngine;
 #include "Component.h"
 #include "SceneObject.h"
 #include "Hierarchy.h"
+#include "DecodeTables.h"
 #include "Structures.h"
 #include "Settings.h"
 #include "IRenderer.h"
+#include "ThreadPool.h"
+#include "Benchmark.h"
+#include "NormalClustering.h"
+#include "FrustumCuller.h"
 #include "OctreeNode.h"
+#include "OctreeBuilder.h"
+#include "OctreeExternalBuilder.h"
+#include "OctreeEditor.h"
+#include "FileHasher.h"
+#include "PlyImporter.h"
+#include "ScratchArena.h"
+#include "OctreeFile.h"
+#include "OctreePageCache.h"
+#include "OctreeTopology.h"
+#include "OctreeCut.h"
+#include "IFileReadBackend.h"
+#include "BlockingFileReadBackend.h"
+#include "OverlappedFileReadBackend.h"
+#include "ParallelFileReader.h"
+#include "PointcloudFile.h"
 #include "Octree.h"
 #include "TextRenderer.h"
 #include "GroundTruthRenderer.h"
@@ -123,7 +174,9 @@ extern LightingConstantBuffer lightingConstantBufferData;
 // Global function declarations
 extern bool OpenFileDialog(const wchar_t* filter, std::wstring &outFilename);
 extern void ErrorMessageOnFail(HRESULT hr, std::wstring message, std::wstring file, int line);
-extern bool LoadPointcloudFile(std::vector<Vertex> &outVertices, Vector3 &outBoundingCubePosition, float &outBoundingCubeSize, const std::wstring &pointcloudFile);
+extern bool LoadPointcloudFile(std::vector<Vertex> &outVertices, Vector3 &outBoundingCubePosition, float &outBoundingCubeSize, const std::wstring &pointcloudFile, const FileReadParameters &fileReadParameters, UINT64 maxVertexCount = ULLONG_MAX);
+extern bool ReadPointcloudHeader(std::istream &file, Vector3 &outBoundingCubePosition, float &outBoundingCubeSize, UINT64 &outVertexCount);
+extern void WritePointcloudHeader(std::ostream &file, const Vector3 &boundingCubePosition, const float &boundingCubeSize, UINT64 vertexCount, UINT64 maxVertexCount = 0);
 extern void SaveScreenshotToFile();
 extern void SetFullscreen(bool fullscreen);
 extern void DrawBlended(UINT vertexCount, ID3D11Buffer* constantBuffer, const void* constantBufferData, int &useBlending);
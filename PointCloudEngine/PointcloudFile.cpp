@@ -0,0 +1,122 @@
+#include "PointcloudFile.h"
+
+PointCloudEngine::PointcloudFile::~PointcloudFile()
+{
+	Close();
+}
+
+bool PointCloudEngine::PointcloudFile::Open(const std::wstring &filename, const FileReadParameters &fileReadParameters, UINT64 maxVertexCount)
+{
+	Close();
+
+	// Other processes can open and map the same file at the same time
+	file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0))
+	{
+		Close();
+		return false;
+	}
+
+	mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	view = (mapping != NULL) ? (const byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (view == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	// The header is parsed from a copy of its largest possible size, the 64 bit vertex count is optional
+	std::istringstream header(std::string((const char*)view, (size_t)min((UINT64)size.QuadPart, (UINT64)(sizeof(Vector3) + sizeof(float) + sizeof(UINT) + sizeof(UINT64)))));
+
+	if (!ReadPointcloudHeader(header, boundingCubePosition, boundingCubeSize, vertexCount))
+	{
+		Close();
+		return false;
+	}
+
+	headerSize = header.tellg();
+	this->filename = filename;
+
+	// The vertices are randomly shuffled, therefore the first vertices are evenly distributed over the whole point cloud
+	vertexCount = min(vertexCount, maxVertexCount);
+
+	if ((UINT64)size.QuadPart < headerSize + vertexCount * sizeof(PointcloudVertex))
+	{
+		Close();
+		return false;
+	}
+
+	// The mapping only reads a few pages at a time, larger reads of multiple threads load the vertices into the file cache ahead of the accesses
+	// Unbuffered reads would bypass the file cache, they are never used for reading ahead
+	reader = new ParallelFileReader(fileReadParameters.threadCount, false, fileReadParameters.backendType);
+	reader->Start(filename, headerSize, vertexCount * sizeof(PointcloudVertex), NULL);
+
+	return true;
+}
+
+void PointCloudEngine::PointcloudFile::Close()
+{
+	WaitForReadAhead();
+
+	if (view != NULL)
+	{
+		UnmapViewOfFile(view);
+		view = NULL;
+	}
+
+	if (mapping != NULL)
+	{
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+}
+
+bool PointCloudEngine::PointcloudFile::IsOpen() const
+{
+	return view != NULL;
+}
+
+void PointCloudEngine::PointcloudFile::WaitForReadAhead()
+{
+	if (reader != NULL)
+	{
+		reader->Wait();
+		Benchmark::Log(L"Read " + filename + L" ahead of the mapping: " + reader->GetStatistics());
+		SafeDelete(reader);
+	}
+}
+
+const PointCloudEngine::PointcloudVertex* PointCloudEngine::PointcloudFile::GetVertices() const
+{
+	return (const PointcloudVertex*)(view + headerSize);
+}
+
+UINT64 PointCloudEngine::PointcloudFile::GetVertexCount() const
+{
+	return vertexCount;
+}
+
+Vector3 PointCloudEngine::PointcloudFile::GetBoundingCubePosition() const
+{
+	return boundingCubePosition;
+}
+
+float PointCloudEngine::PointcloudFile::GetBoundingCubeSize() const
+{
+	return boundingCubeSize;
+}
@@ -0,0 +1,45 @@
+#ifndef POINTCLOUDFILE_H
+#define POINTCLOUDFILE_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Maps a .pointcloud file into memory and gives access to the vertices as they are stored in the file, nothing is copied or converted
+	// The vertices are read into the file cache by multiple threads in the background while they are already being accessed through the mapping
+	// Consumers that need float normals dequantize the vertices themselves when they use them (e.g. the ground truth vertex shader)
+	class PointcloudFile
+	{
+	public:
+		~PointcloudFile();
+
+		// Only maps the first vertices of the file when the maximum vertex count is smaller than the vertex count of the file
+		// Returns false when the file does not exist or is shorter than its header says
+		bool Open(const std::wstring &filename, const FileReadParameters &fileReadParameters, UINT64 maxVertexCount = ULLONG_MAX);
+		void Close();
+		bool IsOpen() const;
+
+		// Blocks until the background reads of the vertices into the file cache are finished, the accesses through the mapping are fast afterwards
+		void WaitForReadAhead();
+
+		// Only valid while the file is open, the vertices are not aligned since they directly follow the header
+		const PointcloudVertex* GetVertices() const;
+		UINT64 GetVertexCount() const;
+		Vector3 GetBoundingCubePosition() const;
+		float GetBoundingCubeSize() const;
+
+	private:
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+		const byte *view = NULL;
+		ParallelFileReader *reader = NULL;
+		std::wstring filename;
+
+		UINT64 headerSize = 0;
+		UINT64 vertexCount = 0;
+		Vector3 boundingCubePosition;
+		float boundingCubeSize = 0;
+	};
+}
+#endif
\ No newline at end of file
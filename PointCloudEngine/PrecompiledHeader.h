@@ -18,11 +18,25 @@
 #include <limits>
 #include <map>
 #include <queue>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <psapi.h>
+#include <intrin.h>
 #include <math.h>
 #include <wincodec.h>
 #include <CommCtrl.h>
 #include <shellapi.h>
 
+// Compression of the .octree files with the zlib of the HDF5 installation
+#include <zlib.h>
+
 // Resources like menus and icons
 #include "resource.h"
 
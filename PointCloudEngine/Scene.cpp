@@ -11,7 +11,7 @@ void Scene::Initialize()
 
 	// Create startup text
 	startupTextRenderer = new TextRenderer(TextRenderer::GetSpriteFont(L"Arial"), false);
-	startupTextRenderer->text = L"Welcome to PointCloudEngine!\nThis engine renders .pointcloud files.\nYou can convert .ply files with the PlyToPointcloud.exe!\nThis requires .ply files with x,y,z,nx,ny,nz,red,green,blue format.\nYou can change parameters (resolution, ...) in the Settings.txt file.\n\n\nPress File->Open to open a .pointcloud file.";
+	startupTextRenderer->text = L"Welcome to PointCloudEngine!\nThis engine renders .pointcloud files.\nYou can open .ply files directly or convert them with the PlyToPointcloud.exe!\nThis requires .ply files with x,y,z,nx,ny,nz,red,green,blue format.\nYou can change parameters (resolution, ...) in the Settings.txt file.\n\n\nPress File->Open to open a .pointcloud or .ply file.";
 	startupText = Hierarchy::Create(L"Startup Text");
 	startupText->AddComponent(startupTextRenderer);
 	startupText->transform->scale = Vector3(0.25, 0.35, 1);
@@ -23,8 +23,8 @@ void Scene::Initialize()
     loadingTextRenderer->text = L"Loading...";
     loadingText = Hierarchy::Create(L"Loading Text");
     loadingText->AddComponent(loadingTextRenderer);
-	loadingText->transform->scale = Vector3::One;
-    loadingText->transform->position = Vector3(-0.5f, 0.25f, 0.5f);
+	loadingText->transform->scale = Vector3(0.25, 0.35, 1);
+    loadingText->transform->position = Vector3(-0.95f, 0.4f, 0.5f);
 
     // Try to load the last pointcloudFile
     LoadFile(settings->pointcloudFile);
@@ -92,15 +92,38 @@ void Scene::Update(Timer &timer)
 		Input::SetMode(Mouse::MODE_ABSOLUTE);
 	}
 
-	// Show fps
+	// Show fps and the heap allocations since the last update (allocation free frames should show a value close to zero)
 	GUI::fps = timer.GetFramesPerSecond();
+	UINT64 allocationCount = Benchmark::GetAllocationCount();
+	GUI::allocationsPerFrame = allocationCount - lastAllocationCount;
+	lastAllocationCount = allocationCount;
 
-    // Save config file and exit on ESC
-    if (Input::GetKeyDown(Keyboard::Escape))
+    // Cancel the loading or save config file and exit on ESC
+    if (Input::GetKeyDown(Keyboard::Escape) && !CancelLoading())
     {
         DestroyWindow(hwnd);
     }
 
+	// Swap in the renderer as soon as it was created in the background, a canceled loading thread is only joined after it stopped
+	if (loadingThread.joinable())
+	{
+		if (loadingFinished)
+		{
+			if (loadingCanceled)
+			{
+				DiscardLoading();
+			}
+			else
+			{
+				FinishLoading();
+			}
+		}
+		else if (!loadingCanceled)
+		{
+			UpdateLoadingText();
+		}
+	}
+
 	Hierarchy::UpdateAllSceneObjects();
 }
 
@@ -108,7 +131,7 @@ void Scene::Draw()
 {
 	Hierarchy::CalculateWorldMatrices();
 
-	if (pointCloudRenderer == NULL)
+	if ((pointCloudRenderer == NULL) && !loadingThread.joinable())
 	{
 		startupTextRenderer->Draw();
 	}
@@ -120,6 +143,11 @@ void Scene::Draw()
 
 void Scene::Release()
 {
+	if (CancelLoading())
+	{
+		DiscardLoading();
+	}
+
 	Hierarchy::ReleaseAllSceneObjects();
 	GUI::Release();
 }
@@ -132,7 +160,7 @@ void PointCloudEngine::Scene::OpenPointcloudFile()
 
 	std::wstring filename;
 
-	if (OpenFileDialog(L"Pointcloud Files\0*.pointcloud\0\0", filename))
+	if (OpenFileDialog(L"Pointcloud Files\0*.pointcloud\0Ply Files\0*.ply\0\0", filename))
 	{
 		LoadFile(filename);
 	}
@@ -140,6 +168,12 @@ void PointCloudEngine::Scene::OpenPointcloudFile()
 
 void PointCloudEngine::Scene::LoadFile(std::wstring filepath)
 {
+	// Only one file is loaded at a time
+	if (CancelLoading())
+	{
+		DiscardLoading();
+	}
+
 	// Check if the file exists
 	std::wifstream file(filepath);
 
@@ -150,82 +184,231 @@ void PointCloudEngine::Scene::LoadFile(std::wstring filepath)
 		return;
 	}
 
+	file.close();
+
     // Release resources before loading
     if (pointCloudRenderer != NULL)
     {
 		pointCloudRenderer->RemoveComponentFromSceneObject();
+		pointCloudRenderer = NULL;
+		GUI::groundTruthRenderer = NULL;
         SetWindowTextW(hwnd, L"PointCloudEngine");
 
 		// Hide GUI
 		GUI::SetVisible(false);
     }
 
-    try
-    {
-		// Clear screen and depth and initialize everything so that we can draw (possibly before any update)
-		d3d11DevCon->ClearRenderTargetView(renderTargetView, (float*)&settings->backgroundColor);
-		d3d11DevCon->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-		d3d11DevCon->OMSetRenderTargets(1, &renderTargetView, depthStencilView);
-		Hierarchy::CalculateWorldMatrices();
-		camera->PrepareDraw();
+	// .ply files are converted into a .pointcloud file next to them, the .octree file is written in the same pass
+	bool plyFile = (filepath.length() > 4) && (_wcsicmp(filepath.substr(filepath.length() - 4).c_str(), L".ply") == 0);
+	std::wstring pointcloudFile = plyFile ? (filepath.substr(0, filepath.length() - 4) + L".pointcloud") : filepath;
+	bool useOctree = settings->useOctree;
+
+	// The GUI can change the settings while loading, the loading thread only uses this copy
+	OctreeBuildParameters buildParameters = settings->GetOctreeBuildParameters();
 
-		// Show loading screen
-		loadingTextRenderer->enabled = true;
-		loadingTextRenderer->Draw();
-		loadingTextRenderer->enabled = false;
+	// Set the path for the new file
+	settings->pointcloudFile = pointcloudFile;
 
-		// Present the result on the screen
-		swapChain->Present(0, 0);
+	loadingProgress.Reset();
+	loadingFinished = false;
+	loadingCanceled = false;
+	loadingError.clear();
+	loadingStart = std::chrono::steady_clock::now();
+	loadingTextRenderer->enabled = true;
+	startupTextRenderer->enabled = false;
+	SetWindowTextW(hwnd, (L"Loading - " + filepath).c_str());
+
+    // Reset point cloud
+    pointCloud->transform->position = Vector3::Zero;
+    pointCloud->transform->rotation = Quaternion::Identity;
 
-		// Set the path for the new file
-		settings->pointcloudFile = filepath;
+    // Reset camera rotation
+	camera->SetRotationMatrix(Matrix::CreateFromYawPitchRoll(0, 0, 0));
 
-		if (settings->useOctree)
+	// The .pointcloud vertices are shuffled, this way the first vertices are a coarse preview of the whole point cloud
+	if (!plyFile && (settings->previewVertexCount > 0))
+	{
+		try
 		{
-			// Try to build the octree from the points (takes a long time)
-			pointCloudRenderer = new OctreeRenderer(settings->pointcloudFile);
+			previewRenderer = new GroundTruthRenderer(pointcloudFile, buildParameters.fileRead, settings->previewVertexCount);
+			pointCloud->AddComponent(previewRenderer);
+			SetCameraPosition(previewRenderer);
 		}
-		else
+		catch (const std::exception &e)
 		{
-			GroundTruthRenderer* groundTruthRenderer = new GroundTruthRenderer(settings->pointcloudFile);
-			GUI::groundTruthRenderer = groundTruthRenderer;
-			pointCloudRenderer = groundTruthRenderer;
+			previewRenderer = NULL;
 		}
+	}
 
-    }
-    catch (std::exception e)
-    {
-		ERROR_MESSAGE(L"Could not open " + settings->pointcloudFile + L"\nOnly .pointcloud files with x,y,z,nx,ny,nz,red,green,blue vertex format are supported!\nUse e.g. MeshLab and Ply2Pointcloud.exe to convert .ply files to the required format.");
+	// Create the renderer in the background (building the octree takes a long time), the main thread keeps drawing the preview and the progress
+	loadingThread = std::thread([this, filepath, pointcloudFile, plyFile, useOctree, buildParameters]()
+	{
+		try
+		{
+			if (plyFile)
+			{
+				PlyImporter plyImporter(buildParameters, &loadingProgress);
+				OctreeBuildStatistics importStatistics = plyImporter.Import(filepath, pointcloudFile);
+				Benchmark::LogBuildStatistics(L"Ply import", buildParameters.buildMode, buildParameters.useBottomUpAggregation, importStatistics);
+			}
+
+			if (useOctree)
+			{
+				loadedRenderer = new OctreeRenderer(pointcloudFile, buildParameters, &loadingProgress);
+			}
+			else
+			{
+				loadedRenderer = new GroundTruthRenderer(pointcloudFile, buildParameters.fileRead);
+			}
+		}
+		catch (const std::exception &e)
+		{
+			// The main thread shows the error message
+			std::string message = e.what();
+			loadingError = std::wstring(message.begin(), message.end());
+			loadedRenderer = NULL;
+		}
 
-        // Set the pointer to NULL because the creation of the object failed
-        pointCloudRenderer = NULL;
-    }
+		loadingFinished = true;
+	});
+}
 
-    if (pointCloudRenderer != NULL)
-    {
-        pointCloud->AddComponent(pointCloudRenderer);
-        SetWindowTextW(hwnd, ((settings->useOctree ? L"Octree Renderer - " : L"Ground Truth Renderer - ") + settings->pointcloudFile).c_str());
+bool PointCloudEngine::Scene::CancelLoading()
+{
+	if (!loadingThread.joinable())
+	{
+		return false;
+	}
 
-        // Set camera position in front of the object
-        Vector3 boundingBoxPosition;
-        float boundingBoxSize;
+	// The octree generation stops at its next check and discards the partial results, the thread is joined in Update when it finished
+	// Waiting for it here would freeze the window until the current step of the loading checks the progress
+	if (!loadingCanceled)
+	{
+		loadingProgress.canceled = true;
+		loadingCanceled = true;
 
-        pointCloudRenderer->GetBoundingCubePositionAndSize(boundingBoxPosition, boundingBoxSize);
+		RemovePreview();
+		loadingTextRenderer->text = L"Canceling...";
+		SetWindowTextW(hwnd, L"Canceling - PointCloudEngine");
+	}
 
-        camera->SetPosition(settings->scale * (boundingBoxPosition - boundingBoxSize * Vector3::UnitZ));
+	return true;
+}
 
-		// Show the GUI
-		GUI::Initialize();
-		GUI::SetVisible(true);
-    }
+void PointCloudEngine::Scene::DiscardLoading()
+{
+	loadingThread.join();
 
-	// Show the other text
-	startupTextRenderer->enabled = false;
+	// The renderer might have been completed right before canceling
+	if (loadedRenderer != NULL)
+	{
+		Component *component = dynamic_cast<Component*>(loadedRenderer);
+		component->Release();
+		SafeDelete(component);
+		loadedRenderer = NULL;
+	}
 
-    // Reset point cloud
-    pointCloud->transform->position = Vector3::Zero;
-    pointCloud->transform->rotation = Quaternion::Identity;
+	RemovePreview();
+	loadingCanceled = false;
+	loadingTextRenderer->enabled = false;
+	startupTextRenderer->enabled = true;
+	SetWindowTextW(hwnd, L"PointCloudEngine");
+}
 
-    // Reset camera rotation
-	camera->SetRotationMatrix(Matrix::CreateFromYawPitchRoll(0, 0, 0));
+void PointCloudEngine::Scene::FinishLoading()
+{
+	loadingThread.join();
+	loadingTextRenderer->enabled = false;
+
+	bool previewShown = (previewRenderer != NULL);
+	RemovePreview();
+
+	if (loadedRenderer == NULL)
+	{
+		ERROR_MESSAGE(L"Could not open " + settings->pointcloudFile + L"\n" + loadingError + L"\nOnly .pointcloud and .ply files with x,y,z,nx,ny,nz,red,green,blue vertex format are supported!\nUse e.g. MeshLab and Ply2Pointcloud.exe to convert .ply files to the required format.");
+
+		startupTextRenderer->enabled = true;
+		SetWindowTextW(hwnd, L"PointCloudEngine");
+		return;
+	}
+
+	// The components are initialized on the main thread
+	pointCloudRenderer = loadedRenderer;
+	loadedRenderer = NULL;
+	pointCloud->AddComponent(pointCloudRenderer);
+	GUI::groundTruthRenderer = dynamic_cast<GroundTruthRenderer*>(pointCloudRenderer);
+	SetWindowTextW(hwnd, ((settings->useOctree ? L"Octree Renderer - " : L"Ground Truth Renderer - ") + settings->pointcloudFile).c_str());
+
+	// Keep the camera if it was already placed for the preview
+	if (!previewShown)
+	{
+		SetCameraPosition(pointCloudRenderer);
+	}
+
+	// Show the GUI
+	GUI::Initialize();
+	GUI::SetVisible(true);
+}
+
+void PointCloudEngine::Scene::RemovePreview()
+{
+	if (previewRenderer != NULL)
+	{
+		previewRenderer->RemoveComponentFromSceneObject();
+		previewRenderer = NULL;
+	}
+}
+
+void PointCloudEngine::Scene::SetCameraPosition(IRenderer *renderer)
+{
+	// Set camera position in front of the object
+	Vector3 boundingBoxPosition;
+	float boundingBoxSize;
+
+	renderer->GetBoundingCubePositionAndSize(boundingBoxPosition, boundingBoxSize);
+
+	camera->SetPosition(settings->scale * (boundingBoxPosition - boundingBoxSize * Vector3::UnitZ));
+}
+
+void PointCloudEngine::Scene::UpdateLoadingText()
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadingStart).count();
+	std::wstringstream text;
+
+	text << L"Loading... " << (int)seconds << L"s" << std::endl;
+
+	if (loadingProgress.vertexCount > 0)
+	{
+		text << L"Vertices loaded: " << loadingProgress.loadedVertexCount << L" / " << loadingProgress.vertexCount << std::endl;
+		text << L"Vertices partitioned: " << loadingProgress.partitionedVertexCount << L" / " << loadingProgress.vertexCount << std::endl;
+	}
+
+	if (loadingProgress.loadedNodeCount > 0)
+	{
+		text << L"Nodes loaded: " << loadingProgress.loadedNodeCount << std::endl;
+	}
+
+	// Nodes created at each level, the levels are separated by spaces
+	std::wstringstream levels;
+	UINT64 nodeCount = 0;
+
+	for (int level = 0; level < OctreeBuildProgress::maxLevelCount; level++)
+	{
+		UINT64 levelNodeCount = loadingProgress.levelNodeCounts[level];
+
+		if (levelNodeCount > 0)
+		{
+			levels << levelNodeCount << L" ";
+			nodeCount += levelNodeCount;
+		}
+	}
+
+	if (nodeCount > 0)
+	{
+		text << L"Nodes created: " << nodeCount << std::endl;
+		text << L"Nodes per level: " << levels.str() << std::endl;
+	}
+
+	text << std::endl << L"Press ESC to cancel";
+	loadingTextRenderer->text = text.str();
 }
@@ -16,6 +16,9 @@ namespace PointCloudEngine
 		void OpenPointcloudFile();
 		void LoadFile(std::wstring filepath);
 
+		// Stops loading the file in the background without waiting for it, returns false when no file is loaded
+		bool CancelLoading();
+
     private:
 		SceneObject *startupText = NULL;
         SceneObject *loadingText = NULL;
@@ -24,11 +27,30 @@ namespace PointCloudEngine
 		TextRenderer* loadingTextRenderer = NULL;
 		WaypointRenderer* waypointRenderer = NULL;
         IRenderer *pointCloudRenderer = NULL;
+		GroundTruthRenderer *previewRenderer = NULL;
+
+		// The renderer is created on this thread and added to the point cloud by the main thread when it is finished
+		std::thread loadingThread;
+		std::atomic<bool> loadingFinished;
+		bool loadingCanceled = false;
+		IRenderer *loadedRenderer = NULL;
+		// Message of the exception that stopped the loading thread, only read after loadingFinished is set
+		std::wstring loadingError;
+		OctreeBuildProgress loadingProgress;
+		std::chrono::steady_clock::time_point loadingStart;
 
         Vector2 input;
+		UINT64 lastAllocationCount = 0;
 
 		// Speed up WASD, Q/E, V/N and so on for faster movement and parameter tweaking
         float inputSpeed = 0;
+
+		void FinishLoading();
+		// Waits for the canceled loading thread and releases the renderer that it might have created
+		void DiscardLoading();
+		void RemovePreview();
+		void SetCameraPosition(IRenderer *renderer);
+		void UpdateLoadingText();
     };
 }
 #endif
@@ -0,0 +1,148 @@
+#include "ScratchArena.h"
+
+static std::atomic<UINT64> blockAllocationCount(0);
+
+PointCloudEngine::ScratchArena::Scope::Scope(ScratchArena &arena) : arena(arena)
+{
+	blockIndex = arena.blockIndex;
+	offset = arena.offset;
+}
+
+PointCloudEngine::ScratchArena::Scope::~Scope()
+{
+	arena.blockIndex = blockIndex;
+	arena.offset = offset;
+}
+
+PointCloudEngine::ScratchArena::ScratchArena(size_t blockSize)
+{
+	this->blockSize = blockSize;
+}
+
+PointCloudEngine::ScratchArena::~ScratchArena()
+{
+	for (auto it = blocks.begin(); it != blocks.end(); it++)
+	{
+		VirtualFree(it->data, 0, MEM_RELEASE);
+	}
+}
+
+PointCloudEngine::ScratchArena& PointCloudEngine::ScratchArena::GetThreadArena()
+{
+	static thread_local ScratchArena threadArena;
+
+	return threadArena;
+}
+
+void PointCloudEngine::ScratchArena::Reset()
+{
+	blockIndex = 0;
+	offset = 0;
+}
+
+UINT64 PointCloudEngine::ScratchArena::GetBlockAllocationCount()
+{
+	return blockAllocationCount;
+}
+
+void* PointCloudEngine::ScratchArena::AllocateBytes(size_t size, size_t alignment)
+{
+	// Use the current block or the following blocks that were allocated before the arena was rewound
+	while (blockIndex < blocks.size())
+	{
+		size_t alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+
+		if (alignedOffset + size <= blocks[blockIndex].size)
+		{
+			offset = alignedOffset + size;
+			return blocks[blockIndex].data + alignedOffset;
+		}
+
+		// Only move on to the next block when it is large enough, otherwise a new block is inserted in between
+		if ((blockIndex + 1 < blocks.size()) && (size <= blocks[blockIndex + 1].size))
+		{
+			blockIndex++;
+			offset = 0;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	// The blocks are allocated with VirtualAlloc and therefore page aligned
+	size_t insertIndex = blocks.empty() ? 0 : (blockIndex + 1);
+	blocks.insert(blocks.begin() + insertIndex, AllocateBlock(max(size, blockSize)));
+	blockIndex = insertIndex;
+	offset = size;
+
+	return blocks[blockIndex].data;
+}
+
+PointCloudEngine::ScratchArena::Block PointCloudEngine::ScratchArena::AllocateBlock(size_t size)
+{
+	Block block;
+	block.data = NULL;
+	block.size = size;
+
+	if ((settings != NULL) && settings->useLargePages && IsLargePageAvailable())
+	{
+		// Large pages reduce the TLB misses when the build scratch is accessed randomly, the size has to be a multiple of the large page size
+		size_t largePageSize = GetLargePageMinimum();
+		size_t largePageBlockSize = (size + largePageSize - 1) & ~(largePageSize - 1);
+		block.data = (byte*)VirtualAlloc(NULL, largePageBlockSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+
+		if (block.data != NULL)
+		{
+			block.size = largePageBlockSize;
+		}
+	}
+
+	// Fall back to regular pages when the large pages are disabled, not permitted or too fragmented
+	if (block.data == NULL)
+	{
+		block.data = (byte*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+
+	if (block.data == NULL)
+	{
+		throw std::bad_alloc();
+	}
+
+	blockAllocationCount++;
+
+	return block;
+}
+
+bool PointCloudEngine::ScratchArena::IsLargePageAvailable()
+{
+	static bool largePageAvailable = []()
+	{
+		// The user needs the "Lock pages in memory" right, it also has to be enabled in the process token
+		HANDLE token = NULL;
+
+		if ((GetLargePageMinimum() == 0) || !OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+		{
+			return false;
+		}
+
+		TOKEN_PRIVILEGES privileges;
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+		bool enabled = LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) && AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL);
+
+		// AdjustTokenPrivileges also succeeds when the privilege was not assigned to the user
+		enabled = enabled && (GetLastError() == ERROR_SUCCESS);
+		CloseHandle(token);
+
+		if (!enabled)
+		{
+			Benchmark::Log(L"Large pages are not available, the lock pages in memory privilege is missing");
+		}
+
+		return enabled;
+	}();
+
+	return largePageAvailable;
+}
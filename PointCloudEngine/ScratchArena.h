@@ -0,0 +1,69 @@
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Monotonic allocator for temporary memory, allocations only move an offset inside a few large blocks
+	// Memory is returned by rewinding to a marker (usually with a Scope) or by resetting the whole arena, the blocks are kept for the next allocations
+	// Only the objects that do not need a destructor can be stored in the arena, each arena must only be used by one thread at a time
+	class ScratchArena
+	{
+	public:
+		// Rewinds the arena to the position at construction time when it goes out of scope
+		class Scope
+		{
+		public:
+			Scope(ScratchArena &arena);
+			~Scope();
+
+		private:
+			ScratchArena &arena;
+			size_t blockIndex;
+			size_t offset;
+		};
+
+		// Blocks are at least this large, larger allocations get their own block
+		static const size_t defaultBlockSize = 1 << 20;
+
+		ScratchArena(size_t blockSize = defaultBlockSize);
+		~ScratchArena();
+
+		// Arena of the calling thread, it is created on first use and freed when the thread exits
+		static ScratchArena& GetThreadArena();
+
+		// Uninitialized memory for count elements of type T, aligned to at least 16 bytes
+		template<typename T> T* Allocate(size_t count)
+		{
+			return (T*)AllocateBytes(sizeof(T) * count, max(alignof(T), (size_t)16));
+		}
+
+		// Frees every allocation but keeps the blocks
+		void Reset();
+
+		// Number of blocks that were requested from the operating system by all the arenas, this stops growing once the arenas are warmed up
+		static UINT64 GetBlockAllocationCount();
+
+	private:
+		struct Block
+		{
+			byte *data;
+			size_t size;
+		};
+
+		size_t blockSize;
+		size_t blockIndex = 0;
+		size_t offset = 0;
+		std::vector<Block> blocks;
+
+		void* AllocateBytes(size_t size, size_t alignment);
+		Block AllocateBlock(size_t size);
+
+		// Tries to enable the lock memory privilege once, large pages are only used with settings->useLargePages
+		// Only the arena blocks can be large pages, the nodes and vertex vectors use the standard allocator
+		static bool IsLargePageAvailable();
+	};
+}
+#endif
\ No newline at end of file
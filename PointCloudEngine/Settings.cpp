@@ -38,6 +38,9 @@ PointCloudEngine::Settings::Settings()
 		TryParse(NAMEOF(pointcloudFile), &pointcloudFile);
 		TryParse(NAMEOF(samplingRate), &samplingRate);
 		TryParse(NAMEOF(scale), &scale);
+		TryParse(NAMEOF(fileReadThreads), &fileReadThreads);
+		TryParse(NAMEOF(useUnbufferedReads), &useUnbufferedReads);
+		TryParse(NAMEOF(fileReadBackend), &fileReadBackend);
 
 		// Parse lighting parameters
 		TryParse(NAMEOF(useLighting), &useLighting);
@@ -85,6 +88,21 @@ PointCloudEngine::Settings::Settings()
 		TryParse(NAMEOF(useCulling), &useCulling);
 		TryParse(NAMEOF(useGPUTraversal), &useGPUTraversal);
 		TryParse(NAMEOF(maxOctreeDepth), &maxOctreeDepth);
+		TryParse(NAMEOF(octreeBuildThreads), &octreeBuildThreads);
+		TryParse(NAMEOF(octreeTraversalThreads), &octreeTraversalThreads);
+		TryParse(NAMEOF(useIncrementalTraversal), &useIncrementalTraversal);
+		TryParse(NAMEOF(useCPUTraversalEntries), &useCPUTraversalEntries);
+		TryParse(NAMEOF(octreeBuildMode), &octreeBuildMode);
+		TryParse(NAMEOF(useBottomUpAggregation), &useBottomUpAggregation);
+		TryParse(NAMEOF(octreeMemoryBudget), &octreeMemoryBudget);
+		TryParse(NAMEOF(previewVertexCount), &previewVertexCount);
+		TryParse(NAMEOF(useLargePages), &useLargePages);
+		TryParse(NAMEOF(verifyOctreeFiles), &verifyOctreeFiles);
+		TryParse(NAMEOF(compressOctreeFiles), &compressOctreeFiles);
+		TryParse(NAMEOF(usePagedOctree), &usePagedOctree);
+		TryParse(NAMEOF(octreePageCacheBudget), &octreePageCacheBudget);
+		TryParse(NAMEOF(useSuccinctOctree), &useSuccinctOctree);
+		TryParse(NAMEOF(octreeCacheDirectory), &octreeCacheDirectory);
 		TryParse(NAMEOF(overlapFactor), &overlapFactor);
 		TryParse(NAMEOF(splatResolution), &splatResolution);
 		TryParse(NAMEOF(appendBufferCount), &appendBufferCount);
@@ -130,10 +148,14 @@ std::wstring PointCloudEngine::Settings::ToKeyValueString()
 	settingsStream << std::endl;
 
 	settingsStream << L"# Pointcloud File Parameters" << std::endl;
-	settingsStream << L"# Delete old .octree files when changing the " << NAMEOF(maxOctreeDepth) << std::endl;
+	settingsStream << L"# The .pointcloud and .octree files are read in chunks by " << NAMEOF(fileReadThreads) << L" threads, " << NAMEOF(useUnbufferedReads) << L" bypasses the file cache" << std::endl;
+	settingsStream << L"# Set " << NAMEOF(fileReadBackend) << L" to 0 for blocking reads on a thread pool or 1 for overlapped reads with an I/O completion port" << std::endl;
 	settingsStream << NAMEOF(pointcloudFile) << L"=" << pointcloudFile << std::endl;
 	settingsStream << NAMEOF(samplingRate) << L"=" << samplingRate << std::endl;
 	settingsStream << NAMEOF(scale) << L"=" << scale << std::endl;
+	settingsStream << NAMEOF(fileReadThreads) << L"=" << fileReadThreads << std::endl;
+	settingsStream << NAMEOF(useUnbufferedReads) << L"=" << useUnbufferedReads << std::endl;
+	settingsStream << NAMEOF(fileReadBackend) << L"=" << (int)fileReadBackend << std::endl;
 	settingsStream << std::endl;
 
 	settingsStream << L"# Lighting Parameters" << std::endl;
@@ -183,10 +205,39 @@ std::wstring PointCloudEngine::Settings::ToKeyValueString()
 	settingsStream << std::endl;
 
 	settingsStream << L"# Octree Parameters, increase " << NAMEOF(appendBufferCount) << L" when you see flickering" << std::endl;
+	settingsStream << L"# Set " << NAMEOF(octreeBuildThreads) << L" to 0 in order to use all hardware threads for the octree generation" << std::endl;
+	settingsStream << L"# The cpu traversal splits wide octree levels across " << NAMEOF(octreeTraversalThreads) << L" threads (0 for all hardware threads, 1 to traverse on the render thread only)" << std::endl;
+	settingsStream << L"# " << NAMEOF(useIncrementalTraversal) << L" keeps the level of detail cut of the cpu traversal between the frames and only updates the nodes that can have changed" << std::endl;
+	settingsStream << L"# " << NAMEOF(useCPUTraversalEntries) << L" uploads only the node indices and positions of the cpu traversal and reads the node properties on the gpu (needs the nodes array)" << std::endl;
+	settingsStream << L"# Set " << NAMEOF(octreeBuildMode) << L" to 0 for the top down builder or 1 for the Morton code radix sort builder" << std::endl;
+	settingsStream << L"# Set " << NAMEOF(useBottomUpAggregation) << L" to 1 in order to compute the inner node properties from their children (faster, approximates the clustering)" << std::endl;
+	settingsStream << L"# Point clouds that need more than " << NAMEOF(octreeMemoryBudget) << L" megabytes for the octree generation are built with temporary files" << std::endl;
+	settingsStream << L"# While loading a point cloud the first " << NAMEOF(previewVertexCount) << L" vertices are shown as a preview, set to 0 to disable the preview" << std::endl;
+	settingsStream << L"# " << NAMEOF(useLargePages) << L" backs the scratch arena blocks of the octree build with large pages, the nodes and vertex arrays always use regular pages, requires the lock pages in memory privilege" << std::endl;
+	settingsStream << L"# " << NAMEOF(verifyOctreeFiles) << L" reads the whole .octree file on every open and checks the child indices and the nodes checksum, otherwise the child indices are only checked once per file" << std::endl;
+	settingsStream << L"# " << NAMEOF(compressOctreeFiles) << L" writes smaller .octree files that are decompressed when loading instead of being mapped" << std::endl;
+	settingsStream << L"# " << NAMEOF(usePagedOctree) << L" only keeps the recently viewed pages of the octree in " << NAMEOF(octreePageCacheBudget) << L" megabytes, the cpu traversal is used then" << std::endl;
+	settingsStream << L"# " << NAMEOF(useSuccinctOctree) << L" computes the children indices from the children masks instead of storing them (less memory, slower cpu traversal)" << std::endl;
+	settingsStream << L"# The .octree files are cached by the .pointcloud content and the build parameters in " << NAMEOF(octreeCacheDirectory) << L" (empty for the Octrees folder next to the executable), it can be a shared folder" << std::endl;
 	settingsStream << NAMEOF(useOctree) << L"=" << useOctree << std::endl;
 	settingsStream << NAMEOF(useCulling) << L"=" << useCulling << std::endl;
 	settingsStream << NAMEOF(useGPUTraversal) << L"=" << useGPUTraversal << std::endl;
 	settingsStream << NAMEOF(maxOctreeDepth) << L"=" << maxOctreeDepth << std::endl;
+	settingsStream << NAMEOF(octreeBuildThreads) << L"=" << octreeBuildThreads << std::endl;
+	settingsStream << NAMEOF(octreeTraversalThreads) << L"=" << octreeTraversalThreads << std::endl;
+	settingsStream << NAMEOF(useIncrementalTraversal) << L"=" << useIncrementalTraversal << std::endl;
+	settingsStream << NAMEOF(useCPUTraversalEntries) << L"=" << useCPUTraversalEntries << std::endl;
+	settingsStream << NAMEOF(octreeBuildMode) << L"=" << (int)octreeBuildMode << std::endl;
+	settingsStream << NAMEOF(useBottomUpAggregation) << L"=" << useBottomUpAggregation << std::endl;
+	settingsStream << NAMEOF(octreeMemoryBudget) << L"=" << octreeMemoryBudget << std::endl;
+	settingsStream << NAMEOF(previewVertexCount) << L"=" << previewVertexCount << std::endl;
+	settingsStream << NAMEOF(useLargePages) << L"=" << useLargePages << std::endl;
+	settingsStream << NAMEOF(verifyOctreeFiles) << L"=" << verifyOctreeFiles << std::endl;
+	settingsStream << NAMEOF(compressOctreeFiles) << L"=" << compressOctreeFiles << std::endl;
+	settingsStream << NAMEOF(usePagedOctree) << L"=" << usePagedOctree << std::endl;
+	settingsStream << NAMEOF(octreePageCacheBudget) << L"=" << octreePageCacheBudget << std::endl;
+	settingsStream << NAMEOF(useSuccinctOctree) << L"=" << useSuccinctOctree << std::endl;
+	settingsStream << NAMEOF(octreeCacheDirectory) << L"=" << octreeCacheDirectory << std::endl;
 	settingsStream << NAMEOF(overlapFactor) << L"=" << overlapFactor << std::endl;
 	settingsStream << NAMEOF(splatResolution) << L"=" << splatResolution << std::endl;
 	settingsStream << NAMEOF(appendBufferCount) << L"=" << appendBufferCount << std::endl;
@@ -240,3 +291,33 @@ Vector4 PointCloudEngine::Settings::ToVector4(std::wstring s)
 
 	return Vector4(std::stof(x), std::stof(y), std::stof(z), std::stof(w));
 }
+
+PointCloudEngine::OctreeBuildParameters PointCloudEngine::Settings::GetOctreeBuildParameters()
+{
+	OctreeBuildParameters buildParameters;
+	buildParameters.buildMode = octreeBuildMode;
+	buildParameters.useBottomUpAggregation = useBottomUpAggregation;
+	buildParameters.maxDepth = maxOctreeDepth;
+	buildParameters.threadCount = octreeBuildThreads;
+	buildParameters.traversalThreadCount = octreeTraversalThreads;
+	buildParameters.useIncrementalTraversal = useIncrementalTraversal;
+	buildParameters.memoryBudget = octreeMemoryBudget;
+	buildParameters.compress = compressOctreeFiles;
+	buildParameters.usePaged = usePagedOctree;
+	buildParameters.pageCacheBudget = octreePageCacheBudget;
+	buildParameters.useSuccinct = useSuccinctOctree;
+	buildParameters.fileRead = GetFileReadParameters();
+
+	return buildParameters;
+}
+
+PointCloudEngine::FileReadParameters PointCloudEngine::Settings::GetFileReadParameters()
+{
+	FileReadParameters fileReadParameters;
+	fileReadParameters.threadCount = fileReadThreads;
+	fileReadParameters.unbuffered = useUnbufferedReads;
+	fileReadParameters.backendType = fileReadBackend;
+	fileReadParameters.verifyOctreeFiles = verifyOctreeFiles;
+
+	return fileReadParameters;
+}
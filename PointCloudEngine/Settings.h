@@ -19,6 +19,10 @@ namespace PointCloudEngine
 		Vector3 ToVector3(std::wstring s);
 		Vector4 ToVector4(std::wstring s);
 
+		// Copy of the current octree settings, only call this on the main thread
+		OctreeBuildParameters GetOctreeBuildParameters();
+		FileReadParameters GetFileReadParameters();
+
         // Rendering parameters default values
 		ViewMode viewMode = ViewMode::Points;
 		Vector4 backgroundColor = Vector4(0, 0, 0, 0);
@@ -33,6 +37,9 @@ namespace PointCloudEngine
         std::wstring pointcloudFile = L"";
 		float samplingRate = 0.01f;
 		float scale = 1.0f;
+		UINT fileReadThreads = 8;
+		bool useUnbufferedReads = false;
+		FileReadBackendType fileReadBackend = FileReadBackendType::Overlapped;
 
 		// Lighting parameters
 		bool useLighting = true;
@@ -81,6 +88,21 @@ namespace PointCloudEngine
 		bool useGPUTraversal = true;
 		int octreeLevel = -1;
 		int maxOctreeDepth = 16;
+		UINT octreeBuildThreads = 0;
+		UINT octreeTraversalThreads = 0;
+		bool useIncrementalTraversal = false;
+		bool useCPUTraversalEntries = false;
+		OctreeBuildMode octreeBuildMode = OctreeBuildMode::TopDown;
+		bool useBottomUpAggregation = false;
+		UINT octreeMemoryBudget = 8192;
+		UINT previewVertexCount = 1000000;
+		bool useLargePages = false;
+		bool verifyOctreeFiles = false;
+		bool compressOctreeFiles = false;
+		bool usePagedOctree = false;
+		UINT octreePageCacheBudget = 1024;
+		bool useSuccinctOctree = false;
+		std::wstring octreeCacheDirectory = L"";
 		float overlapFactor = 2.0f;
 		float splatResolution = 0.01f;
 		UINT appendBufferCount = 6000000;
@@ -128,6 +150,14 @@ namespace PointCloudEngine
 				{
 					*((ViewMode*)outParameterValue) = (ViewMode)std::stoi(settingsMap[parameterName]);
 				}
+				else if (typeid(T) == typeid(OctreeBuildMode))
+				{
+					*((OctreeBuildMode*)outParameterValue) = (OctreeBuildMode)std::stoi(settingsMap[parameterName]);
+				}
+				else if (typeid(T) == typeid(FileReadBackendType))
+				{
+					*((FileReadBackendType*)outParameterValue) = (FileReadBackendType)std::stoi(settingsMap[parameterName]);
+				}
 				else
 				{
 					ERROR_MESSAGE(NAMEOF(TryParse) + L" cannot parse " + parameterName + L" because its type is unknown!");
@@ -17,7 +17,6 @@ namespace PointCloudEngine
         void Release ();
 
         static D3D11_INPUT_ELEMENT_DESC textLayout[];
-        static D3D11_INPUT_ELEMENT_DESC splatLayout[];
         static D3D11_INPUT_ELEMENT_DESC octreeLayout[];
 		static D3D11_INPUT_ELEMENT_DESC waypointLayout[];
 
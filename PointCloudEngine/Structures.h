@@ -26,6 +26,21 @@ namespace PointCloudEngine
             data = data | g << 4;
             data = data | b;
         }
+
+		// Channels in [0, 255], the same values as the shaders decode (times 255)
+		Vector3 GetColor() const
+		{
+			return Vector3((float)DecodeTables::GetSixBitChannel(data >> 10), (float)DecodeTables::GetSixBitChannel((data >> 4) & 0x3f), (float)DecodeTables::GetFourBitChannel(data & 0xf));
+		}
+
+		// Decodes many colors at once, e.g. of all the nodes that are exported or drawn on the cpu
+		static void Decode(const Color16 *colors, size_t count, Vector3 *outColors)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				outColors[i] = colors[i].GetColor();
+			}
+		}
     };
 
     struct ClusterNormal
@@ -64,29 +79,30 @@ namespace PointCloudEngine
 			thetaPhiCone |= cone;
         }
 
-        Vector3 GetVector3()
+		// The empty normal is decoded to (0, 0, 0)
+        Vector3 GetVector3() const
         {
-			USHORT theta = thetaPhiCone >> 10;
-			USHORT phi = (thetaPhiCone & 0x3f0) >> 4;
-
-			// Check if this represents the empty normal (0, 0, 0)
-			if (theta == 0 && phi == 0)
-			{
-				return Vector3(0, 0, 0);
-			}
-
-            float t = XM_PI * (theta / 63.0f);
-            float p = XM_PI * ((phi / 31.5f) - 1.0f);
+			return DecodeTables::GetNormal(thetaPhiCone >> 4);
+        }
 
-			Vector3 normal(sin(t) * cos(p), sin(t) * sin(p), cos(t));
-			normal.Normalize();
+		float GetCone() const
+		{
+			return DecodeTables::GetCone(thetaPhiCone & 0xf);
+		}
 
-            return normal;
-        }
+		float GetConeSine() const
+		{
+			return DecodeTables::GetConeSine(thetaPhiCone & 0xf);
+		}
 
-		float GetCone()
+		// Decodes the normals and cones of many cluster normals at once, e.g. of all the nodes that are exported or drawn on the cpu
+		static void Decode(const ClusterNormal *clusterNormals, size_t count, Vector3 *outNormals, float *outCones)
 		{
-			return XM_PI * ((thetaPhiCone & 0xf) / 15.0f);
+			for (size_t i = 0; i < count; i++)
+			{
+				outNormals[i] = DecodeTables::GetNormal(clusterNormals[i].thetaPhiCone >> 4);
+				outCones[i] = DecodeTables::GetCone(clusterNormals[i].thetaPhiCone & 0xf);
+			}
 		}
     };
 
@@ -98,6 +114,45 @@ namespace PointCloudEngine
         byte color[3];
     };
 
+	struct PointcloudVertex
+	{
+		// Stores the .pointcloud vertices as they are written in the file
+		Vector3 position;
+		char normal[3];
+		unsigned char color[3];
+
+		PointcloudVertex()
+		{
+			// Default constructor used for parsing from file
+		}
+
+		PointcloudVertex(const Vertex &vertex)
+		{
+			position = vertex.position;
+			normal[0] = round(127 * max(-1.0f, min(1.0f, vertex.normal.x)));
+			normal[1] = round(127 * max(-1.0f, min(1.0f, vertex.normal.y)));
+			normal[2] = round(127 * max(-1.0f, min(1.0f, vertex.normal.z)));
+			color[0] = vertex.color[0];
+			color[1] = vertex.color[1];
+			color[2] = vertex.color[2];
+		}
+
+		// Converts to the vertex format of the octree generation
+		Vertex GetVertex() const
+		{
+			Vertex vertex;
+			vertex.position = position;
+			vertex.normal.x = normal[0] / 127.0f;
+			vertex.normal.y = normal[1] / 127.0f;
+			vertex.normal.z = normal[2] / 127.0f;
+			vertex.color[0] = color[0];
+			vertex.color[1] = color[1];
+			vertex.color[2] = color[2];
+
+			return vertex;
+		}
+	};
+
 	struct OctreeNodeProperties
 	{
 		// Mask where the lowest 8 bit store one bit for each of the children: 1 when it exists, 0 when it doesn't
@@ -125,12 +180,22 @@ namespace PointCloudEngine
         float size;
     };
 
+	// Unquantized cluster properties of a node, the clusters of a parent can be aggregated from the clusters of its children
+	struct OctreeNodeClusters
+	{
+		// Normalized mean normal, normal cone (largest angle in radians to a normal in the cluster), average color and vertex count of each cluster
+		Vector3 normals[4];
+		float cones[4];
+		double colors[4][3];
+		UINT counts[4];
+	};
+
     // Stores all the data that is needed to create octree nodes
     struct OctreeNodeCreationEntry
     {
-        UINT nodesIndex;
-		UINT childrenIndex;
-        std::vector<Vertex> vertices;
+        // Range of the vertices of this node in the shared vertices array (the vertices are partitioned in place)
+        UINT vertexStart;
+        UINT vertexCount;
         Vector3 position;
         float size;
         int depth;
@@ -139,10 +204,10 @@ namespace PointCloudEngine
 	// Stores all the data that is needed to traverse the octree
 	struct OctreeNodeTraversalEntry
 	{
-		UINT index;
+		UINT index;						// Same layout as the hlsl entry (uint), 32 bit like the children start indices, see OctreeNode::maxNodeCount
 		Vector3 position;
 		float size;
-		int parentInsideViewFrustum;	// Its used like a bool but stored as an int because the shader can only read 32bit values
+		int parentInsidePlanes;			// Bit mask of the view frustum planes that the parent is fully inside (see FrustumCuller), the gpu traversal only uses none or all of them
 		int depth;
 	};
 
@@ -200,6 +265,127 @@ namespace PointCloudEngine
 		UINT inputCount;
 	};
 
+	// Timing, memory usage and heap allocations of an octree build
+	struct OctreeBuildStatistics
+	{
+		UINT64 vertexCount = 0;
+		UINT64 nodeCount = 0;
+		double seconds = 0;
+		size_t memoryUsage = 0;
+		size_t peakMemoryUsage = 0;
+		UINT64 allocationCount = 0;
+
+		// Set by Benchmark::StartBuildStatistics
+		std::chrono::steady_clock::time_point start;
+	};
+
+	// Settings of the parallel file reads, copied from the settings on the main thread together with the build parameters
+	struct FileReadParameters
+	{
+		UINT threadCount = 8;
+		bool unbuffered = false;
+		FileReadBackendType backendType = FileReadBackendType::Overlapped;
+
+		// Reads the whole .octree file on every open and checks the child indices and the nodes checksum
+		bool verifyOctreeFiles = false;
+	};
+
+	// Settings that change how an octree is loaded or built, copied from the settings on the main thread
+	// The GUI can change the settings while the octree is loaded in the background, the loading thread only reads this copy
+	struct OctreeBuildParameters
+	{
+		OctreeBuildMode buildMode = OctreeBuildMode::TopDown;
+		bool useBottomUpAggregation = false;
+		int maxDepth = 16;
+		UINT threadCount = 0;
+		UINT traversalThreadCount = 0;
+		bool useIncrementalTraversal = false;
+		UINT memoryBudget = 8192;
+		bool compress = false;
+		bool usePaged = false;
+		UINT pageCacheBudget = 1024;
+		bool useSuccinct = false;
+		FileReadParameters fileRead;
+	};
+
+	// Header of the version 2 .octree files, the nodes follow at the nodes offset which is aligned to the page size
+	// The byte order field is written as 0x01020304 in the order of the writing machine
+	// Compressed files store a table of chunks at the nodes offset instead, each chunk stores up to chunkNodeCount nodes
+	struct OctreeFileHeader
+	{
+		char magic[8];
+		UINT version;
+		UINT byteOrder;
+		UINT headerSize;
+		UINT nodeSize;
+		UINT64 nodeCount;
+		UINT64 nodesOffset;
+		Vector3 rootPosition;
+		float rootSize;
+		UINT encoding;
+		UINT chunkNodeCount;
+
+		// Checksum of the uncompressed nodes
+		UINT64 nodesChecksum;
+
+		// Checksum of all the fields above
+		UINT64 headerChecksum;
+	};
+
+	// Position and compressed size of one chunk in a compressed .octree file
+	struct OctreeFileChunk
+	{
+		UINT64 offset;
+		UINT64 size;
+	};
+
+	struct OctreeBuildProgress
+	{
+		// Written by the threads that load or build the octree in the background and read by the main thread
+		// Nodes deeper than the last level are counted in the last level
+		static const int maxLevelCount = 32;
+
+		std::atomic<bool> canceled;
+		std::atomic<UINT64> vertexCount;
+		std::atomic<UINT64> loadedVertexCount;
+		std::atomic<UINT64> partitionedVertexCount;
+		std::atomic<UINT64> loadedNodeCount;
+		std::atomic<UINT64> levelNodeCounts[maxLevelCount];
+
+		OctreeBuildProgress()
+		{
+			Reset();
+		}
+
+		void Reset()
+		{
+			canceled = false;
+			vertexCount = 0;
+			loadedVertexCount = 0;
+			partitionedVertexCount = 0;
+			loadedNodeCount = 0;
+
+			for (int i = 0; i < maxLevelCount; i++)
+			{
+				levelNodeCounts[i] = 0;
+			}
+		}
+
+		void AddNodes(int depth, UINT64 count)
+		{
+			levelNodeCounts[min(depth, maxLevelCount - 1)] += count;
+		}
+
+		// Called between the steps of the octree generation, the partial results are discarded
+		void ThrowIfCanceled()
+		{
+			if (canceled)
+			{
+				throw std::exception("Octree generation canceled!");
+			}
+		}
+	};
+
 	struct LightingConstantBuffer
 	{
 		int useLighting;			// Bool in the shader
@@ -0,0 +1,186 @@
+#include "ThreadPool.h"
+
+thread_local ThreadPool* ThreadPool::currentThreadPool = NULL;
+thread_local UINT ThreadPool::currentQueueIndex = 0;
+
+PointCloudEngine::ThreadPool::ThreadPool(UINT threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = max(1u, std::thread::hardware_concurrency());
+	}
+
+	pendingTasks = 0;
+	queuedTasks = 0;
+	running = true;
+
+	// One queue for each worker and an additional one for all the other threads that submit tasks
+	for (UINT i = 0; i <= threadCount; i++)
+	{
+		queues.push_back(new TaskQueue());
+	}
+
+	for (UINT i = 0; i < threadCount; i++)
+	{
+		threads.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+	}
+}
+
+PointCloudEngine::ThreadPool::~ThreadPool()
+{
+	// Throwing from the destructor would terminate the process, an exception that was not rethrown by Wait is dropped
+	RunPendingTasks();
+	firstException = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+
+	sleepCondition.notify_all();
+
+	for (auto it = threads.begin(); it != threads.end(); it++)
+	{
+		it->join();
+	}
+
+	for (auto it = queues.begin(); it != queues.end(); it++)
+	{
+		SafeDelete(*it);
+	}
+}
+
+void PointCloudEngine::ThreadPool::Submit(std::function<void()> task)
+{
+	TaskQueue* queue = queues[GetQueueIndex()];
+
+	pendingTasks++;
+
+	// Count the task before it can be taken, changing the counter under the sleep mutex makes sure that a sleeping worker cannot miss it
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedTasks++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->tasks.push_back(task);
+	}
+
+	sleepCondition.notify_one();
+}
+
+void PointCloudEngine::ThreadPool::Wait()
+{
+	RunPendingTasks();
+
+	if (firstException != NULL)
+	{
+		std::exception_ptr exception = firstException;
+		firstException = NULL;
+		std::rethrow_exception(exception);
+	}
+}
+
+void PointCloudEngine::ThreadPool::RunPendingTasks()
+{
+	UINT queueIndex = GetQueueIndex();
+
+	// Help with the work instead of only waiting for the workers
+	while (pendingTasks > 0)
+	{
+		if (!TryRunTask(queueIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+UINT PointCloudEngine::ThreadPool::GetThreadCount() const
+{
+	return threads.size();
+}
+
+void PointCloudEngine::ThreadPool::WorkerLoop(UINT queueIndex)
+{
+	currentThreadPool = this;
+	currentQueueIndex = queueIndex;
+
+	while (running)
+	{
+		if (!TryRunTask(queueIndex))
+		{
+			// Sleep until new work is submitted, tasks that are already running do not wake up the idle workers
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleepCondition.wait(lock, [&] { return !running || (queuedTasks > 0); });
+		}
+	}
+}
+
+bool PointCloudEngine::ThreadPool::TryRunTask(UINT queueIndex)
+{
+	std::function<void()> task;
+	bool found = false;
+
+	// Take the newest task from the own queue first
+	{
+		TaskQueue* queue = queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+
+		if (!queue->tasks.empty())
+		{
+			task = std::move(queue->tasks.back());
+			queue->tasks.pop_back();
+			found = true;
+		}
+	}
+
+	// Otherwise steal the oldest task from one of the other queues
+	for (UINT i = 1; !found && (i < queues.size()); i++)
+	{
+		TaskQueue* queue = queues[(queueIndex + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+
+		if (!queue->tasks.empty())
+		{
+			task = std::move(queue->tasks.front());
+			queue->tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (found)
+	{
+		queuedTasks--;
+
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			// Keep the first exception and rethrow it in the waiting thread
+			std::lock_guard<std::mutex> lock(sleepMutex);
+
+			if (firstException == NULL)
+			{
+				firstException = std::current_exception();
+			}
+		}
+
+		pendingTasks--;
+	}
+
+	return found;
+}
+
+UINT PointCloudEngine::ThreadPool::GetQueueIndex() const
+{
+	// Workers of this pool use their own queue, every other thread uses the last queue
+	if (currentThreadPool == this)
+	{
+		return currentQueueIndex;
+	}
+
+	return queues.size() - 1;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+	// Work stealing thread pool, each worker owns a task queue and takes its newest tasks first (depth first, cache friendly)
+	// Idle workers steal the oldest tasks from the other queues (these are usually the largest remaining pieces of work)
+	class ThreadPool
+	{
+	public:
+		// A thread count of 0 uses all the hardware threads
+		ThreadPool(UINT threadCount = 0);
+		~ThreadPool();
+
+		// Can be called from any thread, also from inside a task to spawn more tasks
+		void Submit(std::function<void()> task);
+
+		// Blocks until all submitted tasks (and the tasks they spawned) are completed, the calling thread helps executing tasks
+		void Wait();
+
+		UINT GetThreadCount() const;
+
+		// Each worker has its own queue index, all the other threads share the last index (equal to GetThreadCount)
+		// Data indexed by the queue index is never accessed concurrently as long as only one other thread uses the pool
+		UINT GetQueueIndex() const;
+
+	private:
+		struct TaskQueue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		// Index of the task queue of the current thread, the last queue is shared by all threads that are not workers of this pool
+		static thread_local ThreadPool* currentThreadPool;
+		static thread_local UINT currentQueueIndex;
+
+		std::vector<std::thread> threads;
+		std::vector<TaskQueue*> queues;
+		std::atomic<size_t> pendingTasks;
+		// Tasks that are submitted but not taken from a queue yet, only increased while holding the sleep mutex
+		std::atomic<size_t> queuedTasks;
+		std::atomic<bool> running;
+		std::exception_ptr firstException = NULL;
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+
+		void WorkerLoop(UINT queueIndex);
+		// Waits for all the tasks like Wait but never throws, the first exception stays stored
+		void RunPendingTasks();
+		bool TryRunTask(UINT queueIndex);
+	};
+}
+#endif
\ No newline at end of file